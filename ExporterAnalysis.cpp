@@ -0,0 +1,169 @@
+#include "ExporterAnalysis.h"
+#include "ExporterBVH.h"
+#include "ExporterParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace {
+using DVec3 = std::array<double, 3>;
+
+DVec3 ToDouble(const Vec3 &v) { return {v[0], v[1], v[2]}; }
+DVec3 Sub(const DVec3 &a, const DVec3 &b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+double DotD(const DVec3 &a, const DVec3 &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+DVec3 CrossD(const DVec3 &a, const DVec3 &b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+// Signed distances of the corners of `tri` to the plane through `plane`, snapped to zero within eps.
+bool PlaneDistances(const DVec3 plane[3], const DVec3 tri[3], double eps, DVec3 &n, double d[3]) {
+  n = CrossD(Sub(plane[1], plane[0]), Sub(plane[2], plane[0]));
+  double len = std::sqrt(DotD(n, n));
+  if (len == 0.0)
+	return false;
+  for (auto &c : n)
+	c /= len;
+  for (int i = 0; i < 3; ++i) {
+	d[i] = DotD(n, Sub(tri[i], plane[0]));
+	if (std::fabs(d[i]) < eps)
+	  d[i] = 0.0;
+  }
+  return true;
+}
+
+// Interval of a triangle on the line where both planes meet; p are the vertex projections onto the
+// line, d the signed distances to the other plane. Returns false when the triangle is coplanar.
+bool LineInterval(const double p[3], const double d[3], double &t0, double &t1) {
+  auto isect = [&](int lone, int a, int b) {
+	t0 = p[lone] + (p[a] - p[lone]) * d[lone] / (d[lone] - d[a]);
+	t1 = p[lone] + (p[b] - p[lone]) * d[lone] / (d[lone] - d[b]);
+	if (t0 > t1)
+	  std::swap(t0, t1);
+  };
+  if (d[0] * d[1] > 0.0)
+	isect(2, 0, 1);
+  else if (d[0] * d[2] > 0.0)
+	isect(1, 0, 2);
+  else if (d[1] * d[2] > 0.0 || d[0] != 0.0)
+	isect(0, 1, 2);
+  else if (d[1] != 0.0)
+	isect(1, 0, 2);
+  else if (d[2] != 0.0)
+	isect(2, 0, 1);
+  else
+	return false;
+  return true;
+}
+
+bool Straddles(const double d[3]) {
+  return (d[0] > 0 || d[1] > 0 || d[2] > 0) && (d[0] < 0 || d[1] < 0 || d[2] < 0);
+}
+
+// Moller's interval overlap test, restricted to pairs that pierce each other: both triangles must
+// have corners strictly on either side of the other's plane. Pairs that merely touch, or that are
+// coplanar, are adjacent faces of a closed tessellation rather than crossings.
+bool TrianglesCross(const DVec3 a[3], const DVec3 b[3], double eps) {
+  DVec3 nb, na;
+  double da[3], db[3];
+  if (!PlaneDistances(b, a, eps, nb, da) || !Straddles(da))
+	return false;
+  if (!PlaneDistances(a, b, eps, na, db) || !Straddles(db))
+	return false;
+
+  DVec3 dir = CrossD(na, nb);
+  int axis = 0;
+  for (int i = 1; i < 3; ++i)
+	if (std::fabs(dir[i]) > std::fabs(dir[axis]))
+	  axis = i;
+  double pa[3] = {a[0][axis], a[1][axis], a[2][axis]};
+  double pb[3] = {b[0][axis], b[1][axis], b[2][axis]};
+  double a0, a1, b0, b1;
+  if (!LineInterval(pa, da, a0, a1) || !LineInterval(pb, db, b0, b1))
+	return false;
+  return std::min(a1, b1) - std::max(a0, b0) > eps;
+}
+
+void CheckWallThickness(const Mesh &mesh, const MeshBVH &bvh, float threshold, float offset, AnalysisResult &result) {
+  std::mutex lock;
+  ParallelFor(mesh.TriangleCount(), 4096, [&](size_t begin, size_t end) {
+	double thin = 0.0, total = 0.0;
+	float minimum = result.minimumWallThickness;
+	for (size_t t = begin; t < end; ++t) {
+	  float area = mesh.TriangleArea(t);
+	  total += area;
+	  Vec3 n = mesh.FaceNormal(t);
+	  if (area == 0.0f)
+		continue;
+	  Vec3 centroid = (mesh.Corner(t, 0) + mesh.Corner(t, 1) + mesh.Corner(t, 2)) * (1.0f / 3.0f);
+	  Vec3 inward = n * -1.0f;
+	  MeshBVH::Hit hit;
+	  if (!bvh.Raycast(centroid + inward * offset, inward, threshold, static_cast<uint32_t>(t), hit))
+		continue;
+	  // Only exits through the opposite wall count; hitting a front face means nested shells.
+	  if (Dot(mesh.FaceNormal(hit.triangle), inward) <= 0.0f)
+		continue;
+	  float thickness = hit.t + offset;
+	  thin += area;
+	  minimum = std::min(minimum, thickness);
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	result.thinArea += thin;
+	result.totalArea += total;
+	result.minimumWallThickness = std::min(result.minimumWallThickness, minimum);
+  });
+}
+
+size_t CountSelfIntersections(const Mesh &mesh, const MeshBVH &bvh, double eps, size_t limit) {
+  std::atomic<size_t> found{0};
+  ParallelFor(mesh.TriangleCount(), 2048, [&](size_t begin, size_t end) {
+	for (size_t t = begin; t < end && found.load(std::memory_order_relaxed) < limit; ++t) {
+	  const uint32_t *ia = &mesh.indices[3 * t];
+	  DVec3 a[3] = {ToDouble(mesh.Corner(t, 0)), ToDouble(mesh.Corner(t, 1)), ToDouble(mesh.Corner(t, 2))};
+	  BoundingBox box;
+	  for (int i = 0; i < 3; ++i)
+		box.Extend(mesh.Corner(t, i));
+	  size_t local = 0;
+	  bvh.ForEachOverlap(box, [&](uint32_t other) {
+		if (other <= t)
+		  return;
+		const uint32_t *ib = &mesh.indices[3 * size_t{other}];
+		for (int i = 0; i < 3; ++i)
+		  for (int j = 0; j < 3; ++j)
+			if (ia[i] == ib[j])
+			  return;
+		DVec3 b[3] = {ToDouble(mesh.Corner(other, 0)), ToDouble(mesh.Corner(other, 1)), ToDouble(mesh.Corner(other, 2))};
+		if (TrianglesCross(a, b, eps))
+		  ++local;
+	  });
+	  if (local)
+		found.fetch_add(local, std::memory_order_relaxed);
+	}
+  });
+  return std::min(found.load(), limit);
+}
+}
+
+bool IsAnalysisEnabled(const AnalysisOptions &options) {
+  return options.minimumWallThickness > 0.0f || options.checkSelfIntersections;
+}
+
+AnalysisResult AnalyzeMesh(const Mesh &source, const AnalysisOptions &options) {
+  AnalysisResult result;
+  result.triangleCount = source.TriangleCount();
+  if (source.Empty() || !IsAnalysisEnabled(options))
+	return result;
+
+  Mesh mesh = source;
+  WeldVertices(mesh);
+  MeshBVH bvh(mesh);
+  Vec3 size = bvh.Bounds().Size();
+  const float diagonal = std::sqrt(Dot(size, size));
+
+  if (options.minimumWallThickness > 0.0f)
+	CheckWallThickness(mesh, bvh, options.minimumWallThickness, diagonal * 1e-6f, result);
+  if (options.checkSelfIntersections)
+	result.selfIntersections = CountSelfIntersections(mesh, bvh, diagonal * 1e-7, options.maxSelfIntersections);
+  return result;
+}
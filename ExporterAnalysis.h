@@ -0,0 +1,34 @@
+#ifndef STLHELPER__EXPORTERANALYSIS_H_
+#define STLHELPER__EXPORTERANALYSIS_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <cstddef>
+#include <limits>
+
+struct AnalysisOptions {
+  float minimumWallThickness{0.0f}; // centimeters, zero disables the thickness check
+  bool checkSelfIntersections{false};
+  size_t maxSelfIntersections{1000}; // stop counting once this many pairs were found
+};
+
+struct AnalysisResult {
+  size_t triangleCount{0};
+  float minimumWallThickness{std::numeric_limits<float>::max()}; // smallest wall below the threshold
+  double thinArea{0.0}; // surface area whose inward ray hits the opposite wall below the threshold
+  double totalArea{0.0};
+  size_t selfIntersections{0};
+
+  bool IsThin() const { return thinArea > 0.0; }
+  bool IsFlagged() const { return IsThin() || selfIntersections > 0; }
+};
+
+bool IsAnalysisEnabled(const AnalysisOptions &options);
+
+// Builds a BVH over `mesh` and runs the enabled checks on all worker threads. Wall thickness is
+// sampled by casting a ray from every facet centroid along the inward normal; self-intersections
+// are reported for triangle pairs that cross without sharing a vertex.
+AnalysisResult AnalyzeMesh(const Mesh &mesh, const AnalysisOptions &options);
+
+#endif //STLHELPER__EXPORTERANALYSIS_H_
@@ -0,0 +1,341 @@
+#include "ExporterBVH.h"
+#include "ExporterParallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+
+namespace {
+constexpr int kBinCount = 16;
+// Subtrees larger than this are built on their own thread.
+constexpr uint32_t kParallelBuildThreshold = 1u << 16;
+constexpr int kMaxParallelDepth = 6;
+// Beyond this depth nodes are split at the median, which bounds the tree (and traversal stack) depth.
+constexpr int kMaxSahDepth = 48;
+
+struct Bin {
+  BoundingBox bounds;
+  uint32_t count{0};
+};
+
+float BoxDistanceSquared(const BoundingBox &box, const Vec3 &p) {
+  float d = 0.0f;
+  for (int a = 0; a < 3; ++a) {
+	const float outside = std::max({box.min[a] - p[a], 0.0f, p[a] - box.max[a]});
+	d += outside * outside;
+  }
+  return d;
+}
+
+float LengthSquared(const Vec3 &v) {
+  return Dot(v, v);
+}
+
+// Squared distance from `p` to the triangle a, a + ab, a + ac, by the Voronoi regions of its
+// vertices, edges and face.
+float TriangleDistanceSquared(const Vec3 &p, const Vec3 &a, const Vec3 &ab, const Vec3 &ac) {
+  const Vec3 ap = p - a;
+  const float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f)
+	return LengthSquared(ap);
+  const Vec3 bp = ap - ab;
+  const float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3)
+	return LengthSquared(bp);
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	return LengthSquared(ap - ab * (d1 / (d1 - d3)));
+  const Vec3 cp = ap - ac;
+  const float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6)
+	return LengthSquared(cp);
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	return LengthSquared(ap - ac * (d2 / (d2 - d6)));
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+	return LengthSquared(bp - (ac - ab) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+  const float sum = va + vb + vc;
+  if (!(sum > 0.0f)) // degenerate: one of the cases above is as close as it gets
+	return std::min({LengthSquared(ap), LengthSquared(bp), LengthSquared(cp)});
+  return LengthSquared(ap - ab * (vb / sum) - ac * (vc / sum));
+}
+}
+
+MeshBVH::MeshBVH(const Mesh &mesh) {
+  const uint32_t count = static_cast<uint32_t>(mesh.TriangleCount());
+  if (count == 0)
+	return;
+
+  m_refs.resize(count);
+  ParallelFor(count, 1 << 14, [&](size_t begin, size_t end) {
+	for (size_t t = begin; t < end; ++t) {
+	  BuildRef &ref = m_refs[t];
+	  ref.bounds = {};
+	  ref.bounds.Extend(mesh.Corner(t, 0));
+	  ref.bounds.Extend(mesh.Corner(t, 1));
+	  ref.bounds.Extend(mesh.Corner(t, 2));
+	  ref.triangle = static_cast<uint32_t>(t);
+	}
+  });
+
+  BoundingBox bounds, centroidBounds;
+  for (const auto &ref : m_refs) {
+	bounds.Extend(ref.bounds);
+	centroidBounds.Extend(ref.bounds.min + ref.bounds.max);
+  }
+  m_nodes.resize(2 * size_t{count});
+  m_nodesUsed = 1;
+  Build(0, 0, count, 0, bounds, centroidBounds);
+  m_nodes.resize(m_nodesUsed);
+
+  // Gather each leaf's triangles into a packet; unused lanes stay degenerate and never report a hit.
+  for (auto &node : m_nodes) {
+	if (node.count == 0)
+	  continue;
+	Packet p{};
+	for (int k = 0; k < kPacketWidth; ++k)
+	  p.triangle[k] = kNoTriangle;
+	for (uint32_t k = 0; k < node.count; ++k) {
+	  uint32_t t = m_refs[node.first + k].triangle;
+	  Vec3 v0 = mesh.Corner(t, 0);
+	  Vec3 e1 = mesh.Corner(t, 1) - v0;
+	  Vec3 e2 = mesh.Corner(t, 2) - v0;
+	  for (int a = 0; a < 3; ++a) {
+		p.v0[a][k] = v0[a];
+		p.e1[a][k] = e1[a];
+		p.e2[a][k] = e2[a];
+	  }
+	  p.triangle[k] = t;
+	}
+	node.first = static_cast<uint32_t>(m_packets.size());
+	m_packets.push_back(p);
+  }
+  m_refs = {};
+}
+
+void MeshBVH::Build(uint32_t nodeIndex, uint32_t start, uint32_t count, int depth,
+					const BoundingBox &bounds, const BoundingBox &centroidBounds) {
+  // Centroids are kept doubled (min + max) to save a multiply per triangle.
+  Node &node = m_nodes[nodeIndex];
+  BuildRef *refs = m_refs.data() + start;
+  node.bounds = bounds;
+  if (count <= static_cast<uint32_t>(kPacketWidth)) {
+	node.first = start;
+	node.count = count;
+	return;
+  }
+
+  // Binned SAH along the widest centroid axis; evaluating all three costs triple the binning passes
+  // for a marginal gain in tree quality.
+  const Vec3 extent = centroidBounds.Size();
+  const int axis = extent[0] >= extent[1] ? (extent[0] >= extent[2] ? 0 : 2) : (extent[1] >= extent[2] ? 1 : 2);
+  const float scale = extent[axis] > 0.0f ? kBinCount / extent[axis] : 0.0f;
+  const float lo = centroidBounds.min[axis];
+  auto binOf = [&](const BuildRef &ref) {
+	return std::min(kBinCount - 1, static_cast<int>((ref.bounds.min[axis] + ref.bounds.max[axis] - lo) * scale));
+  };
+  int bestSplit = 0;
+  if (depth < kMaxSahDepth && extent[axis] > 0.0f) {
+	Bin bins[kBinCount];
+	for (uint32_t i = 0; i < count; ++i) {
+	  Bin &bin = bins[binOf(refs[i])];
+	  bin.count++;
+	  bin.bounds.Extend(refs[i].bounds);
+	}
+	float rightArea[kBinCount];
+	uint32_t rightCount[kBinCount];
+	BoundingBox acc;
+	uint32_t accCount = 0;
+	for (int b = kBinCount - 1; b > 0; --b) {
+	  acc.Extend(bins[b].bounds);
+	  accCount += bins[b].count;
+	  rightArea[b] = acc.SurfaceArea();
+	  rightCount[b] = accCount;
+	}
+	acc = {};
+	accCount = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	for (int b = 0; b < kBinCount - 1; ++b) {
+	  acc.Extend(bins[b].bounds);
+	  accCount += bins[b].count;
+	  if (accCount == 0 || rightCount[b + 1] == 0)
+		continue;
+	  float cost = acc.SurfaceArea() * accCount + rightArea[b + 1] * rightCount[b + 1];
+	  if (cost < bestCost) {
+		bestCost = cost;
+		bestSplit = b + 1;
+	  }
+	}
+  }
+
+  // Partition and gather the children's bounds in the same pass.
+  uint32_t leftCount = 0;
+  BoundingBox leftBounds, leftCentroids, rightBounds, rightCentroids;
+  if (bestSplit > 0) {
+	uint32_t end = count;
+	while (leftCount < end) {
+	  if (binOf(refs[leftCount]) < bestSplit) {
+		leftBounds.Extend(refs[leftCount].bounds);
+		leftCentroids.Extend(refs[leftCount].bounds.min + refs[leftCount].bounds.max);
+		++leftCount;
+	  } else {
+		std::swap(refs[leftCount], refs[--end]);
+		rightBounds.Extend(refs[end].bounds);
+		rightCentroids.Extend(refs[end].bounds.min + refs[end].bounds.max);
+	  }
+	}
+  }
+  if (leftCount == 0 || leftCount == count) {
+	// Coincident centroids or depth limit: fall back to a median split.
+	leftCount = count / 2;
+	std::nth_element(refs, refs + leftCount, refs + count, [axis](const BuildRef &a, const BuildRef &b) {
+	  return a.bounds.min[axis] + a.bounds.max[axis] < b.bounds.min[axis] + b.bounds.max[axis];
+	});
+	leftBounds = leftCentroids = rightBounds = rightCentroids = {};
+	for (uint32_t i = 0; i < count; ++i) {
+	  (i < leftCount ? leftBounds : rightBounds).Extend(refs[i].bounds);
+	  (i < leftCount ? leftCentroids : rightCentroids).Extend(refs[i].bounds.min + refs[i].bounds.max);
+	}
+  }
+
+  const uint32_t left = m_nodesUsed.fetch_add(2);
+  node.first = left;
+  node.count = 0;
+  if (count > kParallelBuildThreshold && depth < kMaxParallelDepth) {
+	auto task = std::async(std::launch::async, [&, left]() {
+	  Build(left, start, leftCount, depth + 1, leftBounds, leftCentroids);
+	});
+	Build(left + 1, start + leftCount, count - leftCount, depth + 1, rightBounds, rightCentroids);
+	task.get();
+  } else {
+	Build(left, start, leftCount, depth + 1, leftBounds, leftCentroids);
+	Build(left + 1, start + leftCount, count - leftCount, depth + 1, rightBounds, rightCentroids);
+  }
+}
+
+bool MeshBVH::Raycast(const Vec3 &origin, const Vec3 &direction, float tMax, uint32_t ignore, Hit &hit) const {
+  if (m_nodes.empty())
+	return false;
+  Vec3 inv;
+  for (int a = 0; a < 3; ++a)
+	inv[a] = direction[a] != 0.0f ? 1.0f / direction[a] : std::numeric_limits<float>::max();
+
+  auto slab = [&](const BoundingBox &b, float limit) {
+	float t0 = 0.0f, t1 = limit;
+	for (int a = 0; a < 3; ++a) {
+	  float n = (b.min[a] - origin[a]) * inv[a];
+	  float f = (b.max[a] - origin[a]) * inv[a];
+	  t0 = std::max(t0, std::min(n, f));
+	  t1 = std::min(t1, std::max(n, f));
+	}
+	return t0 <= t1 ? t0 : std::numeric_limits<float>::max();
+  };
+
+  float best = tMax;
+  uint32_t bestTriangle = kNoTriangle;
+  uint32_t stack[kMaxStack];
+  int top = 0;
+  if (slab(m_nodes[0].bounds, best) == std::numeric_limits<float>::max())
+	return false;
+  stack[top++] = 0;
+  while (top > 0) {
+	const Node &node = m_nodes[stack[--top]];
+	if (node.count > 0) {
+	  // Moller-Trumbore on all lanes; written branch-free so the loop vectorizes.
+	  const Packet &p = m_packets[node.first];
+	  float laneT[kPacketWidth];
+	  for (int k = 0; k < kPacketWidth; ++k) {
+		float px = direction[1] * p.e2[2][k] - direction[2] * p.e2[1][k];
+		float py = direction[2] * p.e2[0][k] - direction[0] * p.e2[2][k];
+		float pz = direction[0] * p.e2[1][k] - direction[1] * p.e2[0][k];
+		float det = p.e1[0][k] * px + p.e1[1][k] * py + p.e1[2][k] * pz;
+		float invDet = det != 0.0f ? 1.0f / det : 0.0f;
+		float tx = origin[0] - p.v0[0][k], ty = origin[1] - p.v0[1][k], tz = origin[2] - p.v0[2][k];
+		float u = (tx * px + ty * py + tz * pz) * invDet;
+		float qx = ty * p.e1[2][k] - tz * p.e1[1][k];
+		float qy = tz * p.e1[0][k] - tx * p.e1[2][k];
+		float qz = tx * p.e1[1][k] - ty * p.e1[0][k];
+		float v = (direction[0] * qx + direction[1] * qy + direction[2] * qz) * invDet;
+		float t = (p.e2[0][k] * qx + p.e2[1][k] * qy + p.e2[2][k] * qz) * invDet;
+		bool valid = det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f;
+		laneT[k] = valid ? t : std::numeric_limits<float>::max();
+	  }
+	  for (int k = 0; k < kPacketWidth; ++k) {
+		if (laneT[k] < best && p.triangle[k] != ignore && p.triangle[k] != kNoTriangle) {
+		  best = laneT[k];
+		  bestTriangle = p.triangle[k];
+		}
+	  }
+	  continue;
+	}
+	float tl = slab(m_nodes[node.first].bounds, best);
+	float tr = slab(m_nodes[node.first + 1].bounds, best);
+	// push the farther child first so the nearer one is visited next
+	if (tl <= tr) {
+	  if (tr != std::numeric_limits<float>::max()) stack[top++] = node.first + 1;
+	  if (tl != std::numeric_limits<float>::max()) stack[top++] = node.first;
+	} else {
+	  if (tl != std::numeric_limits<float>::max()) stack[top++] = node.first;
+	  if (tr != std::numeric_limits<float>::max()) stack[top++] = node.first + 1;
+	}
+  }
+  if (bestTriangle == kNoTriangle)
+	return false;
+  hit.t = best;
+  hit.triangle = bestTriangle;
+  return true;
+}
+
+float MeshBVH::NearestDistanceSquared(const Vec3 &point, float enough, uint32_t *hint) const {
+  float best = std::numeric_limits<float>::max();
+  if (m_nodes.empty())
+	return best;
+  uint32_t bestLeaf = 0;
+  auto visitLeaf = [&](uint32_t index) {
+	const Node &node = m_nodes[index];
+	const Packet &p = m_packets[node.first];
+	for (uint32_t k = 0; k < node.count; ++k) {
+	  const Vec3 v0{p.v0[0][k], p.v0[1][k], p.v0[2][k]};
+	  const Vec3 e1{p.e1[0][k], p.e1[1][k], p.e1[2][k]};
+	  const Vec3 e2{p.e2[0][k], p.e2[1][k], p.e2[2][k]};
+	  const float d = TriangleDistanceSquared(point, v0, e1, e2);
+	  if (d < best) {
+		best = d;
+		bestLeaf = index;
+	  }
+	}
+  };
+  const bool hinted = hint && *hint < m_nodes.size() && m_nodes[*hint].count > 0;
+  if (hinted)
+	visitLeaf(*hint);
+
+  uint32_t stack[kMaxStack];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0 && best > enough) {
+	const uint32_t index = stack[--top];
+	const Node &node = m_nodes[index];
+	if (BoxDistanceSquared(node.bounds, point) >= best)
+	  continue;
+	if (node.count > 0) {
+	  if (!hinted || index != *hint)
+		visitLeaf(index);
+	  continue;
+	}
+	// push the farther child first so the nearer one is visited next
+	const float dl = BoxDistanceSquared(m_nodes[node.first].bounds, point);
+	const float dr = BoxDistanceSquared(m_nodes[node.first + 1].bounds, point);
+	if (dl <= dr) {
+	  stack[top++] = node.first + 1;
+	  stack[top++] = node.first;
+	} else {
+	  stack[top++] = node.first;
+	  stack[top++] = node.first + 1;
+	}
+  }
+  if (hint)
+	*hint = bestLeaf;
+  return best;
+}
@@ -0,0 +1,90 @@
+#ifndef STLHELPER__EXPORTERBVH_H_
+#define STLHELPER__EXPORTERBVH_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over the triangles of a Mesh, built with binned SAH. Leaves hold at most
+// kPacketWidth triangles stored as one structure-of-arrays packet so ray/triangle tests run on all
+// lanes at once and auto-vectorize on both SSE and NEON.
+class MeshBVH {
+ public:
+  static constexpr int kPacketWidth = 4;
+  static constexpr uint32_t kNoTriangle = 0xFFFFFFFFu;
+  static constexpr int kMaxStack = 128;
+
+  struct Hit {
+	float t{0.0f};
+	uint32_t triangle{kNoTriangle};
+  };
+
+  explicit MeshBVH(const Mesh &mesh);
+
+  BoundingBox Bounds() const { return m_nodes.empty() ? BoundingBox{} : m_nodes[0].bounds; }
+
+  // Closest intersection with t in (0, tMax), skipping `ignore`. Returns false if nothing was hit.
+  bool Raycast(const Vec3 &origin, const Vec3 &direction, float tMax, uint32_t ignore, Hit &hit) const;
+
+  // Squared distance from `point` to the nearest triangle, or the float maximum if there are none.
+  // The search stops at the first triangle no farther than the square root of `enough`, for callers
+  // that only need to know whether the distance exceeds a bound. `hint`, if given, names a leaf to
+  // try first and receives the leaf of the result, so queries walking along a surface mostly end
+  // in the leaf the previous one found.
+  float NearestDistanceSquared(const Vec3 &point, float enough = 0.0f, uint32_t *hint = nullptr) const;
+
+  // Calls fn(triangle) for every triangle whose leaf bounds overlap `box`.
+  template<typename Fn>
+  void ForEachOverlap(const BoundingBox &box, Fn &&fn) const {
+	if (m_nodes.empty())
+	  return;
+	uint32_t stack[kMaxStack];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+	  const Node &node = m_nodes[stack[--top]];
+	  if (!node.bounds.Overlaps(box))
+		continue;
+	  if (node.count > 0) {
+		const Packet &p = m_packets[node.first];
+		for (uint32_t k = 0; k < node.count; ++k)
+		  fn(p.triangle[k]);
+	  } else {
+		stack[top++] = node.first;
+		stack[top++] = node.first + 1;
+	  }
+	}
+  }
+
+ private:
+  struct Node {
+	BoundingBox bounds;
+	uint32_t first{0}; // inner: index of the left child (right is first + 1); leaf: packet index
+	uint32_t count{0}; // number of triangles in a leaf, zero for inner nodes
+  };
+  struct Packet {
+	float v0[3][kPacketWidth];
+	float e1[3][kPacketWidth];
+	float e2[3][kPacketWidth];
+	uint32_t triangle[kPacketWidth];
+  };
+
+  void Build(uint32_t nodeIndex, uint32_t start, uint32_t count, int depth,
+			 const BoundingBox &bounds, const BoundingBox &centroidBounds);
+
+  std::vector<Node> m_nodes;
+  std::vector<Packet> m_packets;
+
+  // build-time scratch: triangle bounds partitioned in place, so each subtree's range is contiguous
+  struct BuildRef {
+	BoundingBox bounds;
+	uint32_t triangle;
+  };
+  std::vector<BuildRef> m_refs;
+  std::atomic<uint32_t> m_nodesUsed{0};
+};
+
+#endif //STLHELPER__EXPORTERBVH_H_
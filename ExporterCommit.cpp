@@ -0,0 +1,175 @@
+#include "ExporterCommit.h"
+#include "ExporterPlatform.h"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+
+namespace {
+const char *const kTempSuffix = ".stlexporter-tmp";
+
+// Links `destination` to `object` through a temporary name, so the old destination is replaced
+// atomically just like a written file.
+bool LinkOrCopy(const fs::path &object, const fs::path &destination) {
+  std::error_code error;
+  if (fs::equivalent(object, destination, error))
+	return true; // already linked by an earlier export
+  const fs::path temp = FileCommitter::TempPathFor(destination);
+  error.clear();
+  fs::create_hard_link(object, temp, error);
+  if (error) {
+	// other volume, a file system without links or a link limit reached
+	error.clear();
+	fs::copy_file(object, temp, error);
+	if (error || !syncPath(temp)) {
+	  std::error_code ignored;
+	  fs::remove(temp, ignored);
+	  return false;
+	}
+  }
+  if (!replaceFile(temp, destination)) {
+	std::error_code ignored;
+	fs::remove(temp, ignored);
+	return false;
+  }
+  return true;
+}
+}
+
+// The destination's extension stays last: Fusion's STL export appends ".stl" to any other name.
+fs::path FileCommitter::TempPathFor(const fs::path &destination) {
+  static std::atomic<uint64_t> counter{0};
+  static const uint64_t session =
+	  static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  std::string name = ".";
+  name += destination.filename().string();
+  name += ".";
+  name += std::to_string(session % 1000000);
+  name += "-";
+  name += std::to_string(counter.fetch_add(1));
+  name += kTempSuffix;
+  name += destination.extension().string();
+  return destination.parent_path() / name;
+}
+
+void FileCommitter::RemoveStaleTemps(const fs::path &folder) {
+  std::error_code error;
+  const std::string suffix = kTempSuffix;
+  for (fs::directory_iterator it(folder, error), end; !error && it != end; it.increment(error)) {
+	const std::string name = it->path().filename().string();
+	if (name.empty() || name[0] != '.')
+	  continue;
+	// the suffix followed by nothing or by a single extension
+	const size_t at = name.rfind(suffix);
+	if (at == std::string::npos || at == 0)
+	  continue;
+	const std::string rest = name.substr(at + suffix.size());
+	if (rest.empty() || (rest[0] == '.' && rest.find('.', 1) == std::string::npos)) {
+	  std::error_code ignored;
+	  fs::remove(it->path(), ignored);
+	}
+  }
+}
+
+void FileCommitter::Add(const fs::path &temp, const fs::path &destination, Committed committed) {
+  Queue({temp, destination, false, std::move(committed)});
+}
+
+void FileCommitter::Link(const fs::path &object, const fs::path &destination, Committed committed) {
+  Queue({object, destination, true, std::move(committed)});
+}
+
+void FileCommitter::Queue(Entry entry) {
+  Pending batch;
+  uint64_t ticket;
+  {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pending.push_back(std::move(entry));
+	if (m_pending.size() < kBatchSize)
+	  return;
+	batch.swap(m_pending);
+	ticket = m_batchesQueued++;
+  }
+  CommitInTurn(batch, ticket);
+}
+
+std::vector<std::string> FileCommitter::Commit() {
+  Pending batch;
+  uint64_t ticket;
+  {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	batch.swap(m_pending);
+	ticket = m_batchesQueued++;
+  }
+  CommitInTurn(batch, ticket);
+  std::lock_guard<std::mutex> lock(m_commitMutex);
+  std::vector<std::string> failed;
+  failed.swap(m_failed);
+  return failed;
+}
+
+uint64_t FileCommitter::BytesCommitted() {
+  std::lock_guard<std::mutex> lock(m_commitMutex);
+  return m_bytes;
+}
+
+void FileCommitter::CommitInTurn(const Pending &batch, uint64_t ticket) {
+  // Batches commit in the order they were queued, so a link never precedes its stored file.
+  std::unique_lock<std::mutex> lock(m_commitMutex);
+  m_turn.wait(lock, [&] { return m_batchesCommitted == ticket; });
+  if (!batch.empty())
+	CommitBatch(batch);
+  ++m_batchesCommitted;
+  m_turn.notify_all();
+}
+
+void FileCommitter::CommitBatch(const Pending &batch) {
+  std::set<fs::path> folders;
+  for (auto &&entry : batch)
+	folders.insert(entry.destination.parent_path());
+
+  // Contents must be on the device before the renames, or a crash could leave renamed but empty
+  // files behind.
+#ifdef __linux__
+  for (auto &&folder : folders)
+	syncFileSystem(folder);
+#else
+  for (auto &&entry : batch) {
+	if (!entry.link)
+	  syncPath(entry.source);
+  }
+#endif
+
+  std::vector<std::pair<const Entry *, uint64_t>> done; // committed entries and their sizes
+  for (auto &&entry : batch) {
+	if (entry.link)
+	  continue;
+	std::error_code error;
+	const uint64_t size = fs::file_size(entry.source, error);
+	if (replaceFile(entry.source, entry.destination)) {
+	  m_bytes += error ? 0 : size;
+	  done.emplace_back(&entry, error ? 0 : size);
+	} else {
+	  fs::remove(entry.source, error);
+	  m_failed.push_back(entry.destination.string());
+	}
+  }
+  for (auto &&entry : batch) {
+	if (!entry.link)
+	  continue;
+	std::error_code error;
+	const uint64_t size = fs::file_size(entry.source, error);
+	if (LinkOrCopy(entry.source, entry.destination))
+	  done.emplace_back(&entry, error ? 0 : size);
+	else
+	  m_failed.push_back(entry.destination.string());
+  }
+  for (auto &&folder : folders)
+	syncFolder(folder);
+
+  // only now is every output of the batch sure to survive a crash
+  for (auto &&[entry, size] : done) {
+	if (entry->committed)
+	  entry->committed(size);
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef STLHELPER__EXPORTERCOMMIT_H_
+#define STLHELPER__EXPORTERCOMMIT_H_
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Puts finished outputs in place atomically. Every output is first written to a temporary file
+// next to its destination; committing syncs a whole batch of them, renames each over its
+// destination and then syncs every touched folder once. A crash or a full disk therefore leaves
+// either the old file or the complete new one, never a truncated STL, and durability costs one
+// sync round per batch rather than one per file. Outputs kept in a content store are committed
+// once under their store name and then linked to each destination.
+class FileCommitter {
+ public:
+  static constexpr size_t kBatchSize = 64;
+
+  // Called with the size of an output once it is durably in place.
+  using Committed = std::function<void(uint64_t size)>;
+
+  FileCommitter() = default;
+  FileCommitter(const FileCommitter &) = delete;
+  FileCommitter &operator=(const FileCommitter &) = delete;
+
+  // A unique temporary name in the folder of `destination`.
+  static std::filesystem::path TempPathFor(const std::filesystem::path &destination);
+
+  // Deletes temporary files a crashed run left in `folder`.
+  static void RemoveStaleTemps(const std::filesystem::path &folder);
+
+  // Queues a fully written `temp` for `destination`; commits the batch once it is full. Safe to call
+  // from writer threads. `committed` runs after the folder sync of the batch that renamed it.
+  void Add(const std::filesystem::path &temp,
+		   const std::filesystem::path &destination,
+		   Committed committed = nullptr);
+
+  // Queues `destination` to become a hard link to `object`, or a copy of it where the file system
+  // cannot link. Links are made after the renames of their batch, so `object` may be a destination
+  // queued with Add before. `committed` runs like it does for Add.
+  void Link(const std::filesystem::path &object,
+			const std::filesystem::path &destination,
+			Committed committed = nullptr);
+
+  // Commits everything still queued. Returns the destinations that could not be committed since
+  // the previous call.
+  std::vector<std::string> Commit();
+
+  // Bytes of all files renamed into place so far; linked files are not counted.
+  uint64_t BytesCommitted();
+
+ private:
+  struct Entry {
+	std::filesystem::path source; // temporary file, or the stored file for links
+	std::filesystem::path destination;
+	bool link{false};
+	Committed committed;
+  };
+  using Pending = std::vector<Entry>;
+  void Queue(Entry entry);
+  void CommitInTurn(const Pending &batch, uint64_t ticket);
+  void CommitBatch(const Pending &batch); // with m_commitMutex held
+
+  std::mutex m_mutex;
+  Pending m_pending;
+  uint64_t m_batchesQueued{0};
+  std::mutex m_commitMutex;
+  std::condition_variable m_turn;
+  uint64_t m_batchesCommitted{0}; // guarded by m_commitMutex, like m_failed and m_bytes
+  uint64_t m_bytes{0};
+  std::vector<std::string> m_failed;
+};
+
+#endif //STLHELPER__EXPORTERCOMMIT_H_
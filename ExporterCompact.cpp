@@ -0,0 +1,391 @@
+#include "ExporterCompact.h"
+#include "ExporterHash.h"
+#include "ExporterIO.h"
+#include "ExporterMorton.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace {
+const char kMagic[4] = {'S', 'E', 'C', 'M'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr uint32_t kMaxCount = 1u << 28; // guards allocations against corrupt headers
+
+// Adaptive binary range coder in the style of LZMA: 11 bit probabilities, shift-5 adaptation.
+constexpr int kProbabilityBits = 11;
+constexpr uint16_t kHalf = 1 << (kProbabilityBits - 1);
+constexpr int kAdaptShift = 5;
+constexpr uint32_t kTop = 1u << 24;
+
+class RangeEncoder {
+ public:
+  explicit RangeEncoder(std::vector<uint8_t> &out) : m_out(out) {}
+
+  void Bit(uint16_t &probability, uint32_t bit) {
+	const uint32_t bound = (m_range >> kProbabilityBits) * probability;
+	if (bit == 0) {
+	  m_range = bound;
+	  probability += ((1 << kProbabilityBits) - probability) >> kAdaptShift;
+	} else {
+	  m_low += bound;
+	  m_range -= bound;
+	  probability -= probability >> kAdaptShift;
+	}
+	Normalize();
+  }
+
+  void Direct(uint32_t value, int bits) {
+	for (int i = bits - 1; i >= 0; --i) {
+	  m_range >>= 1;
+	  if ((value >> i) & 1)
+		m_low += m_range;
+	  Normalize();
+	}
+  }
+
+  void Flush() {
+	for (int i = 0; i < 5; ++i)
+	  ShiftLow();
+  }
+
+ private:
+  void Normalize() {
+	while (m_range < kTop) {
+	  m_range <<= 8;
+	  ShiftLow();
+	}
+  }
+
+  void ShiftLow() {
+	if (static_cast<uint32_t>(m_low) < 0xFF000000u || (m_low >> 32) != 0) {
+	  const uint8_t carry = static_cast<uint8_t>(m_low >> 32);
+	  uint8_t pending = m_cache;
+	  do {
+		m_out.push_back(static_cast<uint8_t>(pending + carry));
+		pending = 0xFF;
+	  } while (--m_cacheSize != 0);
+	  m_cache = static_cast<uint8_t>(m_low >> 24);
+	}
+	++m_cacheSize;
+	m_low = (m_low & 0x00FFFFFFu) << 8;
+  }
+
+  std::vector<uint8_t> &m_out;
+  uint64_t m_low{0};
+  uint32_t m_range{0xFFFFFFFFu};
+  uint8_t m_cache{0};
+  uint64_t m_cacheSize{1};
+};
+
+class RangeDecoder {
+ public:
+  RangeDecoder(const uint8_t *data, size_t size) : m_data(data), m_end(data + size) {
+	for (int i = 0; i < 5; ++i)
+	  m_code = (m_code << 8) | Next();
+  }
+
+  uint32_t Bit(uint16_t &probability) {
+	const uint32_t bound = (m_range >> kProbabilityBits) * probability;
+	uint32_t bit;
+	if (m_code < bound) {
+	  m_range = bound;
+	  probability += ((1 << kProbabilityBits) - probability) >> kAdaptShift;
+	  bit = 0;
+	} else {
+	  m_code -= bound;
+	  m_range -= bound;
+	  probability -= probability >> kAdaptShift;
+	  bit = 1;
+	}
+	Normalize();
+	return bit;
+  }
+
+  uint32_t Direct(int bits) {
+	uint32_t value = 0;
+	for (int i = 0; i < bits; ++i) {
+	  m_range >>= 1;
+	  uint32_t bit = m_code >= m_range ? 1 : 0;
+	  m_code -= m_range & (0u - bit);
+	  value = (value << 1) | bit;
+	  Normalize();
+	}
+	return value;
+  }
+
+  // True once the decoder needed bytes past the end of the data.
+  bool Overrun() const { return m_overrun > 0; }
+
+ private:
+  void Normalize() {
+	while (m_range < kTop) {
+	  m_range <<= 8;
+	  m_code = (m_code << 8) | Next();
+	}
+  }
+
+  uint8_t Next() {
+	if (m_data < m_end)
+	  return *m_data++;
+	++m_overrun; // the encoder's flush writes every byte the decoder reads, so this is truncation
+	return 0;
+  }
+
+  const uint8_t *m_data;
+  const uint8_t *m_end;
+  uint32_t m_code{0};
+  uint32_t m_range{0xFFFFFFFFu};
+  size_t m_overrun{0};
+};
+
+// Numbers are coded as their bit length through an adaptive 6 level bit tree, then the two bits
+// below the leading one with adaptive probabilities per length, then the remaining bits as is.
+constexpr int kLengthBits = 6;
+constexpr int kModelledBits = 2;
+
+struct NumberModel {
+  uint16_t length[1 << kLengthBits];
+  uint16_t high[33][1 << kModelledBits];
+
+  NumberModel() {
+	std::fill(std::begin(length), std::end(length), kHalf);
+	for (auto &h : high)
+	  std::fill(std::begin(h), std::end(h), kHalf);
+  }
+
+  void Encode(RangeEncoder &coder, uint32_t value) {
+	const int n = std::bit_width(value);
+	uint32_t node = 1;
+	for (int i = kLengthBits - 1; i >= 0; --i) {
+	  const uint32_t bit = (n >> i) & 1;
+	  coder.Bit(length[node], bit);
+	  node = (node << 1) | bit;
+	}
+	if (n <= 1)
+	  return;
+	const int modelled = std::min(n - 1, kModelledBits);
+	node = 1;
+	for (int i = 0; i < modelled; ++i) {
+	  const uint32_t bit = (value >> (n - 2 - i)) & 1;
+	  coder.Bit(high[n][node], bit);
+	  node = (node << 1) | bit;
+	}
+	const int rest = n - 1 - modelled;
+	if (rest > 0)
+	  coder.Direct(value & ((1u << rest) - 1), rest);
+  }
+
+  bool Decode(RangeDecoder &coder, uint32_t &value) {
+	uint32_t node = 1;
+	for (int i = 0; i < kLengthBits; ++i)
+	  node = (node << 1) | coder.Bit(length[node]);
+	const int n = static_cast<int>(node - (1u << kLengthBits));
+	if (n > 32)
+	  return false;
+	if (n <= 1) {
+	  value = static_cast<uint32_t>(n);
+	  return true;
+	}
+	const int modelled = std::min(n - 1, kModelledBits);
+	value = 1;
+	node = 1;
+	for (int i = 0; i < modelled; ++i) {
+	  const uint32_t bit = coder.Bit(high[n][node]);
+	  node = (node << 1) | bit;
+	  value = (value << 1) | bit;
+	}
+	const int rest = n - 1 - modelled;
+	if (rest > 0)
+	  value = (value << rest) | coder.Direct(rest);
+	return true;
+  }
+};
+
+uint32_t ZigZag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+int32_t UnZigZag(uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+
+// Shared by encoder and decoder so both predict from the same state.
+struct Models {
+  NumberModel reference; // 0 for a new vertex, otherwise how far back the vertex was introduced
+  NumberModel delta[3][3]; // [corner][axis]
+};
+
+void PutU32(uint8_t *out, uint32_t v) { std::memcpy(out, &v, sizeof(v)); }
+void PutF32(uint8_t *out, float v) { std::memcpy(out, &v, sizeof(v)); }
+uint32_t GetU32(const uint8_t *in) {
+  uint32_t v;
+  std::memcpy(&v, in, sizeof(v));
+  return v;
+}
+float GetF32(const uint8_t *in) {
+  float v;
+  std::memcpy(&v, in, sizeof(v));
+  return v;
+}
+
+// The predicted position of a vertex first used by corner `corner`: the previous corner of the same
+// triangle, or the last new vertex for the first corner.
+const int32_t *Prediction(const int32_t (&corners)[3][3], int corner, const int32_t *last) {
+  return corner == 0 ? last : corners[corner - 1];
+}
+}
+
+bool EncodeCompactMesh(const Mesh &mesh, float scale, int bits, std::vector<uint8_t> &out, STLSummary *summary) {
+  bits = std::clamp(bits, kMinCompactBits, kMaxCompactBits);
+  if (mesh.TriangleCount() >= kMaxCount || mesh.VertexCount() >= kMaxCount)
+	return false;
+
+  BoundingBox box;
+  for (uint32_t v = 0; v < mesh.VertexCount(); ++v)
+	box.Extend(mesh.Vertex(v) * scale);
+  const Vec3 size = box.Size();
+  const float longest = std::max(size[0], std::max(size[1], size[2]));
+  const uint32_t maxCell = (1u << bits) - 1;
+  const float step = longest > 0.0f ? longest / static_cast<float>(maxCell) : 1.0f;
+  const Vec3 origin = box.IsEmpty() ? Vec3{0, 0, 0} : box.min;
+
+  // Grid coordinates are small integers, exact in a float, so the mesh tools work on them directly.
+  Mesh grid;
+  grid.indices = mesh.indices;
+  grid.positions.resize(mesh.positions.size());
+  for (size_t i = 0; i < mesh.positions.size(); ++i) {
+	const float cell = std::round((mesh.positions[i] * scale - origin[i % 3]) / step);
+	grid.positions[i] = std::clamp(cell, 0.0f, static_cast<float>(maxCell));
+  }
+  WeldVertices(grid);
+  // also numbers the vertices in order of first use; encoding runs on a writer thread
+  SortTrianglesByMorton(grid, Parallelism::Serial);
+
+  out.assign(kHeaderSize, 0);
+  std::memcpy(out.data(), kMagic, sizeof(kMagic));
+  out[4] = kVersion;
+  out[5] = static_cast<uint8_t>(bits);
+  PutU32(&out[8], static_cast<uint32_t>(grid.VertexCount()));
+  PutU32(&out[12], static_cast<uint32_t>(grid.TriangleCount()));
+  for (int a = 0; a < 3; ++a)
+	PutF32(&out[16 + 4 * a], origin[a]);
+  PutF32(&out[28], step);
+
+  auto models = std::make_unique<Models>();
+  RangeEncoder coder(out);
+  uint32_t next = 0;
+  int32_t last[3] = {0, 0, 0};
+  int32_t corners[3][3];
+  for (size_t t = 0; t < grid.TriangleCount(); ++t) {
+	for (int c = 0; c < 3; ++c) {
+	  const uint32_t v = grid.indices[3 * t + c];
+	  for (int a = 0; a < 3; ++a)
+		corners[c][a] = static_cast<int32_t>(grid.positions[3 * size_t{v} + a]);
+	  if (v != next) {
+		models->reference.Encode(coder, next - v);
+		continue;
+	  }
+	  models->reference.Encode(coder, 0);
+	  const int32_t *predicted = Prediction(corners, c, last);
+	  for (int a = 0; a < 3; ++a)
+		models->delta[c][a].Encode(coder, ZigZag(corners[c][a] - predicted[a]));
+	  std::copy(corners[c], corners[c] + 3, last);
+	  ++next;
+	}
+  }
+  coder.Flush();
+
+  if (summary) {
+	BoundingBox decoded;
+	for (uint32_t v = 0; v < grid.VertexCount(); ++v) {
+	  const Vec3 cell = grid.Vertex(v);
+	  decoded.Extend(Vec3{origin[0] + cell[0] * step, origin[1] + cell[1] * step, origin[2] + cell[2] * step});
+	}
+	StreamHash hash;
+	hash.Update(out.data(), out.size());
+	summary->triangles = grid.TriangleCount();
+	summary->bounds = decoded;
+	summary->contentHash = hash.Value();
+  }
+  return true;
+}
+
+bool DecodeCompactMesh(const uint8_t *data, size_t size, Mesh &mesh) {
+  mesh.Clear();
+  if (size < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || data[4] != kVersion)
+	return false;
+  const int bits = data[5];
+  const uint32_t vertices = GetU32(data + 8);
+  const uint32_t triangles = GetU32(data + 12);
+  if (bits < kMinCompactBits || bits > kMaxCompactBits || vertices >= kMaxCount || triangles >= kMaxCount)
+	return false;
+  const Vec3 origin{GetF32(data + 16), GetF32(data + 20), GetF32(data + 24)};
+  const float step = GetF32(data + 28);
+  const int32_t maxCell = (1 << bits) - 1;
+
+  mesh.positions.reserve(3 * size_t{vertices});
+  mesh.indices.resize(3 * size_t{triangles});
+  std::vector<int32_t> cells;
+  cells.reserve(3 * size_t{vertices});
+
+  auto models = std::make_unique<Models>();
+  RangeDecoder coder(data + kHeaderSize, size - kHeaderSize);
+  uint32_t next = 0;
+  int32_t last[3] = {0, 0, 0};
+  int32_t corners[3][3];
+  for (size_t t = 0; t < triangles; ++t) {
+	for (int c = 0; c < 3; ++c) {
+	  uint32_t back;
+	  if (!models->reference.Decode(coder, back) || back > next)
+		return false;
+	  if (back > 0) {
+		const uint32_t v = next - back;
+		std::copy(&cells[3 * size_t{v}], &cells[3 * size_t{v}] + 3, corners[c]);
+		mesh.indices[3 * t + c] = v;
+		continue;
+	  }
+	  if (next >= vertices)
+		return false;
+	  const int32_t *predicted = Prediction(corners, c, last);
+	  for (int a = 0; a < 3; ++a) {
+		uint32_t delta;
+		if (!models->delta[c][a].Decode(coder, delta))
+		  return false;
+		corners[c][a] = predicted[a] + UnZigZag(delta);
+		if (corners[c][a] < 0 || corners[c][a] > maxCell)
+		  return false;
+	  }
+	  cells.insert(cells.end(), corners[c], corners[c] + 3);
+	  for (int a = 0; a < 3; ++a)
+		mesh.positions.push_back(origin[a] + static_cast<float>(corners[c][a]) * step);
+	  std::copy(corners[c], corners[c] + 3, last);
+	  mesh.indices[3 * t + c] = next++;
+	}
+	if (coder.Overrun())
+	  return false;
+  }
+  return next == vertices;
+}
+
+bool WriteCompactMesh(const Mesh &mesh, const std::filesystem::path &path, float scale, int bits, STLSummary *summary) {
+  std::vector<uint8_t> data;
+  if (!EncodeCompactMesh(mesh, scale, bits, data, summary))
+	return false;
+  OutputFile file;
+  if (!file.Open(path, data.size()))
+	return false;
+  file.Write(data.data(), data.size());
+  return file.Close();
+}
+
+bool ReadCompactMesh(const std::filesystem::path &path, Mesh &mesh, uint64_t *contentHash) {
+  MappedFile file;
+  if (!file.Open(path))
+	return false;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(file.Data());
+  if (contentHash) {
+	StreamHash hash;
+	hash.Update(data, file.Size());
+	*contentHash = hash.Value();
+  }
+  return data && DecodeCompactMesh(data, file.Size(), mesh);
+}
@@ -0,0 +1,168 @@
+#include "ExporterDiff.h"
+#include "ExporterParallel.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+
+namespace {
+constexpr int kMaxSamplesPerEdge = 16; // bounds the work on very long triangles
+constexpr size_t kTrianglesPerBlock = 256;
+constexpr size_t kVerticesPerBlock = 1024;
+
+std::string Quoted(const std::string &text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+	if (c == '"')
+	  quoted += '"';
+	quoted += c;
+  }
+  return quoted + "\"";
+}
+
+const char *StatusName(BodyChange::Status status) {
+  switch (status) {
+	case BodyChange::Status::Added: return "added";
+	case BodyChange::Status::Changed: return "changed";
+	case BodyChange::Status::Unchanged: return "unchanged";
+  }
+  return "";
+}
+}
+
+SurfaceDistance DirectedHausdorff(const Mesh &from, const MeshBVH &to, float spacing, float resolution) {
+  const float floor = resolution * resolution;
+  // Squared maximum so far, shared so every block can skip samples that cannot raise it.
+  std::atomic<float> shared{0.0f};
+  std::mutex mutex;
+  SurfaceDistance result;
+  auto publish = [&](float worst, const Vec3 &where) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (worst > shared.load(std::memory_order_relaxed)) {
+	  shared.store(worst, std::memory_order_relaxed);
+	  result.distance = std::sqrt(worst);
+	  result.where = where;
+	}
+  };
+
+  // Vertices first, once each however many triangles share them. The distances kept are upper
+  // bounds: a search may stop early once it is clear the vertex cannot raise the maximum.
+  std::vector<float> vertexDistance(from.VertexCount());
+  ParallelFor(from.VertexCount(), kVerticesPerBlock, [&](size_t begin, size_t end) {
+	float worst = shared.load(std::memory_order_relaxed);
+	Vec3 where{};
+	bool found = false;
+	uint32_t hint = 0;
+	for (size_t v = begin; v < end; ++v) {
+	  const Vec3 p = from.Vertex(static_cast<uint32_t>(v));
+	  const float d = to.NearestDistanceSquared(p, std::max(worst, floor), &hint);
+	  vertexDistance[v] = std::sqrt(d);
+	  if (d > worst) {
+		worst = d;
+		where = p;
+		found = true;
+	  }
+	}
+	if (found)
+	  publish(worst, where);
+  });
+  if (!(spacing > 0.0f))
+	return result;
+
+  // Then a grid over each triangle larger than `spacing`. Distance changes no faster than position,
+  // so a sample r away from a corner at distance d is at most d + r away; samples whose bound cannot
+  // raise the maximum are skipped without a search.
+  ParallelFor(from.TriangleCount(), kTrianglesPerBlock, [&](size_t begin, size_t end) {
+	float worst = shared.load(std::memory_order_relaxed);
+	Vec3 where{};
+	bool found = false;
+	uint32_t hint = 0;
+	for (size_t t = begin; t < end; ++t) {
+	  const Vec3 corners[3] = {from.Corner(t, 0), from.Corner(t, 1), from.Corner(t, 2)};
+	  const Vec3 ab = corners[1] - corners[0], ac = corners[2] - corners[0];
+	  const float longest = std::sqrt(std::max({Dot(ab, ab), Dot(ac, ac), Dot(ac - ab, ac - ab)}));
+	  const int steps = std::min(static_cast<int>(std::ceil(longest / spacing)), kMaxSamplesPerEdge);
+	  if (steps <= 1)
+		continue;
+	  worst = std::max(worst, shared.load(std::memory_order_relaxed));
+	  float cornerDistance[3];
+	  for (int c = 0; c < 3; ++c)
+		cornerDistance[c] = vertexDistance[from.indices[3 * t + c]];
+	  const float step = 1.0f / static_cast<float>(steps);
+	  for (int i = 0; i < steps; ++i) {
+		for (int j = i == 0 ? 1 : 0; i + j <= steps; ++j) {
+		  if (i == 0 && j == steps)
+			continue; // a corner
+		  const Vec3 p = corners[0] + ab * (static_cast<float>(i) * step) + ac * (static_cast<float>(j) * step);
+		  float bound = std::numeric_limits<float>::max();
+		  for (int c = 0; c < 3; ++c) {
+			const Vec3 offset = p - corners[c];
+			bound = std::min(bound, cornerDistance[c] + std::sqrt(Dot(offset, offset)));
+		  }
+		  if (bound * bound <= std::max(worst, floor))
+			continue;
+		  const float d = to.NearestDistanceSquared(p, std::max(worst, floor), &hint);
+		  if (d > worst) {
+			worst = d;
+			where = p;
+			found = true;
+		  }
+		}
+	  }
+	}
+	if (found)
+	  publish(worst, where);
+  });
+  return result;
+}
+
+MeshDifference CompareMeshes(const Mesh &current, const Mesh &previous, float spacing, float resolution) {
+  MeshDifference difference;
+  if (current.Empty() || previous.Empty()) {
+	// nothing to measure against: the whole of the other surface is new or gone
+	const Mesh &present = current.Empty() ? previous : current;
+	const BoundingBox box = present.Bounds();
+	const Vec3 size = box.Size();
+	SurfaceDistance &side = current.Empty() ? difference.backward : difference.forward;
+	side.distance = std::sqrt(Dot(size, size));
+	side.where = box.IsEmpty() ? Vec3{0.0f, 0.0f, 0.0f} : box.min;
+	return difference;
+  }
+  if (spacing <= 0.0f) {
+	BoundingBox box = current.Bounds();
+	box.Extend(previous.Bounds());
+	const Vec3 size = box.Size();
+	spacing = std::sqrt(Dot(size, size)) / 512.0f;
+  }
+  {
+	const MeshBVH previousBVH(previous);
+	difference.forward = DirectedHausdorff(current, previousBVH, spacing, resolution);
+  }
+  const MeshBVH currentBVH(current);
+  difference.backward = DirectedHausdorff(previous, currentBVH, spacing, resolution);
+  return difference;
+}
+
+std::string FormatChangeReport(const std::vector<BodyChange> &changes) {
+  std::string report = "file,status,written,triangles,previous triangles,"
+					   "hausdorff mm,added mm,added at x,added at y,added at z,removed mm,removed at x,removed at y,removed at z\n";
+  char line[320];
+  for (auto &&change : changes) {
+	const SurfaceDistance &added = change.difference.forward, &removed = change.difference.backward;
+	report += Quoted(change.file);
+	if (change.status == BodyChange::Status::Added) {
+	  std::snprintf(line, sizeof(line), ",%s,%s,%zu,,,,,,,,,,\n", StatusName(change.status),
+					change.leftOut ? "no" : "yes", change.triangles);
+	} else {
+	  std::snprintf(line, sizeof(line), ",%s,%s,%zu,%zu,%.4f,%.4f,%.3f,%.3f,%.3f,%.4f,%.3f,%.3f,%.3f\n",
+					StatusName(change.status), change.leftOut ? "no" : "yes", change.triangles,
+					change.previousTriangles, change.difference.Hausdorff(), added.distance, added.where[0],
+					added.where[1], added.where[2], removed.distance, removed.where[0], removed.where[1],
+					removed.where[2]);
+	}
+	report += line;
+  }
+  return report;
+}
@@ -0,0 +1,52 @@
+#ifndef STLHELPER__EXPORTERDIFF_H_
+#define STLHELPER__EXPORTERDIFF_H_
+#pragma once
+
+#include "ExporterBVH.h"
+#include "ExporterMesh.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Largest distance from the points of one surface to another surface, and where it occurs.
+struct SurfaceDistance {
+  float distance{0.0f};
+  Vec3 where{0.0f, 0.0f, 0.0f}; // on the surface measured from
+};
+
+struct MeshDifference {
+  SurfaceDistance forward; // from the current mesh to the previous one: material that was added or moved
+  SurfaceDistance backward; // from the previous mesh to the current one: material that was removed or moved
+  float Hausdorff() const { return std::max(forward.distance, backward.distance); }
+};
+
+// One-sided Hausdorff distance from the surface of `from` to the surface indexed by `to`. Every
+// vertex is measured, and triangles longer than `spacing` are also sampled on a grid with points
+// about `spacing` apart (up to a fixed number per edge), so the result is exact within about that
+// spacing. Samples are measured on all worker threads, and those that provably cannot raise the
+// maximum are skipped. Vertices shared by triangles are measured once, so welded meshes are faster.
+// Distances up to `resolution` are not told apart, which lets searches stop at the first triangle
+// that close: a result at or below it only says the surfaces are at least that close.
+SurfaceDistance DirectedHausdorff(const Mesh &from, const MeshBVH &to, float spacing, float resolution = 0.0f);
+
+// Both one-sided distances between two meshes in the same units. `spacing` of zero picks
+// 1/512 of the combined bounding box diagonal.
+MeshDifference CompareMeshes(const Mesh &current, const Mesh &previous, float spacing = 0.0f, float resolution = 0.0f);
+
+// One body of a diff against the previous export.
+struct BodyChange {
+  enum class Status { Added, Changed, Unchanged };
+
+  std::string file; // name of the primary file
+  Status status{Status::Added};
+  size_t triangles{0};
+  size_t previousTriangles{0};
+  MeshDifference difference; // in millimeters
+  bool leftOut{false}; // the previous file was kept instead of writing a new one
+};
+
+// The changes as CSV with a header row, distances in millimeters.
+std::string FormatChangeReport(const std::vector<BodyChange> &changes);
+
+#endif //STLHELPER__EXPORTERDIFF_H_
@@ -0,0 +1,148 @@
+#include "ExporterHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+void StreamHash::Update(const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  m_length += size;
+  if (m_tailSize > 0) {
+	const size_t take = std::min(size, sizeof(m_tail) - m_tailSize);
+	std::memcpy(m_tail + m_tailSize, bytes, take);
+	m_tailSize += take;
+	bytes += take;
+	size -= take;
+	if (m_tailSize < sizeof(m_tail))
+	  return;
+	uint64_t word;
+	std::memcpy(&word, m_tail, sizeof(word));
+	Mix(word);
+	m_tailSize = 0;
+  }
+  for (; size >= sizeof(uint64_t); bytes += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+	uint64_t word;
+	std::memcpy(&word, bytes, sizeof(word)); // little-endian on every platform Fusion runs on
+	Mix(word);
+  }
+  std::memcpy(m_tail, bytes, size);
+  m_tailSize = size;
+}
+
+uint64_t StreamHash::Value() const {
+  StreamHash copy = *this;
+  uint64_t word = 0;
+  std::memcpy(&word, copy.m_tail, copy.m_tailSize);
+  copy.Mix(word);
+  copy.Mix(m_length);
+  uint64_t h = copy.m_state;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  return h;
+}
+
+namespace {
+constexpr uint32_t kRoundConstants[64] = {
+	0x428A2F98u, 0x71374491u, 0xB5C0FBCFu, 0xE9B5DBA5u, 0x3956C25Bu, 0x59F111F1u, 0x923F82A4u, 0xAB1C5ED5u,
+	0xD807AA98u, 0x12835B01u, 0x243185BEu, 0x550C7DC3u, 0x72BE5D74u, 0x80DEB1FEu, 0x9BDC06A7u, 0xC19BF174u,
+	0xE49B69C1u, 0xEFBE4786u, 0x0FC19DC6u, 0x240CA1CCu, 0x2DE92C6Fu, 0x4A7484AAu, 0x5CB0A9DCu, 0x76F988DAu,
+	0x983E5152u, 0xA831C66Du, 0xB00327C8u, 0xBF597FC7u, 0xC6E00BF3u, 0xD5A79147u, 0x06CA6351u, 0x14292967u,
+	0x27B70A85u, 0x2E1B2138u, 0x4D2C6DFCu, 0x53380D13u, 0x650A7354u, 0x766A0ABBu, 0x81C2C92Eu, 0x92722C85u,
+	0xA2BFE8A1u, 0xA81A664Bu, 0xC24B8B70u, 0xC76C51A3u, 0xD192E819u, 0xD6990624u, 0xF40E3585u, 0x106AA070u,
+	0x19A4C116u, 0x1E376C08u, 0x2748774Cu, 0x34B0BCB5u, 0x391C0CB3u, 0x4ED8AA4Au, 0x5B9CCA4Fu, 0x682E6FF3u,
+	0x748F82EEu, 0x78A5636Fu, 0x84C87814u, 0x8CC70208u, 0x90BEFFFAu, 0xA4506CEBu, 0xBEF9A3F7u, 0xC67178F2u};
+
+uint32_t RotateRight(uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+}
+
+void Sha256::Update(const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  m_length += size;
+  if (m_blockSize > 0) {
+	const size_t take = std::min(size, sizeof(m_block) - m_blockSize);
+	std::memcpy(m_block + m_blockSize, bytes, take);
+	m_blockSize += take;
+	bytes += take;
+	size -= take;
+	if (m_blockSize < sizeof(m_block))
+	  return;
+	Compress(m_block);
+	m_blockSize = 0;
+  }
+  for (; size >= sizeof(m_block); bytes += sizeof(m_block), size -= sizeof(m_block))
+	Compress(bytes);
+  std::memcpy(m_block, bytes, size);
+  m_blockSize = size;
+}
+
+Sha256::Digest Sha256::Value() const {
+  Sha256 copy = *this;
+  const uint64_t bits = m_length * 8;
+  const unsigned char one = 0x80, zero = 0;
+  copy.Update(&one, 1);
+  while (copy.m_blockSize != 56)
+	copy.Update(&zero, 1);
+  unsigned char length[8];
+  for (int i = 0; i < 8; ++i)
+	length[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+  copy.Update(length, sizeof(length));
+  Digest digest;
+  for (int i = 0; i < 32; ++i)
+	digest[i] = static_cast<uint8_t>(copy.m_state[i / 4] >> (24 - 8 * (i % 4)));
+  return digest;
+}
+
+void Sha256::Compress(const unsigned char *block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i)
+	w[i] = uint32_t{block[4 * i]} << 24 | uint32_t{block[4 * i + 1]} << 16 | uint32_t{block[4 * i + 2]} << 8
+		| uint32_t{block[4 * i + 3]};
+  for (int i = 16; i < 64; ++i) {
+	const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+	const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+	w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+  uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+  for (int i = 0; i < 64; ++i) {
+	const uint32_t t1 = h + (RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25)) + ((e & f) ^ (~e & g))
+		+ kRoundConstants[i] + w[i];
+	const uint32_t t2 = (RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+	h = g;
+	g = f;
+	f = e;
+	e = d + t1;
+	d = c;
+	c = b;
+	b = a;
+	a = t1 + t2;
+  }
+  m_state[0] += a;
+  m_state[1] += b;
+  m_state[2] += c;
+  m_state[3] += d;
+  m_state[4] += e;
+  m_state[5] += f;
+  m_state[6] += g;
+  m_state[7] += h;
+}
+
+bool HashFile(const std::filesystem::path &path, uint64_t &hash) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+	return false;
+  StreamHash stream;
+  std::vector<char> buffer(1 << 20);
+  while (file) {
+	file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	stream.Update(buffer.data(), static_cast<size_t>(file.gcount()));
+  }
+  if (file.bad())
+	return false;
+  hash = stream.Value();
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef STLHELPER__EXPORTERHASH_H_
+#define STLHELPER__EXPORTERHASH_H_
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Fast, non-cryptographic 64 bit hash of a byte stream, used to recognise files that were already
+// written. Input is consumed eight bytes at a time, so feeding it the chunks a writer produces
+// costs far less than the write itself. The result does not depend on how the input is chunked.
+class StreamHash {
+ public:
+  void Update(const void *data, size_t size);
+  uint64_t Value() const;
+
+ private:
+  void Mix(uint64_t word) {
+	m_state = (m_state ^ word) * 0x100000001B3ull;
+	m_state ^= m_state >> 29;
+  }
+
+  uint64_t m_state{0xCBF29CE484222325ull};
+  uint64_t m_length{0};
+  unsigned char m_tail[8]{};
+  size_t m_tailSize{0};
+};
+
+// SHA-256 of a byte stream, for names that must never collide. The content store links every
+// output with the same digest to one stored file, where a collision would silently put another
+// mesh in place; StreamHash is only fast enough to trust for checks that fall back to rewriting.
+class Sha256 {
+ public:
+  using Digest = std::array<uint8_t, 32>;
+
+  void Update(const void *data, size_t size);
+  Digest Value() const;
+
+ private:
+  void Compress(const unsigned char *block);
+
+  uint32_t m_state[8]{0x6A09E667u, 0xBB67AE85u, 0x3C6EF372u, 0xA54FF53Au,
+					  0x510E527Fu, 0x9B05688Cu, 0x1F83D9ABu, 0x5BE0CD19u};
+  uint64_t m_length{0};
+  unsigned char m_block[64]{};
+  size_t m_blockSize{0};
+};
+
+// Hashes the contents of `path` with StreamHash. Returns false if the file cannot be read.
+bool HashFile(const std::filesystem::path &path, uint64_t &hash);
+
+#endif //STLHELPER__EXPORTERHASH_H_
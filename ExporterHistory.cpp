@@ -0,0 +1,380 @@
+#include "ExporterHistory.h"
+#include "ExporterPlatform.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+const char *const kHistoryHeader = "STLExporterHistory 1";
+const char *const kHistoryFile = "history.tsv";
+const char *const kSettingsFolder = "settings";
+constexpr size_t kLatestRuns = 10; // runs listed in the report
+constexpr size_t kLatestRegressions = 20;
+const double kSimilarWork = std::sqrt(2.0); // largest work ratio between similar runs
+
+// Keeps a free-form field on its line and out of the neighbouring columns.
+std::string Field(const std::string &text) {
+  std::string field = text;
+  std::replace_if(field.begin(), field.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+  return field;
+}
+
+void WriteRecord(std::FILE *file, const RunRecord &record) {
+  const auto &s = record.stageSeconds;
+  std::fprintf(file, "%" PRId64 "\t%016" PRIx64 "\t%" PRIu32 "\t%" PRIu64 "\t%" PRIu64 "\t%.4f\t%.4f,%.4f,%.4f,%.4f,%.4f\t%s\t%s\n",
+			   record.time, record.settingsHash, record.bodies, record.triangles, record.bytes, record.seconds,
+			   s[0], s[1], s[2], s[3], s[4], Field(record.fusionVersion).c_str(), Field(record.label).c_str());
+}
+
+bool ParseRecord(const std::string &line, RunRecord &record) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (fields.size() < 8) {
+	const size_t tab = line.find('\t', start);
+	if (tab == std::string::npos)
+	  return false;
+	fields.push_back(line.substr(start, tab - start));
+	start = tab + 1;
+  }
+  record.label = line.substr(start);
+  record.time = std::strtoll(fields[0].c_str(), nullptr, 10);
+  record.settingsHash = std::strtoull(fields[1].c_str(), nullptr, 16);
+  record.bodies = static_cast<uint32_t>(std::strtoul(fields[2].c_str(), nullptr, 10));
+  record.triangles = std::strtoull(fields[3].c_str(), nullptr, 10);
+  record.bytes = std::strtoull(fields[4].c_str(), nullptr, 10);
+  record.seconds = std::strtod(fields[5].c_str(), nullptr);
+  const char *stage = fields[6].c_str();
+  for (auto &&seconds : record.stageSeconds) {
+	char *end = nullptr;
+	seconds = std::strtod(stage, &end);
+	stage = *end == ',' ? end + 1 : end;
+  }
+  record.fusionVersion = fields[7];
+  return record.time > 0;
+}
+
+double Work(const RunRecord &record) {
+  return record.triangles > 0 ? static_cast<double>(record.triangles) : static_cast<double>(record.bodies);
+}
+
+// Half-octave buckets of work for the summary, kept apart for runs measured in bodies rather than
+// triangles.
+int64_t WorkloadKey(const RunRecord &record) {
+  const int64_t bucket = std::lround(2.0 * std::log2(std::max(1.0, Work(record))));
+  return bucket * 2 + (record.triangles > 0 ? 1 : 0);
+}
+
+double Median(std::vector<double> values) {
+  if (values.empty())
+	return 0.0;
+  const size_t middle = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + middle, values.end());
+  if (values.size() % 2 == 1)
+	return values[middle];
+  const double upper = values[middle];
+  return (*std::max_element(values.begin(), values.begin() + middle) + upper) / 2.0;
+}
+
+std::string FormatCount(double value) {
+  char buffer[32];
+  if (value >= 1e6)
+	std::snprintf(buffer, sizeof(buffer), "%.1fM", value / 1e6);
+  else if (value >= 1e4)
+	std::snprintf(buffer, sizeof(buffer), "%.0fk", value / 1e3);
+  else
+	std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+  return buffer;
+}
+
+std::string FormatThroughput(const RunRecord &record, double throughput) {
+  return FormatCount(throughput) + (record.triangles > 0 ? " triangles/s" : " bodies/s");
+}
+
+std::string FormatSeconds(double seconds) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.2f s", seconds);
+  return buffer;
+}
+
+std::string FormatTime(int64_t time) {
+  const std::time_t t = static_cast<std::time_t>(time);
+  char buffer[32];
+  const std::tm *local = std::localtime(&t);
+  if (!local || !std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", local))
+	return "?";
+  return buffer;
+}
+
+std::string RunName(const RunRecord &record) {
+  return record.label.empty() ? "Dialog settings" : record.label;
+}
+}
+
+const char *ExportStageName(ExportStage stage) {
+  switch (stage) {
+	case ExportStage::Prepare: return "preparation";
+	case ExportStage::Tessellate: return "tessellation";
+	case ExportStage::Process: return "mesh processing";
+	case ExportStage::Write: return "writing";
+	case ExportStage::Commit: return "committing files";
+  }
+  return "";
+}
+
+StageTimer::StageTimer() : m_start(Clock::now()), m_mark(m_start) {}
+
+void StageTimer::Enter(ExportStage stage) {
+  const Clock::time_point now = Clock::now();
+  m_seconds[static_cast<size_t>(m_stage)] += std::chrono::duration<double>(now - m_mark).count();
+  m_mark = now;
+  m_stage = stage;
+}
+
+std::array<double, kExportStageCount> StageTimer::Seconds() const {
+  std::array<double, kExportStageCount> seconds = m_seconds;
+  seconds[static_cast<size_t>(m_stage)] += std::chrono::duration<double>(Clock::now() - m_mark).count();
+  return seconds;
+}
+
+double StageTimer::TotalSeconds() const {
+  return std::chrono::duration<double>(Clock::now() - m_start).count();
+}
+
+double RunRecord::Throughput() const {
+  return seconds > 0.0 ? Work(*this) / seconds : 0.0;
+}
+
+ExportHistory::ExportHistory(fs::path folder) : m_folder(std::move(folder)) {}
+
+fs::path ExportHistory::DefaultFolder() {
+  try {
+	return getAppDataFolder() / "STLExporter";
+  } catch (const std::exception &) {
+	return {};
+  }
+}
+
+fs::path ExportHistory::SettingsPath(uint64_t hash) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016" PRIx64 ".txt", hash);
+  return m_folder / kSettingsFolder / name;
+}
+
+bool ExportHistory::Append(const RunRecord &record, const SettingsBlob &settings) {
+  if (m_folder.empty())
+	return false;
+  std::error_code error;
+  const fs::path settingsPath = SettingsPath(record.settingsHash);
+  if (!fs::exists(settingsPath, error)) {
+	fs::create_directories(settingsPath.parent_path(), error);
+	// written aside first, so a stored settings file is always complete
+	const fs::path temp = settingsPath.string() + ".tmp";
+	std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+	out << settings.Serialize();
+	out.close();
+	if (!out || !replaceFile(temp, settingsPath))
+	  fs::remove(temp, error);
+  }
+
+  const fs::path path = m_folder / kHistoryFile;
+  const bool exists = fs::exists(path, error);
+  std::FILE *file = openFile(path, "ab");
+  if (!file)
+	return false;
+  if (!exists)
+	std::fprintf(file, "%s\n", kHistoryHeader);
+  WriteRecord(file, record);
+  const bool written = std::fclose(file) == 0;
+  if (fs::file_size(path, error) > kCompactBytes && !error)
+	Compact();
+  return written;
+}
+
+bool ExportHistory::Load() {
+  m_records.clear();
+  std::ifstream in(m_folder / kHistoryFile, std::ios::binary);
+  std::string line;
+  if (!in || !std::getline(in, line) || line != kHistoryHeader)
+	return false;
+  while (std::getline(in, line)) {
+	if (in.eof())
+	  break; // cut short while being appended
+	RunRecord record;
+	if (ParseRecord(line, record))
+	  m_records.push_back(std::move(record));
+  }
+  return true;
+}
+
+const SettingsBlob *ExportHistory::Settings(uint64_t hash) {
+  auto found = m_settings.find(hash);
+  if (found != m_settings.end())
+	return &found->second;
+  std::ifstream in(SettingsPath(hash), std::ios::binary);
+  if (!in)
+	return nullptr;
+  std::stringstream text;
+  text << in.rdbuf();
+  SettingsBlob blob;
+  if (!SettingsBlob::Parse(text.str(), blob))
+	return nullptr;
+  return &m_settings.emplace(hash, std::move(blob)).first->second;
+}
+
+void ExportHistory::Compact() {
+  if (!Load())
+	return;
+  m_records.erase(m_records.begin(), m_records.begin() + m_records.size() / 2);
+  const fs::path path = m_folder / kHistoryFile;
+  const fs::path temp = path.string() + ".tmp";
+  std::FILE *file = openFile(temp, "wb");
+  if (!file)
+	return;
+  std::fprintf(file, "%s\n", kHistoryHeader);
+  std::set<uint64_t> kept;
+  for (auto &&record : m_records) {
+	WriteRecord(file, record);
+	kept.insert(record.settingsHash);
+  }
+  std::error_code error;
+  if (std::fclose(file) != 0 || !replaceFile(temp, path)) {
+	fs::remove(temp, error);
+	return;
+  }
+  // settings no remaining run refers to
+  for (fs::directory_iterator it(m_folder / kSettingsFolder, error), end; !error && it != end; it.increment(error)) {
+	const uint64_t hash = std::strtoull(it->path().stem().string().c_str(), nullptr, 16);
+	if (!kept.count(hash))
+	  fs::remove(it->path(), error);
+  }
+}
+
+std::vector<Regression> FindRegressions(const std::vector<RunRecord> &records, const RegressionOptions &options) {
+  std::vector<Regression> regressions;
+  std::vector<size_t> similar;
+  for (size_t i = 0; i < records.size(); ++i) {
+	const RunRecord &record = records[i];
+	const double throughput = record.Throughput();
+	if (throughput <= 0.0)
+	  continue;
+	// the latest earlier runs within half an octave of this one's work, newest first
+	const double work = std::max(1.0, Work(record));
+	similar.clear();
+	for (size_t j = i; j-- > 0 && similar.size() < options.window;) {
+	  const double ratio = std::max(1.0, Work(records[j])) / work;
+	  if ((records[j].triangles > 0) == (record.triangles > 0) && ratio < kSimilarWork && ratio * kSimilarWork > 1.0
+		  && records[j].Throughput() > 0.0)
+		similar.push_back(j);
+	}
+	if (similar.size() < options.minimumBaseline)
+	  continue;
+	std::vector<double> throughputs;
+	for (size_t j : similar)
+	  throughputs.push_back(records[j].Throughput());
+	const double baseline = Median(throughputs);
+	const double slowdown = baseline / throughput - 1.0;
+	if (slowdown * 100.0 <= options.slowdownPercent)
+	  continue;
+
+	Regression regression;
+	regression.record = i;
+	regression.previous = similar.front();
+	regression.baselineThroughput = baseline;
+	regression.slowdown = slowdown;
+	// each stage is compared per unit of work and scaled back to this run
+	regression.stageExtraSeconds = -1.0;
+	for (size_t s = 0; s < kExportStageCount; ++s) {
+	  std::vector<double> rates;
+	  for (size_t j : similar)
+		rates.push_back(records[j].stageSeconds[s] / std::max(1.0, Work(records[j])));
+	  const double extra = record.stageSeconds[s] - Median(rates) * work;
+	  if (extra > regression.stageExtraSeconds) {
+		regression.stageExtraSeconds = extra;
+		regression.stage = static_cast<ExportStage>(s);
+	  }
+	}
+	regressions.push_back(regression);
+  }
+  return regressions;
+}
+
+std::string FormatHistoryReport(ExportHistory &history, const RegressionOptions &options) {
+  const std::vector<RunRecord> &records = history.Records();
+  if (records.empty())
+	return "No exports have been recorded yet.";
+  std::string report = std::to_string(records.size()) + " exports recorded since " + FormatTime(records.front().time) + ".\n";
+
+  report += "\nThroughput by workload:\n";
+  std::map<int64_t, std::vector<size_t>> byWorkload;
+  for (size_t i = 0; i < records.size(); ++i)
+	byWorkload[WorkloadKey(records[i])].push_back(i);
+  for (auto &&workload : byWorkload) {
+	const RunRecord &latest = records[workload.second.back()];
+	std::vector<double> throughputs;
+	for (size_t i : workload.second)
+	  throughputs.push_back(records[i].Throughput());
+	report += "~" + FormatCount(std::exp2(static_cast<double>(workload.first / 2) / 2.0));
+	report += latest.triangles > 0 ? " triangles: " : " bodies (meshed by Fusion): ";
+	report += std::to_string(workload.second.size()) + (workload.second.size() == 1 ? " run" : " runs");
+	report += ", median " + FormatThroughput(latest, Median(throughputs));
+	report += ", latest " + FormatThroughput(latest, latest.Throughput()) + "\n";
+  }
+
+  report += "\nLatest exports:\n";
+  for (size_t i = records.size() - std::min(records.size(), kLatestRuns); i < records.size(); ++i) {
+	const RunRecord &record = records[i];
+	char bytes[32];
+	std::snprintf(bytes, sizeof(bytes), "%.1f MB", static_cast<double>(record.bytes) / (1 << 20));
+	report += FormatTime(record.time) + "  " + RunName(record) + ": " + std::to_string(record.bodies) + " bodies, ";
+	if (record.triangles > 0)
+	  report += FormatCount(static_cast<double>(record.triangles)) + " triangles, ";
+	report += std::string(bytes) + " in " + FormatSeconds(record.seconds);
+	report += " (" + FormatThroughput(record, record.Throughput()) + ")\n";
+  }
+
+  const std::vector<Regression> regressions = FindRegressions(records, options);
+  char threshold[96];
+  std::snprintf(threshold, sizeof(threshold), "more than %.0f%% slower than the median of similar earlier runs",
+				options.slowdownPercent);
+  if (regressions.empty()) {
+	report += "\nNo export was " + std::string(threshold) + ".\n";
+	return report;
+  }
+  report += "\nExports " + std::string(threshold) + ":\n";
+  for (size_t r = regressions.size() - std::min(regressions.size(), kLatestRegressions); r < regressions.size(); ++r) {
+	const Regression &regression = regressions[r];
+	const RunRecord &record = records[regression.record];
+	const RunRecord &previous = records[regression.previous];
+	report += FormatTime(record.time) + "  " + RunName(record) + ": ";
+	report += std::to_string(static_cast<int>(regression.slowdown * 100.0 + 0.5)) + "% slower than ";
+	report += FormatThroughput(record, regression.baselineThroughput);
+	if (regression.stageExtraSeconds > 0.0) {
+	  report += ", mostly in " + std::string(ExportStageName(regression.stage));
+	  report += " (+" + FormatSeconds(regression.stageExtraSeconds) + ")";
+	}
+	report += ".";
+	if (record.fusionVersion != previous.fusionVersion)
+	  report += " Fusion changed from " + previous.fusionVersion + " to " + record.fusionVersion + ".";
+	if (record.settingsHash != previous.settingsHash) {
+	  const SettingsBlob *now = history.Settings(record.settingsHash);
+	  const SettingsBlob *before = now ? history.Settings(previous.settingsHash) : nullptr;
+	  if (now && before) {
+		// inserting into the cache keeps `now` valid
+		std::string keys;
+		for (auto &&key : now->DifferingKeys(*before))
+		  keys += (keys.empty() ? "" : ", ") + key;
+		report += " Settings changed: " + keys + ".";
+	  } else {
+		report += " Settings changed.";
+	  }
+	}
+	report += "\n";
+  }
+  return report;
+}
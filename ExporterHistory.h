@@ -0,0 +1,111 @@
+#ifndef STLHELPER__EXPORTERHISTORY_H_
+#define STLHELPER__EXPORTERHISTORY_H_
+#pragma once
+
+#include "ExporterSettings.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stages of an export run as seen from the main thread. Writer threads work alongside the first
+// three; Write is the time left waiting for them once everything is queued.
+enum class ExportStage { Prepare, Tessellate, Process, Write, Commit };
+constexpr size_t kExportStageCount = 5;
+
+const char *ExportStageName(ExportStage stage);
+
+// Splits the wall time of a run between consecutive stages. Switching costs one clock read.
+class StageTimer {
+ public:
+  StageTimer();
+
+  // Ends the current stage and starts `stage`.
+  void Enter(ExportStage stage);
+
+  // Seconds spent in each stage so far, including the running one.
+  std::array<double, kExportStageCount> Seconds() const;
+  double TotalSeconds() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point m_start;
+  Clock::time_point m_mark; // when the current stage started
+  ExportStage m_stage{ExportStage::Prepare};
+  std::array<double, kExportStageCount> m_seconds{};
+};
+
+// Metrics of one finished export run.
+struct RunRecord {
+  int64_t time{0}; // seconds since the Unix epoch
+  uint64_t settingsHash{0};
+  std::string label; // preset names, empty for the dialog's own settings
+  std::string fusionVersion;
+  uint32_t bodies{0};
+  uint64_t triangles{0}; // 0 when Fusion's export manager did all the meshing
+  uint64_t bytes{0};
+  double seconds{0.0};
+  std::array<double, kExportStageCount> stageSeconds{};
+
+  // Triangles per second, or bodies per second for runs that had no mesh of their own.
+  double Throughput() const;
+};
+
+// Local record of past export runs, kept in the user's app data folder so throughput can be
+// compared across Fusion updates and settings changes. Runs are appended as one text line each;
+// the settings of a run are stored once per distinct settings hash next to it.
+class ExportHistory {
+ public:
+  static constexpr uint64_t kCompactBytes = 1 << 20; // past this size the oldest half is dropped
+
+  explicit ExportHistory(std::filesystem::path folder = DefaultFolder());
+
+  static std::filesystem::path DefaultFolder();
+
+  // Appends `record` and stores `settings` under its hash if they are new.
+  bool Append(const RunRecord &record, const SettingsBlob &settings);
+
+  // Reads every recorded run, oldest first. Malformed lines are skipped.
+  bool Load();
+  const std::vector<RunRecord> &Records() const { return m_records; }
+
+  // The stored settings with `hash`, or null if they are gone.
+  const SettingsBlob *Settings(uint64_t hash);
+
+ private:
+  std::filesystem::path SettingsPath(uint64_t hash) const;
+  void Compact();
+
+  std::filesystem::path m_folder;
+  std::vector<RunRecord> m_records;
+  std::unordered_map<uint64_t, SettingsBlob> m_settings;
+};
+
+struct RegressionOptions {
+  double slowdownPercent{20.0}; // flag runs this much slower than the baseline
+  size_t window{10}; // similar runs the rolling median is taken over
+  size_t minimumBaseline{3}; // similar runs needed before a run can be flagged
+};
+
+// A run slower than the median of the latest similar runs before it. Runs are similar when their
+// amounts of work, in triangles or else bodies, are within half an octave of each other.
+struct Regression {
+  size_t record{0};
+  size_t previous{0}; // the most recent similar run, to compare versions and settings with
+  double baselineThroughput{0.0};
+  double slowdown{0.0}; // extra time relative to the baseline, 0.5 for 50% slower
+  ExportStage stage{ExportStage::Prepare}; // the stage that grew most
+  double stageExtraSeconds{0.0};
+};
+
+std::vector<Regression> FindRegressions(const std::vector<RunRecord> &records, const RegressionOptions &options);
+
+// Human-readable summary of the history: throughput per workload size, the latest runs and every
+// flagged run with its likely cause.
+std::string FormatHistoryReport(ExportHistory &history, const RegressionOptions &options);
+
+#endif //STLHELPER__EXPORTERHISTORY_H_
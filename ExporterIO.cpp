@@ -0,0 +1,181 @@
+#include "ExporterIO.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+
+OutputFile::~OutputFile() {
+  Close();
+}
+
+#ifdef _WIN32
+bool OutputFile::Open(const std::filesystem::path &path, uint64_t expectedSize) {
+  Close();
+  m_failed = false;
+  HANDLE handle = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+	return false;
+  m_handle = handle;
+  if (expectedSize > 0) {
+	FILE_ALLOCATION_INFO allocation;
+	allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(expectedSize);
+	SetFileInformationByHandle(handle, FileAllocationInfo, &allocation, sizeof(allocation));
+  }
+  return true;
+}
+
+bool OutputFile::Write(const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (!m_failed && size > 0) {
+	DWORD written = 0;
+	const DWORD request = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+	if (!WriteFile(static_cast<HANDLE>(m_handle), bytes, request, &written, nullptr) || written == 0)
+	  m_failed = true;
+	bytes += written;
+	size -= written;
+  }
+  return !m_failed;
+}
+
+bool OutputFile::Close() {
+  if (!m_handle)
+	return !m_failed;
+  if (!CloseHandle(static_cast<HANDLE>(m_handle)))
+	m_failed = true;
+  m_handle = nullptr;
+  return !m_failed;
+}
+#else
+bool OutputFile::Open(const std::filesystem::path &path, uint64_t expectedSize) {
+  Close();
+  m_failed = false;
+  m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (m_fd < 0)
+	return false;
+  m_dropCache = expectedSize >= kUncachedWriteSize;
+#if defined(__APPLE__)
+  if (expectedSize > 0) {
+	fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(expectedSize), 0};
+	fcntl(m_fd, F_PREALLOCATE, &store);
+  }
+  if (m_dropCache)
+	fcntl(m_fd, F_NOCACHE, 1);
+#elif defined(__linux__)
+  // keep the size so a hint that is too large leaves no padding behind
+  if (expectedSize > 0)
+	fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(expectedSize));
+#endif
+  return true;
+}
+
+bool OutputFile::Write(const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (!m_failed && size > 0) {
+	const ssize_t written = write(m_fd, bytes, size);
+	if (written < 0 && errno == EINTR)
+	  continue;
+	if (written <= 0) {
+	  m_failed = true;
+	  break;
+	}
+	bytes += written;
+	size -= static_cast<size_t>(written);
+  }
+  return !m_failed;
+}
+
+bool OutputFile::Close() {
+  if (m_fd < 0)
+	return !m_failed;
+#if defined(__linux__)
+  // Linux has no cache bypass without aligned buffers (O_DIRECT); dropping the pages after the
+  // write-back gets the same effect for large files.
+  if (m_dropCache && !m_failed && fdatasync(m_fd) == 0)
+	posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  if (close(m_fd) != 0)
+	m_failed = true;
+  m_fd = -1;
+  return !m_failed;
+}
+#endif
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::filesystem::path &path) {
+  Close();
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+	return false;
+  m_file = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+	Close();
+	return false;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (m_size == 0)
+	return true; // empty files cannot be mapped
+  m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping)
+	m_data = static_cast<const char *>(MapViewOfFile(static_cast<HANDLE>(m_mapping), FILE_MAP_READ, 0, 0, 0));
+  if (!m_data) {
+	Close();
+	return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (m_data)
+	UnmapViewOfFile(m_data);
+  if (m_mapping)
+	CloseHandle(static_cast<HANDLE>(m_mapping));
+  if (m_file)
+	CloseHandle(static_cast<HANDLE>(m_file));
+  m_data = nullptr;
+  m_mapping = nullptr;
+  m_file = nullptr;
+  m_size = 0;
+}
+#else
+bool MappedFile::Open(const std::filesystem::path &path) {
+  Close();
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+	return false;
+  struct stat info;
+  bool opened = fstat(fd, &info) == 0;
+  if (opened && info.st_size > 0) {
+	void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	opened = data != MAP_FAILED;
+	if (opened) {
+	  m_data = static_cast<const char *>(data);
+	  m_size = static_cast<size_t>(info.st_size);
+	  madvise(data, m_size, MADV_SEQUENTIAL);
+	}
+  }
+  close(fd); // the mapping keeps the file alive
+  return opened;
+}
+
+void MappedFile::Close() {
+  if (m_data)
+	munmap(const_cast<char *>(m_data), m_size);
+  m_data = nullptr;
+  m_size = 0;
+}
+#endif
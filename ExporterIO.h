@@ -0,0 +1,65 @@
+#ifndef STLHELPER__EXPORTERIO_H_
+#define STLHELPER__EXPORTERIO_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Files at least this large bypass the OS cache where that needs no aligned buffers; caching them
+// only evicts data that is still useful.
+constexpr uint64_t kUncachedWriteSize = uint64_t{64} << 20;
+
+// Sequential output file written through the native handle. Writers hand over whole chunks, so
+// each chunk is one system call with no stream buffer in between, and the final size is reserved
+// up front so the file system allocates it in one go instead of growing it chunk by chunk.
+class OutputFile {
+ public:
+  OutputFile() = default;
+  ~OutputFile();
+  OutputFile(const OutputFile &) = delete;
+  OutputFile &operator=(const OutputFile &) = delete;
+
+  // Creates or truncates `path`. `expectedSize` is a hint; 0 means unknown.
+  bool Open(const std::filesystem::path &path, uint64_t expectedSize = 0);
+
+  bool Write(const void *data, size_t size);
+
+  // Closes the file; returns false if any write or the close itself failed.
+  bool Close();
+
+ private:
+#ifdef _WIN32
+  void *m_handle{nullptr};
+#else
+  int m_fd{-1};
+  bool m_dropCache{false};
+#endif
+  bool m_failed{false};
+};
+
+// Read-only view of a whole file mapped into memory. Pages are only read when touched, so parsing
+// threads pull their own ranges straight from the cache without a copy into a buffer.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool Open(const std::filesystem::path &path);
+  void Close();
+
+  const char *Data() const { return m_data; }
+  size_t Size() const { return m_size; }
+
+ private:
+  const char *m_data{nullptr};
+  size_t m_size{0};
+#ifdef _WIN32
+  void *m_file{nullptr};
+  void *m_mapping{nullptr};
+#endif
+};
+
+#endif //STLHELPER__EXPORTERIO_H_
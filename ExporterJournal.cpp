@@ -0,0 +1,125 @@
+#include "ExporterJournal.h"
+#include "ExporterHash.h"
+#include "ExporterPlatform.h"
+
+#include <cinttypes>
+#include <fstream>
+
+namespace {
+const char *const kJournalHeader = "STLExporterJournal 2";
+}
+
+ExportJournal::~ExportJournal() {
+  if (m_file) {
+	syncFile(m_file);
+	std::fclose(m_file);
+  }
+}
+
+bool ExportJournal::Open(const fs::path &folder, uint64_t runHash) {
+  char name[48];
+  std::snprintf(name, sizeof(name), ".stlexporter-%016" PRIx64 ".journal", runHash);
+  m_path = folder / name;
+  m_entries.clear();
+  m_bodies.clear();
+  m_files.clear();
+
+  // Lines are "<hash>\t<size>\t<token>\t<path>"; a finished body has no path and counts its files
+  // in the size column. A line cut short by a crash has no newline and its body is simply written
+  // again.
+  std::ifstream previous(m_path, std::ios::binary);
+  std::string line;
+  bool valid = previous && std::getline(previous, line) && line == kJournalHeader;
+  while (valid && std::getline(previous, line)) {
+	if (previous.eof())
+	  break;
+	const size_t a = line.find('\t'), b = line.find('\t', a + 1), c = line.find('\t', b + 1);
+	if (c == std::string::npos)
+	  continue;
+	Entry entry;
+	entry.hash = std::strtoull(line.c_str(), nullptr, 16);
+	entry.size = std::strtoull(line.c_str() + a + 1, nullptr, 10);
+	entry.token = line.substr(b + 1, c - b - 1);
+	if (c + 1 == line.size())
+	  m_bodies[entry.token] = static_cast<size_t>(entry.size);
+	else
+	  m_entries[line.substr(c + 1)] = std::move(entry);
+  }
+  previous.close();
+  for (auto &&[path, entry] : m_entries)
+	m_files[entry.token].push_back(path);
+
+  m_file = openFile(m_path, valid ? "ab" : "wb");
+  if (!m_file)
+	return false;
+  if (!valid)
+	std::fprintf(m_file, "%s\n", kJournalHeader);
+  return true;
+}
+
+bool ExportJournal::IsBodyDone(const std::string &token) {
+  auto body = m_bodies.find(token);
+  if (body == m_bodies.end())
+	return false;
+  auto files = m_files.find(token);
+  const size_t recorded = files == m_files.end() ? 0 : files->second.size();
+  if (recorded != body->second)
+	return false; // a file was written over by another body since
+  for (size_t i = 0; i < recorded; ++i) {
+	if (!IsDone(token, files->second[i]))
+	  return false;
+  }
+  return true;
+}
+
+bool ExportJournal::IsDone(const std::string &token, const std::string &file) {
+  auto found = m_entries.find(file);
+  if (found == m_entries.end() || found->second.token != token)
+	return false;
+  Entry &entry = found->second;
+  if (entry.verified)
+	return true;
+  std::error_code error;
+  uint64_t hash = 0;
+  if (fs::file_size(file, error) != entry.size || error || !HashFile(file, hash) || hash != entry.hash)
+	return false;
+  entry.verified = true;
+  return true;
+}
+
+void ExportJournal::Record(const std::string &token, const fs::path &file, uint64_t size, uint64_t contentHash) {
+  char fields[48];
+  std::snprintf(fields, sizeof(fields), "%016" PRIx64 "\t%" PRIu64 "\t", contentHash, size);
+  Append(fields + token + "\t" + file.string() + "\n");
+}
+
+void ExportJournal::RecordBody(const std::string &token, size_t files) {
+  char fields[48];
+  std::snprintf(fields, sizeof(fields), "%016" PRIx64 "\t%" PRIu64 "\t", uint64_t{0}, static_cast<uint64_t>(files));
+  Append(fields + token + "\t\n");
+}
+
+void ExportJournal::Append(const std::string &line) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_file)
+	return;
+  std::fwrite(line.data(), 1, line.size(), m_file);
+  if (++m_unsynced >= kSyncBatch) {
+	syncFile(m_file);
+	m_unsynced = 0;
+  }
+}
+
+void ExportJournal::Finish(bool completed) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_file)
+	return;
+  if (!completed)
+	syncFile(m_file);
+  std::fclose(m_file);
+  m_file = nullptr;
+  if (completed) {
+	std::error_code error;
+	fs::remove(m_path, error);
+  }
+}
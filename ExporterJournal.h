@@ -0,0 +1,67 @@
+#ifndef STLHELPER__EXPORTERJOURNAL_H_
+#define STLHELPER__EXPORTERJOURNAL_H_
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Append-only record of the files an export has finished, kept in the output folder while the
+// export runs. Once every output of a body is in place, the body itself is recorded with the
+// number of its files. If Fusion goes down mid-export, the next run with identical settings finds
+// the journal, checks the recorded files of each finished body by size and content hash, and only
+// redoes the bodies that are missing something. A run that completes deletes its journal.
+class ExportJournal {
+ public:
+  static constexpr size_t kSyncBatch = 32; // entries appended between syncs
+
+  ExportJournal() = default;
+  ~ExportJournal();
+  ExportJournal(const ExportJournal &) = delete;
+  ExportJournal &operator=(const ExportJournal &) = delete;
+
+  // Opens the journal of the run whose settings hash to `runHash`, loading entries left behind by
+  // an interrupted run with the same settings.
+  bool Open(const std::filesystem::path &folder, uint64_t runHash);
+  bool IsOpen() const { return m_file != nullptr; }
+
+  // True if the body with `token` was recorded as done and all its files still have the recorded
+  // contents.
+  bool IsBodyDone(const std::string &token);
+
+  // Appends an entry for a file that is durably in place with `size` bytes. Safe to call from
+  // writer threads.
+  void Record(const std::string &token, const std::filesystem::path &file, uint64_t size, uint64_t contentHash);
+
+  // Appends the entry that marks the body with `token` done once its `files` are all recorded.
+  // Safe to call from writer threads.
+  void RecordBody(const std::string &token, size_t files);
+
+  // Ends the run: a completed run removes the journal, an incomplete one syncs it for next time.
+  void Finish(bool completed);
+
+ private:
+  struct Entry {
+	std::string token;
+	uint64_t size{0};
+	uint64_t hash{0};
+	bool verified{false};
+  };
+
+  bool IsDone(const std::string &token, const std::string &file);
+  void Append(const std::string &line);
+
+  std::unordered_map<std::string, Entry> m_entries; // by file path
+  std::unordered_map<std::string, size_t> m_bodies; // file count of each finished body, by token
+  std::unordered_map<std::string, std::vector<std::string>> m_files; // recorded paths by token
+  std::filesystem::path m_path;
+  std::FILE *m_file{nullptr};
+  size_t m_unsynced{0};
+  std::mutex m_mutex;
+};
+
+#endif //STLHELPER__EXPORTERJOURNAL_H_
@@ -0,0 +1,136 @@
+#include "ExporterMerge.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ac = adsk::core;
+namespace af = adsk::fusion;
+
+namespace {
+constexpr float kTouchTolerance = 1e-4f; // centimeters; faces this close count as touching
+
+size_t FindRoot(std::vector<size_t> &parent, size_t i) {
+  while (parent[i] != i) {
+	parent[i] = parent[parent[i]];
+	i = parent[i];
+  }
+  return i;
+}
+
+bool Overlaps(const BoundingBox &a, const BoundingBox &b, float tolerance) {
+  for (int axis = 0; axis < 3; ++axis) {
+	if (a.max[axis] + tolerance < b.min[axis] || b.max[axis] + tolerance < a.min[axis])
+	  return false;
+  }
+  return true;
+}
+
+BoundingBox BodyBounds(const ac::Ptr<af::BRepBody> &body) {
+  BoundingBox box;
+  auto bounds = body ? body->boundingBox() : nullptr;
+  if (bounds && bounds->minPoint() && bounds->maxPoint()) {
+	box.Extend(Vec3{static_cast<float>(bounds->minPoint()->x()), static_cast<float>(bounds->minPoint()->y()),
+					static_cast<float>(bounds->minPoint()->z())});
+	box.Extend(Vec3{static_cast<float>(bounds->maxPoint()->x()), static_cast<float>(bounds->maxPoint()->y()),
+					static_cast<float>(bounds->maxPoint()->z())});
+  }
+  return box;
+}
+}
+
+std::vector<std::vector<size_t>> GroupOverlapping(const std::vector<BoundingBox> &boxes, float tolerance) {
+  const size_t count = boxes.size();
+  std::vector<size_t> parent(count);
+  std::iota(parent.begin(), parent.end(), size_t{0});
+
+  std::vector<size_t> order;
+  order.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+	if (!boxes[i].IsEmpty())
+	  order.push_back(i);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return boxes[a].min[0] < boxes[b].min[0]; });
+  // Boxes whose X range is still open at the sweep position; only those can overlap the next one.
+  std::vector<size_t> active;
+  for (size_t i : order) {
+	const float start = boxes[i].min[0] - tolerance;
+	active.erase(std::remove_if(active.begin(), active.end(), [&](size_t a) { return boxes[a].max[0] < start; }),
+				 active.end());
+	for (size_t a : active) {
+	  if (Overlaps(boxes[a], boxes[i], tolerance))
+		parent[FindRoot(parent, a)] = FindRoot(parent, i);
+	}
+	active.push_back(i);
+  }
+
+  std::vector<std::vector<size_t>> groups;
+  std::vector<size_t> groupOf(count, count);
+  for (size_t i = 0; i < count; ++i) {
+	const size_t root = FindRoot(parent, i);
+	if (groupOf[root] == count) {
+	  groupOf[root] = groups.size();
+	  groups.emplace_back();
+	}
+	groups[groupOf[root]].push_back(i);
+  }
+  return groups;
+}
+
+std::vector<ac::Ptr<af::BRepBody>> UnionOverlappingBodies(const std::vector<ac::Ptr<af::BRepBody>> &bodies,
+														   size_t &failed) {
+  std::vector<ac::Ptr<af::BRepBody>> result;
+  std::vector<BoundingBox> boxes;
+  boxes.reserve(bodies.size());
+  for (auto &&body : bodies)
+	boxes.push_back(BodyBounds(body));
+  auto manager = af::TemporaryBRepManager::get();
+
+  for (auto &&group : GroupOverlapping(boxes, kTouchTolerance)) {
+	if (group.size() == 1 || !manager) {
+	  for (size_t i : group)
+		result.push_back(bodies[i]);
+	  continue;
+	}
+	std::vector<ac::Ptr<af::BRepBody>> pieces;
+	for (size_t i : group) {
+	  ac::Ptr<af::BRepBody> copy = manager->copy(bodies[i]);
+	  if (!copy)
+		break;
+	  pieces.push_back(copy);
+	}
+	if (pieces.size() != group.size()) {
+	  ++failed;
+	  for (size_t i : group)
+		result.push_back(bodies[i]);
+	  continue;
+	}
+	// Union neighbours pairwise until one body is left; a pair that fails stays apart.
+	bool merged = true;
+	while (pieces.size() > 1 && merged) {
+	  merged = false;
+	  std::vector<ac::Ptr<af::BRepBody>> next;
+	  for (size_t i = 0; i < pieces.size(); i += 2) {
+		if (i + 1 < pieces.size() && manager->booleanOperation(pieces[i], pieces[i + 1], af::UnionBooleanType)) {
+		  merged = true;
+		  next.push_back(pieces[i]);
+		} else {
+		  next.push_back(pieces[i]);
+		  if (i + 1 < pieces.size())
+			next.push_back(pieces[i + 1]);
+		}
+	  }
+	  pieces.swap(next);
+	}
+	if (pieces.size() > 1)
+	  ++failed;
+	result.insert(result.end(), pieces.begin(), pieces.end());
+  }
+  return result;
+}
+
+void AppendMesh(Mesh &mesh, const Mesh &part) {
+  const uint32_t base = static_cast<uint32_t>(mesh.VertexCount());
+  mesh.positions.insert(mesh.positions.end(), part.positions.begin(), part.positions.end());
+  mesh.indices.reserve(mesh.indices.size() + part.indices.size());
+  for (uint32_t i : part.indices)
+	mesh.indices.push_back(base + i);
+}
@@ -0,0 +1,29 @@
+#ifndef STLHELPER__EXPORTERMERGE_H_
+#define STLHELPER__EXPORTERMERGE_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <Core/CoreAll.h>
+#include <Fusion/FusionAll.h>
+
+#include <vector>
+
+// Groups boxes that overlap or touch within `tolerance`, directly or through other boxes in the
+// group, with a sweep over X and a union-find. Groups list box indices in ascending order and are
+// ordered by their first index.
+std::vector<std::vector<size_t>> GroupOverlapping(const std::vector<BoundingBox> &boxes, float tolerance);
+
+// Replaces every group of bodies whose bounding boxes overlap with one temporary body holding their
+// union, computed by Fusion's B-rep kernel. The union is built as a balanced tree of pairwise
+// booleans, so each intermediate body stays as small as possible. Bodies that overlap nothing are
+// returned as they are. Groups whose union fails are returned unmerged and counted in `failed`.
+// Must run on the main thread.
+std::vector<adsk::core::Ptr<adsk::fusion::BRepBody>> UnionOverlappingBodies(
+	const std::vector<adsk::core::Ptr<adsk::fusion::BRepBody>> &bodies,
+	size_t &failed);
+
+// Appends `part` to `mesh` unchanged.
+void AppendMesh(Mesh &mesh, const Mesh &part);
+
+#endif //STLHELPER__EXPORTERMERGE_H_
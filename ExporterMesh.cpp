@@ -0,0 +1,131 @@
+#include "ExporterMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Vec3 Mesh::FaceNormal(size_t triangle) const {
+  Vec3 n = Cross(Corner(triangle, 1) - Corner(triangle, 0), Corner(triangle, 2) - Corner(triangle, 0));
+  float len = std::sqrt(Dot(n, n));
+  return len > 0.0f ? n * (1.0f / len) : Vec3{0, 0, 0};
+}
+
+float Mesh::TriangleArea(size_t triangle) const {
+  Vec3 n = Cross(Corner(triangle, 1) - Corner(triangle, 0), Corner(triangle, 2) - Corner(triangle, 0));
+  return 0.5f * std::sqrt(Dot(n, n));
+}
+
+BoundingBox Mesh::Bounds() const {
+  BoundingBox box;
+  for (uint32_t v = 0; v < VertexCount(); ++v)
+	box.Extend(Vertex(v));
+  return box;
+}
+
+namespace {
+uint64_t HashVertex(const uint32_t bits[3]) {
+  uint64_t h = bits[0] * 0x9E3779B97F4A7C15ull;
+  h ^= (h >> 29) + bits[1] * 0xBF58476D1CE4E5B9ull;
+  h ^= (h >> 32) + bits[2] * 0x94D049BB133111EBull;
+  return h ^ (h >> 31);
+}
+}
+
+void WeldVertices(Mesh &mesh) {
+  const size_t count = mesh.VertexCount();
+  // Open addressing keyed on the coordinate bits; slots hold welded vertex ids.
+  size_t capacity = 16;
+  while (capacity < 2 * count)
+	capacity <<= 1;
+  const uint32_t kEmpty = 0xFFFFFFFFu;
+  std::vector<uint32_t> slots(capacity, kEmpty);
+  std::vector<uint32_t> weldedBits;
+  weldedBits.reserve(mesh.positions.size());
+  std::vector<uint32_t> remap(count);
+  for (size_t v = 0; v < count; ++v) {
+	uint32_t bits[3];
+	for (int a = 0; a < 3; ++a) {
+	  float f = mesh.positions[3 * v + a];
+	  f = f == 0.0f ? 0.0f : f; // fold -0 into +0
+	  std::memcpy(&bits[a], &f, sizeof(float));
+	}
+	size_t slot = HashVertex(bits) & (capacity - 1);
+	while (true) {
+	  uint32_t id = slots[slot];
+	  if (id == kEmpty) {
+		id = static_cast<uint32_t>(weldedBits.size() / 3);
+		weldedBits.insert(weldedBits.end(), bits, bits + 3);
+		slots[slot] = id;
+		remap[v] = id;
+		break;
+	  }
+	  if (std::memcmp(&weldedBits[3 * size_t{id}], bits, sizeof(bits)) == 0) {
+		remap[v] = id;
+		break;
+	  }
+	  slot = (slot + 1) & (capacity - 1);
+	}
+  }
+  for (auto &i : mesh.indices)
+	i = remap[i];
+  mesh.positions.resize(weldedBits.size());
+  std::memcpy(mesh.positions.data(), weldedBits.data(), weldedBits.size() * sizeof(float));
+}
+
+void ClusterVertices(Mesh &mesh, uint32_t cells) {
+  const size_t count = mesh.VertexCount();
+  const BoundingBox box = mesh.Bounds();
+  const Vec3 size = box.Size();
+  const float longest = std::max(size[0], std::max(size[1], size[2]));
+  if (count == 0 || cells == 0 || longest <= 0.0f)
+	return;
+  cells = std::min(cells, 1u << 20); // three cell coordinates must fit a 64 bit key
+  const float inverse = static_cast<float>(cells) / longest;
+
+  size_t capacity = 16;
+  while (capacity < 2 * count)
+	capacity <<= 1;
+  const uint32_t kEmpty = 0xFFFFFFFFu;
+  std::vector<uint32_t> slots(capacity, kEmpty);
+  std::vector<uint64_t> keys;
+  std::vector<double> sums; // x, y, z per cluster
+  std::vector<uint32_t> members;
+  std::vector<uint32_t> remap(count);
+  for (size_t v = 0; v < count; ++v) {
+	uint32_t cell[3];
+	for (int a = 0; a < 3; ++a) {
+	  float c = (mesh.positions[3 * v + a] - box.min[a]) * inverse;
+	  cell[a] = std::min(static_cast<uint32_t>(c), cells - 1);
+	}
+	const uint64_t key = uint64_t{cell[0]} | uint64_t{cell[1]} << 21 | uint64_t{cell[2]} << 42;
+	size_t slot = HashVertex(cell) & (capacity - 1);
+	while (slots[slot] != kEmpty && keys[slots[slot]] != key)
+	  slot = (slot + 1) & (capacity - 1);
+	if (slots[slot] == kEmpty) {
+	  slots[slot] = static_cast<uint32_t>(keys.size());
+	  keys.push_back(key);
+	  sums.insert(sums.end(), 3, 0.0);
+	  members.push_back(0);
+	}
+	const uint32_t id = slots[slot];
+	for (int a = 0; a < 3; ++a)
+	  sums[3 * size_t{id} + a] += mesh.positions[3 * v + a];
+	++members[id];
+	remap[v] = id;
+  }
+
+  mesh.positions.resize(sums.size());
+  for (size_t c = 0; c < members.size(); ++c)
+	for (int a = 0; a < 3; ++a)
+	  mesh.positions[3 * c + a] = static_cast<float>(sums[3 * c + a] / members[c]);
+  size_t kept = 0;
+  for (size_t t = 0; t < mesh.TriangleCount(); ++t) {
+	const uint32_t a = remap[mesh.indices[3 * t]], b = remap[mesh.indices[3 * t + 1]], c = remap[mesh.indices[3 * t + 2]];
+	if (a == b || b == c || c == a)
+	  continue;
+	mesh.indices[kept++] = a;
+	mesh.indices[kept++] = b;
+	mesh.indices[kept++] = c;
+  }
+  mesh.indices.resize(kept);
+}
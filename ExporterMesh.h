@@ -0,0 +1,76 @@
+#ifndef STLHELPER__EXPORTERMESH_H_
+#define STLHELPER__EXPORTERMESH_H_
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using Vec3 = std::array<float, 3>;
+
+inline Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a[0] + b[0], a[1] + b[1], a[2] + b[2]}; }
+inline Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+inline Vec3 operator*(const Vec3 &a, float s) { return {a[0] * s, a[1] * s, a[2] * s}; }
+inline float Dot(const Vec3 &a, const Vec3 &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+inline Vec3 Cross(const Vec3 &a, const Vec3 &b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+struct BoundingBox {
+  Vec3 min{1e30f, 1e30f, 1e30f};
+  Vec3 max{-1e30f, -1e30f, -1e30f};
+
+  void Extend(const Vec3 &p) {
+	for (int a = 0; a < 3; ++a) {
+	  min[a] = p[a] < min[a] ? p[a] : min[a];
+	  max[a] = p[a] > max[a] ? p[a] : max[a];
+	}
+  }
+  void Extend(const BoundingBox &b) {
+	Extend(b.min);
+	Extend(b.max);
+  }
+  bool IsEmpty() const { return min[0] > max[0]; }
+  Vec3 Size() const { return IsEmpty() ? Vec3{0, 0, 0} : max - min; }
+  float SurfaceArea() const {
+	Vec3 s = Size();
+	return 2.0f * (s[0] * s[1] + s[1] * s[2] + s[2] * s[0]);
+  }
+  bool Overlaps(const BoundingBox &b) const {
+	return min[0] <= b.max[0] && max[0] >= b.min[0] && min[1] <= b.max[1] && max[1] >= b.min[1]
+		&& min[2] <= b.max[2] && max[2] >= b.min[2];
+  }
+};
+
+// Indexed triangle mesh in Fusion's internal units (centimeters).
+struct Mesh {
+  std::vector<float> positions; // x, y, z per vertex
+  std::vector<uint32_t> indices; // three vertex indices per triangle
+
+  size_t VertexCount() const { return positions.size() / 3; }
+  size_t TriangleCount() const { return indices.size() / 3; }
+  bool Empty() const { return indices.empty(); }
+
+  Vec3 Vertex(uint32_t v) const { return {positions[3 * v], positions[3 * v + 1], positions[3 * v + 2]}; }
+  Vec3 Corner(size_t triangle, int corner) const { return Vertex(indices[3 * triangle + corner]); }
+  Vec3 FaceNormal(size_t triangle) const; // unit length, zero for degenerate triangles
+  float TriangleArea(size_t triangle) const;
+
+  BoundingBox Bounds() const;
+  void Clear() {
+	positions.clear();
+	indices.clear();
+  }
+};
+
+// Merges vertices with bit-identical coordinates. Fusion tessellates each B-Rep face separately, so
+// nodes along shared edges are duplicated; topology-aware stages need them merged first.
+void WeldVertices(Mesh &mesh);
+
+// Simplifies `mesh` by vertex clustering: the bounding box is cut into cubic cells, `cells` of them
+// along its longest side, every vertex moves to the mean of its cell and triangles that collapse
+// are dropped. Coarse but linear in the mesh size, which is all preview copies need.
+void ClusterVertices(Mesh &mesh, uint32_t cells);
+
+#endif //STLHELPER__EXPORTERMESH_H_
@@ -0,0 +1,79 @@
+#include "ExporterMeshPool.h"
+
+#include <mutex>
+#include <vector>
+
+namespace {
+constexpr size_t kClassCount = 40;
+
+// Size class holding meshes with an index capacity in [2^c, 2^(c+1)).
+size_t ClassOf(size_t capacity) {
+  size_t c = 0;
+  while (c + 1 < kClassCount && (size_t{2} << c) <= capacity)
+	++c;
+  return c;
+}
+
+size_t BytesOf(const Mesh &mesh) {
+  return mesh.positions.capacity() * sizeof(float) + mesh.indices.capacity() * sizeof(uint32_t);
+}
+}
+
+struct MeshPool::Shelf {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Mesh>> classes[kClassCount];
+  size_t bytes{0};
+  size_t maxBytes{0};
+
+  void Release(Mesh *mesh) {
+	std::unique_ptr<Mesh> owned(mesh);
+	owned->Clear();
+	const size_t size = BytesOf(*owned);
+	if (size == 0)
+	  return;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (bytes + size > maxBytes)
+	  return;
+	bytes += size;
+	classes[ClassOf(owned->indices.capacity())].push_back(std::move(owned));
+  }
+
+  std::unique_ptr<Mesh> Take(size_t indices) {
+	std::lock_guard<std::mutex> lock(mutex);
+	// The class holding `indices` may have meshes that are too small; beyond the next one up the
+	// buffers would sit mostly unused.
+	const size_t first = ClassOf(indices);
+	for (size_t c = first; c < kClassCount && c <= first + 1; ++c) {
+	  auto &meshes = classes[c];
+	  for (size_t i = meshes.size(); i-- > 0;) {
+		if (meshes[i]->indices.capacity() < indices)
+		  continue;
+		std::unique_ptr<Mesh> mesh = std::move(meshes[i]);
+		meshes[i] = std::move(meshes.back());
+		meshes.pop_back();
+		bytes -= BytesOf(*mesh);
+		return mesh;
+	  }
+	}
+	return std::make_unique<Mesh>();
+  }
+};
+
+MeshPool::MeshPool(size_t maxBytes) : m_shelf(std::make_shared<Shelf>()) {
+  m_shelf->maxBytes = maxBytes;
+}
+
+std::shared_ptr<Mesh> MeshPool::Acquire(size_t triangles, size_t vertices) {
+  std::unique_ptr<Mesh> mesh = m_shelf->Take(3 * triangles);
+  mesh->indices.reserve(3 * triangles);
+  mesh->positions.reserve(3 * vertices);
+  std::shared_ptr<Shelf> shelf = m_shelf;
+  return std::shared_ptr<Mesh>(mesh.release(), [shelf](Mesh *released) { shelf->Release(released); });
+}
+
+std::shared_ptr<Mesh> MeshPool::Copy(const Mesh &source) {
+  std::shared_ptr<Mesh> mesh = Acquire(source.TriangleCount(), source.VertexCount());
+  mesh->positions.assign(source.positions.begin(), source.positions.end());
+  mesh->indices.assign(source.indices.begin(), source.indices.end());
+  return mesh;
+}
@@ -0,0 +1,28 @@
+#ifndef STLHELPER__EXPORTERMESHPOOL_H_
+#define STLHELPER__EXPORTERMESHPOOL_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <memory>
+
+// Recycles mesh buffers between the bodies of one export run. Meshes handed out here return their
+// buffers to the pool when the last reference goes away, sorted into power-of-two size classes by
+// triangle capacity, and the next body of a similar size reuses them instead of allocating afresh.
+// Everything still pooled is freed in one go when the pool and the last mesh are gone, so a long
+// Fusion session does not keep the high-water mark of every export it ran.
+class MeshPool {
+ public:
+  explicit MeshPool(size_t maxBytes = size_t{256} << 20);
+
+  // An empty mesh with room for at least `triangles` triangles and `vertices` vertices.
+  std::shared_ptr<Mesh> Acquire(size_t triangles = 0, size_t vertices = 0);
+
+  std::shared_ptr<Mesh> Copy(const Mesh &source);
+
+ private:
+  struct Shelf;
+  std::shared_ptr<Shelf> m_shelf; // shared with the meshes, which may outlive the pool
+};
+
+#endif //STLHELPER__EXPORTERMESHPOOL_H_
@@ -0,0 +1,122 @@
+#include "ExporterMorton.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+constexpr int kRadixBits = 8;
+constexpr size_t kBuckets = size_t{1} << kRadixBits;
+constexpr size_t kMinChunk = 1 << 16;
+
+uint64_t SpreadBits(uint32_t v) {
+  uint64_t x = v & 0x1FFFFF;
+  x = (x | x << 32) & 0x1F00000000FFFFull;
+  x = (x | x << 16) & 0x1F0000FF0000FFull;
+  x = (x | x << 8) & 0x100F00F00F00F00Full;
+  x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+}
+
+uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z) {
+  return SpreadBits(x) | SpreadBits(y) << 1 | SpreadBits(z) << 2;
+}
+
+void RadixSort(std::vector<uint64_t> &keys, std::vector<uint32_t> &values, Parallelism parallelism) {
+  const size_t count = keys.size();
+  // Chunks are fixed up front (not handed out dynamically) so every chunk owns a histogram and the
+  // scatter offsets, and therefore the result, do not depend on thread timing.
+  const size_t chunks = std::max<size_t>(1, std::min(WorkerCount(), count / kMinChunk));
+  const size_t chunkSize = (count + chunks - 1) / chunks;
+  std::vector<uint64_t> keyBuffer(count);
+  std::vector<uint32_t> valueBuffer(count);
+  std::vector<size_t> histograms(chunks * kBuckets);
+
+  for (int shift = 0; shift < 64; shift += kRadixBits) {
+	std::fill(histograms.begin(), histograms.end(), size_t{0});
+	ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+	  for (size_t c = begin; c < end; ++c) {
+		size_t *histogram = &histograms[c * kBuckets];
+		for (size_t i = c * chunkSize, last = std::min(count, (c + 1) * chunkSize); i < last; ++i)
+		  ++histogram[(keys[i] >> shift) & (kBuckets - 1)];
+	  }
+	}, parallelism);
+
+	// Bucket-major, chunk-minor prefix sum keeps equal digits in input order.
+	size_t total = 0;
+	bool trivial = false;
+	for (size_t b = 0; b < kBuckets; ++b) {
+	  size_t bucket = 0;
+	  for (size_t c = 0; c < chunks; ++c) {
+		const size_t n = histograms[c * kBuckets + b];
+		histograms[c * kBuckets + b] = total + bucket;
+		bucket += n;
+	  }
+	  trivial |= bucket == count;
+	  total += bucket;
+	}
+	if (trivial)
+	  continue;
+
+	ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+	  for (size_t c = begin; c < end; ++c) {
+		size_t *offsets = &histograms[c * kBuckets];
+		for (size_t i = c * chunkSize, last = std::min(count, (c + 1) * chunkSize); i < last; ++i) {
+		  const size_t to = offsets[(keys[i] >> shift) & (kBuckets - 1)]++;
+		  keyBuffer[to] = keys[i];
+		  valueBuffer[to] = values[i];
+		}
+	  }
+	}, parallelism);
+	keys.swap(keyBuffer);
+	values.swap(valueBuffer);
+  }
+}
+
+void SortTrianglesByMorton(Mesh &mesh, Parallelism parallelism) {
+  const size_t triangles = mesh.TriangleCount();
+  if (triangles < 2)
+	return;
+  const BoundingBox box = mesh.Bounds();
+  const Vec3 size = box.Size();
+  const float longest = std::max(size[0], std::max(size[1], size[2]));
+  if (longest <= 0.0f)
+	return;
+  // One scale for all axes keeps the cells cubic; the centroid sum is three times the centroid.
+  constexpr uint32_t kMaxCell = (1u << 21) - 1;
+  const float scale = static_cast<float>(kMaxCell) / (3.0f * longest);
+
+  std::vector<uint64_t> keys(triangles);
+  std::vector<uint32_t> order(triangles);
+  std::iota(order.begin(), order.end(), 0u);
+  ParallelFor(triangles, 4096, [&](size_t begin, size_t end) {
+	for (size_t t = begin; t < end; ++t) {
+	  const Vec3 sum = mesh.Corner(t, 0) + mesh.Corner(t, 1) + mesh.Corner(t, 2);
+	  uint32_t cell[3];
+	  // rounding can carry the far corner one past the last cell, which would spill into other axes
+	  for (int a = 0; a < 3; ++a)
+		cell[a] = std::min(static_cast<uint32_t>(std::max(0.0f, (sum[a] - 3.0f * box.min[a]) * scale)), kMaxCell);
+	  keys[t] = MortonCode(cell[0], cell[1], cell[2]);
+	}
+  }, parallelism);
+  RadixSort(keys, order, parallelism);
+
+  const uint32_t kUnused = 0xFFFFFFFFu;
+  std::vector<uint32_t> remap(mesh.VertexCount(), kUnused);
+  std::vector<uint32_t> indices(mesh.indices.size());
+  std::vector<float> positions;
+  positions.reserve(mesh.positions.size());
+  for (size_t t = 0; t < triangles; ++t) {
+	for (int c = 0; c < 3; ++c) {
+	  const uint32_t v = mesh.indices[3 * size_t{order[t]} + c];
+	  if (remap[v] == kUnused) {
+		remap[v] = static_cast<uint32_t>(positions.size() / 3);
+		positions.insert(positions.end(), mesh.positions.begin() + 3 * size_t{v}, mesh.positions.begin() + 3 * size_t{v} + 3);
+	  }
+	  indices[3 * t + c] = remap[v];
+	}
+  }
+  mesh.positions.swap(positions);
+  mesh.indices.swap(indices);
+}
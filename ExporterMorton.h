@@ -0,0 +1,26 @@
+#ifndef STLHELPER__EXPORTERMORTON_H_
+#define STLHELPER__EXPORTERMORTON_H_
+#pragma once
+
+#include "ExporterMesh.h"
+#include "ExporterParallel.h"
+
+#include <cstdint>
+#include <vector>
+
+// Interleaves the low 21 bits of x, y and z into a 63 bit Morton (Z-order) code.
+uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+// Stable parallel LSD radix sort of `keys`, carrying `values` along. Passes whose byte is the same
+// for every key are skipped.
+void RadixSort(std::vector<uint64_t> &keys,
+			   std::vector<uint32_t> &values,
+			   Parallelism parallelism = Parallelism::Workers);
+
+// Reorders the triangles of `mesh` along the Morton curve through their centroids and renumbers the
+// vertices in order of first use, so neighbouring facets end up next to each other in the file.
+// Ties keep the original order, so identical meshes always produce identical output, also with
+// Parallelism::Serial.
+void SortTrianglesByMorton(Mesh &mesh, Parallelism parallelism = Parallelism::Workers);
+
+#endif //STLHELPER__EXPORTERMORTON_H_
@@ -0,0 +1,210 @@
+#include "ExporterNesting.h"
+#include "ExporterParallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+constexpr float kHalfPi = 1.57079632679f;
+
+float CrossZ(const Vec2 &o, const Vec2 &a, const Vec2 &b) {
+  return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
+
+// Convex hull of the XY projection (monotone chain).
+std::vector<Vec2> FootprintHull(const Mesh &mesh) {
+  std::vector<Vec2> points(mesh.VertexCount());
+  for (uint32_t v = 0; v < points.size(); ++v)
+	points[v] = {mesh.positions[3 * v], mesh.positions[3 * v + 1]};
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  if (points.size() < 3)
+	return points;
+  std::vector<Vec2> hull(2 * points.size());
+  size_t k = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+	while (k >= 2 && CrossZ(hull[k - 2], hull[k - 1], points[i]) <= 0.0f)
+	  --k;
+	hull[k++] = points[i];
+  }
+  for (size_t i = points.size() - 1, lower = k + 1; i > 0; --i) {
+	while (k >= lower && CrossZ(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0f)
+	  --k;
+	hull[k++] = points[i - 1];
+  }
+  hull.resize(k - 1);
+  return hull;
+}
+
+struct Footprint {
+  float angle{0.0f};
+  Vec2 min{0.0f, 0.0f};
+  Vec2 size{0.0f, 0.0f};
+};
+
+Footprint RotatedBounds(const std::vector<Vec2> &hull, float angle) {
+  const float c = std::cos(angle), s = std::sin(angle);
+  Vec2 lo{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+  Vec2 hi{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+  for (const auto &p : hull) {
+	const float x = p[0] * c - p[1] * s;
+	const float y = p[0] * s + p[1] * c;
+	lo = {std::min(lo[0], x), std::min(lo[1], y)};
+	hi = {std::max(hi[0], x), std::max(hi[1], y)};
+  }
+  if (hull.empty())
+	return {angle, {0, 0}, {0, 0}};
+  return {angle, lo, {hi[0] - lo[0], hi[1] - lo[1]}};
+}
+
+// Bottom-left skyline packer for one plate.
+class Skyline {
+ public:
+  Skyline(float width, float depth) : m_width(width), m_depth(depth), m_segments{{0.0f, 0.0f, width}} {}
+
+  // Lowest (then leftmost) position for a w x h rectangle; returns false if it does not fit.
+  bool Find(float w, float h, size_t &index, float &x, float &y) const {
+	float bestY = std::numeric_limits<float>::max(), bestX = bestY;
+	for (size_t i = 0; i < m_segments.size(); ++i) {
+	  const float left = m_segments[i].x;
+	  if (left + w > m_width)
+		break;
+	  float top = 0.0f;
+	  for (size_t j = i; j < m_segments.size() && m_segments[j].x < left + w; ++j)
+		top = std::max(top, m_segments[j].y);
+	  if (top + h > m_depth)
+		continue;
+	  if (top < bestY || (top == bestY && left < bestX)) {
+		bestY = top;
+		bestX = left;
+		index = i;
+	  }
+	}
+	x = bestX;
+	y = bestY;
+	return bestY != std::numeric_limits<float>::max();
+  }
+
+  void Place(size_t index, float x, float y, float w, float h) {
+	m_segments.insert(m_segments.begin() + index, Segment{x, y + h, w});
+	for (size_t j = index + 1; j < m_segments.size() && m_segments[j].x < x + w;) {
+	  const float shrink = x + w - m_segments[j].x;
+	  m_segments[j].x += shrink;
+	  m_segments[j].width -= shrink;
+	  if (m_segments[j].width > 0.0f)
+		break;
+	  m_segments.erase(m_segments.begin() + j);
+	}
+	for (size_t j = 0; j + 1 < m_segments.size();) {
+	  if (m_segments[j].y == m_segments[j + 1].y) {
+		m_segments[j].width += m_segments[j + 1].width;
+		m_segments.erase(m_segments.begin() + j + 1);
+	  } else {
+		++j;
+	  }
+	}
+  }
+
+ private:
+  struct Segment {
+	float x, y, width;
+  };
+  float m_width, m_depth;
+  std::vector<Segment> m_segments;
+};
+}
+
+PlateLayout ArrangeOnPlates(const std::vector<const Mesh *> &parts, const PlateOptions &options) {
+  PlateLayout layout;
+  const size_t count = parts.size();
+  const size_t steps = static_cast<size_t>(std::max(1, options.rotationSteps));
+
+  std::vector<std::vector<Vec2>> hulls(count);
+  ParallelFor(count, 1, [&](size_t begin, size_t end) {
+	for (size_t i = begin; i < end; ++i)
+	  hulls[i] = FootprintHull(*parts[i]);
+  });
+
+  // Every (part, rotation) pair is independent; keep the smallest rectangle per part.
+  std::vector<Footprint> candidates(count * steps);
+  ParallelFor(candidates.size(), 64, [&](size_t begin, size_t end) {
+	for (size_t i = begin; i < end; ++i)
+	  candidates[i] = RotatedBounds(hulls[i / steps], kHalfPi * static_cast<float>(i % steps) / steps);
+  });
+  std::vector<Footprint> footprints(count);
+  for (size_t p = 0; p < count; ++p) {
+	footprints[p] = *std::min_element(candidates.begin() + p * steps, candidates.begin() + (p + 1) * steps,
+									  [](const Footprint &a, const Footprint &b) {
+										return a.size[0] * a.size[1] < b.size[0] * b.size[1];
+									  });
+  }
+
+  std::vector<size_t> order(count);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+	const Vec2 &sa = footprints[a].size, &sb = footprints[b].size;
+	return std::max(sa[0], sa[1]) > std::max(sb[0], sb[1]);
+  });
+
+  // Spacing is added to every rectangle; shrinking the plate by the same amount keeps it at the edges too.
+  const float gap = options.spacing;
+  std::vector<Skyline> plates;
+  for (size_t p : order) {
+	const Footprint &f = footprints[p];
+	const float w = f.size[0] + gap, h = f.size[1] + gap;
+	bool placed = false;
+	for (size_t plate = 0; plate <= plates.size() && !placed; ++plate) {
+	  if (plate == plates.size())
+		plates.emplace_back(options.width - gap, options.depth - gap);
+	  size_t index[2] = {0, 0};
+	  float x[2], y[2];
+	  bool fits[2] = {plates[plate].Find(w, h, index[0], x[0], y[0]), plates[plate].Find(h, w, index[1], x[1], y[1])};
+	  if (!fits[0] && !fits[1])
+		continue;
+	  const int pick = fits[0] && (!fits[1] || y[0] <= y[1]) ? 0 : 1;
+	  plates[plate].Place(index[pick], x[pick], y[pick], pick ? h : w, pick ? w : h);
+
+	  PlacedPart placement;
+	  placement.part = p;
+	  placement.plate = static_cast<int>(plate);
+	  if (pick == 0) {
+		placement.angle = f.angle;
+		placement.offset = {gap + x[0] - f.min[0], gap + y[0] - f.min[1]};
+	  } else {
+		// a further quarter turn maps the rectangle's (x, y) to (-y, x)
+		placement.angle = f.angle + kHalfPi;
+		placement.offset = {gap + x[1] + f.min[1] + f.size[1], gap + y[1] - f.min[0]};
+	  }
+	  layout.placements.push_back(placement);
+	  placed = true;
+	}
+	if (!placed) {
+	  // The part did not fit on an empty plate either; drop that plate again.
+	  plates.pop_back();
+	  layout.oversized.push_back(p);
+	}
+  }
+  layout.plateCount = static_cast<int>(plates.size());
+  return layout;
+}
+
+void AppendPlacedPart(Mesh &plate, const Mesh &part, const PlacedPart &placement) {
+  const float c = std::cos(placement.angle), s = std::sin(placement.angle);
+  float minZ = std::numeric_limits<float>::max();
+  for (size_t i = 2; i < part.positions.size(); i += 3)
+	minZ = std::min(minZ, part.positions[i]);
+
+  const uint32_t base = static_cast<uint32_t>(plate.VertexCount());
+  plate.positions.reserve(plate.positions.size() + part.positions.size());
+  for (size_t i = 0; i < part.positions.size(); i += 3) {
+	const float x = part.positions[i], y = part.positions[i + 1];
+	plate.positions.push_back(x * c - y * s + placement.offset[0]);
+	plate.positions.push_back(x * s + y * c + placement.offset[1]);
+	plate.positions.push_back(part.positions[i + 2] - minZ);
+  }
+  plate.indices.reserve(plate.indices.size() + part.indices.size());
+  for (uint32_t i : part.indices)
+	plate.indices.push_back(base + i);
+}
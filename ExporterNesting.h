@@ -0,0 +1,40 @@
+#ifndef STLHELPER__EXPORTERNESTING_H_
+#define STLHELPER__EXPORTERNESTING_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <array>
+#include <vector>
+
+using Vec2 = std::array<float, 2>;
+
+struct PlateOptions {
+  float width{20.0f}; // centimeters
+  float depth{20.0f};
+  float spacing{0.5f}; // minimum gap between parts and between parts and the plate edge
+  int rotationSteps{30}; // candidate footprint rotations over a quarter turn
+};
+
+struct PlacedPart {
+  size_t part{0};
+  int plate{0};
+  float angle{0.0f}; // radians about +Z applied to the part before translating it
+  Vec2 offset{0.0f, 0.0f}; // translation applied after the rotation
+};
+
+struct PlateLayout {
+  std::vector<PlacedPart> placements;
+  std::vector<size_t> oversized; // parts whose footprint does not fit on an empty plate
+  int plateCount{0};
+};
+
+// Packs the XY footprints of `parts` onto as few plates as possible. Each footprint is reduced to
+// its tightest bounding rectangle over the candidate rotations (evaluated in parallel), and the
+// rectangles are placed bottom-left with a skyline packer, largest first.
+PlateLayout ArrangeOnPlates(const std::vector<const Mesh *> &parts, const PlateOptions &options);
+
+// Appends `part`, rotated and moved as described by `placement` and resting on Z = 0, to `plate`.
+void AppendPlacedPart(Mesh &plate, const Mesh &part, const PlacedPart &placement);
+
+#endif //STLHELPER__EXPORTERNESTING_H_
@@ -0,0 +1,169 @@
+#include "ExporterOrientation.h"
+#include "ExporterParallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Accumulators are spread over kLanes independent slots so the inner loops map onto SIMD registers
+// without relying on the compiler being allowed to reassociate floating point sums.
+constexpr size_t kLanes = 8;
+constexpr float kPi = 3.14159265358979f;
+constexpr float kFlatCosine = 0.9998f; // within about one degree of facing straight down
+
+// Facet data laid out as separate arrays, padded to a multiple of kLanes.
+struct FacetSoA {
+  std::vector<float> nx, ny, nz, cx, cy, cz, area;
+};
+struct PointSoA {
+  std::vector<float> x, y, z;
+};
+
+size_t Padded(size_t n) { return (n + kLanes - 1) / kLanes * kLanes; }
+
+std::vector<Vec3> CandidateDirections(int count) {
+  std::vector<Vec3> directions = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+  const float golden = kPi * (3.0f - std::sqrt(5.0f));
+  for (int i = 0; i < count; ++i) {
+	float z = 1.0f - 2.0f * (i + 0.5f) / count;
+	float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+	float phi = golden * i;
+	directions.push_back({r * std::cos(phi), r * std::sin(phi), z});
+  }
+  return directions;
+}
+
+struct Score {
+  float overhang{0.0f};
+  float contact{0.0f};
+  float height{0.0f};
+};
+
+Score Evaluate(const FacetSoA &facets, const PointSoA &points, const Vec3 &down, float supportCosine, float plateTolerance) {
+  float lo[kLanes], hi[kLanes];
+  std::fill(lo, lo + kLanes, std::numeric_limits<float>::max());
+  std::fill(hi, hi + kLanes, -std::numeric_limits<float>::max());
+  const float ux = -down[0], uy = -down[1], uz = -down[2];
+  for (size_t i = 0; i < points.x.size(); i += kLanes) {
+	for (size_t k = 0; k < kLanes; ++k) {
+	  float h = points.x[i + k] * ux + points.y[i + k] * uy + points.z[i + k] * uz;
+	  lo[k] = std::min(lo[k], h);
+	  hi[k] = std::max(hi[k], h);
+	}
+  }
+  const float base = *std::min_element(lo, lo + kLanes);
+  const float plate = base + plateTolerance;
+
+  float overhang[kLanes] = {}, contact[kLanes] = {};
+  for (size_t i = 0; i < facets.area.size(); i += kLanes) {
+	for (size_t k = 0; k < kLanes; ++k) {
+	  float c = facets.nx[i + k] * down[0] + facets.ny[i + k] * down[1] + facets.nz[i + k] * down[2];
+	  float h = facets.cx[i + k] * ux + facets.cy[i + k] * uy + facets.cz[i + k] * uz;
+	  float a = facets.area[i + k];
+	  overhang[k] += (c > supportCosine && h > plate) ? a : 0.0f;
+	  contact[k] += (c > kFlatCosine && h <= plate) ? a : 0.0f;
+	}
+  }
+  Score score;
+  for (size_t k = 0; k < kLanes; ++k) {
+	score.overhang += overhang[k];
+	score.contact += contact[k];
+  }
+  score.height = *std::max_element(hi, hi + kLanes) - base;
+  return score;
+}
+}
+
+Orientation FindBestOrientation(const Mesh &mesh, const OrientationOptions &options) {
+  Orientation best;
+  const size_t triangles = mesh.TriangleCount();
+  if (triangles == 0)
+	return best;
+
+  // Gather (a strided subset of) the facets and vertices into padded SoA arrays.
+  const size_t stride = std::max<size_t>(1, (triangles + options.maxScoredFacets - 1) / options.maxScoredFacets);
+  const size_t sampled = (triangles + stride - 1) / stride;
+  FacetSoA facets;
+  PointSoA points;
+  for (auto *v : {&facets.nx, &facets.ny, &facets.nz, &facets.cx, &facets.cy, &facets.cz, &facets.area})
+	v->assign(Padded(sampled), 0.0f);
+  const size_t vertexStride = std::max<size_t>(1, (mesh.VertexCount() + options.maxScoredFacets - 1) / options.maxScoredFacets);
+  const size_t sampledVertices = (mesh.VertexCount() + vertexStride - 1) / vertexStride;
+  for (auto *v : {&points.x, &points.y, &points.z})
+	v->assign(Padded(sampledVertices), 0.0f);
+  float totalArea = 0.0f;
+  for (size_t i = 0; i < sampled; ++i) {
+	const size_t t = i * stride;
+	Vec3 n = mesh.FaceNormal(t);
+	Vec3 c = (mesh.Corner(t, 0) + mesh.Corner(t, 1) + mesh.Corner(t, 2)) * (1.0f / 3.0f);
+	facets.nx[i] = n[0], facets.ny[i] = n[1], facets.nz[i] = n[2];
+	facets.cx[i] = c[0], facets.cy[i] = c[1], facets.cz[i] = c[2];
+	facets.area[i] = mesh.TriangleArea(t);
+	totalArea += facets.area[i];
+  }
+  for (size_t i = 0; i < points.x.size(); ++i) {
+	// padding repeats a real vertex so it never widens the height range
+	Vec3 p = mesh.Vertex(static_cast<uint32_t>(i < sampledVertices ? i * vertexStride : 0));
+	points.x[i] = p[0], points.y[i] = p[1], points.z[i] = p[2];
+  }
+  if (totalArea <= 0.0f)
+	return best;
+
+  Vec3 size = mesh.Bounds().Size();
+  const float diagonal = std::sqrt(Dot(size, size));
+  const float supportCosine = std::sin(options.overhangAngle * kPi / 180.0f);
+  const float plateTolerance = diagonal * 1e-4f;
+
+  const std::vector<Vec3> candidates = CandidateDirections(options.candidateCount);
+  std::vector<Orientation> results(candidates.size());
+  ParallelFor(candidates.size(), 8, [&](size_t begin, size_t end) {
+	for (size_t i = begin; i < end; ++i) {
+	  Score s = Evaluate(facets, points, candidates[i], supportCosine, plateTolerance);
+	  Orientation &o = results[i];
+	  o.down = candidates[i];
+	  o.overhangArea = s.overhang * stride;
+	  o.contactArea = s.contact * stride;
+	  o.buildHeight = s.height;
+	  o.score = options.overhangWeight * s.overhang / totalArea - options.contactWeight * s.contact / totalArea
+		  + options.heightWeight * s.height / diagonal;
+	}
+  });
+  // first minimum wins, so ties resolve to the axis-aligned candidates at the front
+  return *std::min_element(results.begin(), results.end(),
+						   [](const Orientation &a, const Orientation &b) { return a.score < b.score; });
+}
+
+void ApplyOrientation(Mesh &mesh, const Orientation &orientation) {
+  // Rotation taking `down` onto -Z (Rodrigues); the antiparallel case is a half turn about X.
+  const Vec3 a = orientation.down;
+  const Vec3 b{0, 0, -1};
+  float r[3][3];
+  const float c = Dot(a, b);
+  if (c < -0.9999f) {
+	const float flip[3][3] = {{1, 0, 0}, {0, -1, 0}, {0, 0, -1}};
+	std::copy(&flip[0][0], &flip[0][0] + 9, &r[0][0]);
+  } else {
+	const Vec3 v = Cross(a, b);
+	const float k = 1.0f / (1.0f + c);
+	const float vx[3][3] = {{0, -v[2], v[1]}, {v[2], 0, -v[0]}, {-v[1], v[0], 0}};
+	for (int i = 0; i < 3; ++i) {
+	  for (int j = 0; j < 3; ++j) {
+		float sq = 0.0f;
+		for (int m = 0; m < 3; ++m)
+		  sq += vx[i][m] * vx[m][j];
+		r[i][j] = (i == j ? 1.0f : 0.0f) + vx[i][j] + sq * k;
+	  }
+	}
+  }
+
+  float minZ = std::numeric_limits<float>::max();
+  for (size_t i = 0; i < mesh.positions.size(); i += 3) {
+	const Vec3 p{mesh.positions[i], mesh.positions[i + 1], mesh.positions[i + 2]};
+	for (int row = 0; row < 3; ++row)
+	  mesh.positions[i + row] = r[row][0] * p[0] + r[row][1] * p[1] + r[row][2] * p[2];
+	minZ = std::min(minZ, mesh.positions[i + 2]);
+  }
+  for (size_t i = 2; i < mesh.positions.size(); i += 3)
+	mesh.positions[i] -= minZ;
+}
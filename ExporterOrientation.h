@@ -0,0 +1,32 @@
+#ifndef STLHELPER__EXPORTERORIENTATION_H_
+#define STLHELPER__EXPORTERORIENTATION_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+struct OrientationOptions {
+  int candidateCount{512};
+  float overhangAngle{45.0f}; // degrees from vertical a surface may lean without support
+  float overhangWeight{1.0f};
+  float contactWeight{0.5f};
+  float heightWeight{0.25f};
+  size_t maxScoredFacets{1u << 16}; // larger meshes are scored on an evenly strided subset
+};
+
+struct Orientation {
+  Vec3 down{0, 0, -1}; // direction in the original model that ends up facing the build plate
+  float score{0.0f};
+  float overhangArea{0.0f}; // cm^2 needing support
+  float contactArea{0.0f}; // cm^2 resting on the build plate
+  float buildHeight{0.0f}; // cm
+};
+
+// Scores `candidateCount` directions spread evenly over the sphere (plus the six axes) in parallel
+// and returns the lowest scoring one: overhang area and build height count against a candidate,
+// flat contact with the build plate counts for it.
+Orientation FindBestOrientation(const Mesh &mesh, const OrientationOptions &options);
+
+// Rotates `mesh` so `orientation.down` points along -Z, then moves it to rest on Z = 0.
+void ApplyOrientation(Mesh &mesh, const Orientation &orientation);
+
+#endif //STLHELPER__EXPORTERORIENTATION_H_
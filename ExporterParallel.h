@@ -0,0 +1,51 @@
+#ifndef STLHELPER__EXPORTERPARALLEL_H_
+#define STLHELPER__EXPORTERPARALLEL_H_
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Number of worker threads used by the mesh processing stages.
+inline size_t WorkerCount() {
+  static const size_t count = std::max(1u, std::thread::hardware_concurrency());
+  return count;
+}
+
+// Whether a stage may spread over the worker threads. Stages running inside writer jobs pass
+// Serial: the writers already keep every core busy, and each nested ParallelFor would start a
+// full set of threads of its own.
+enum class Parallelism { Workers, Serial };
+
+// Calls fn(begin, end) on disjoint sub-ranges of [0, count) from all worker threads, or on the
+// calling thread alone with Parallelism::Serial. Ranges are handed out dynamically in blocks of
+// `grain` so uneven work per item still balances. Must not be called with Fusion API objects: the
+// API is only safe on the thread that invoked the add-in.
+template<typename Fn>
+void ParallelFor(size_t count, size_t grain, Fn &&fn, Parallelism parallelism = Parallelism::Workers) {
+  if (count == 0)
+	return;
+  grain = std::max<size_t>(grain, 1);
+  const size_t blocks = (count + grain - 1) / grain;
+  const size_t threads = parallelism == Parallelism::Serial ? 1 : std::min(WorkerCount(), blocks);
+  if (threads <= 1) {
+	fn(size_t{0}, count);
+	return;
+  }
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+	for (size_t b = next.fetch_add(1); b < blocks; b = next.fetch_add(1))
+	  fn(b * grain, std::min(count, (b + 1) * grain));
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t)
+	pool.emplace_back(worker);
+  worker();
+  for (auto &t : pool)
+	t.join();
+}
+
+#endif //STLHELPER__EXPORTERPARALLEL_H_
@@ -0,0 +1,841 @@
+#ifndef STLHELPER__EXPORTERPARAMETERS_H_
+#define STLHELPER__EXPORTERPARAMETERS_H_
+#pragma once
+
+#include "ExporterPlatform.h"
+#include "ExporterAnalysis.h"
+#include "ExporterNesting.h"
+#include "ExporterRules.h"
+#include "ExporterSettings.h"
+#include "ExporterSplit.h"
+#include "ExporterTargets.h"
+
+#include <Core/CoreAll.h>
+#include <Fusion/FusionAll.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <filesystem>
+namespace fs = std::filesystem;
+namespace ac = adsk::core;
+namespace af = adsk::fusion;
+
+static const char *const kDefaultSeparator{"_"};
+// Input names
+static const char *const kBodiesInput{"SEIBodies"};
+static const char *const kOutputFileSuffixInput{"SEIOutputFileSuffix"};
+static const char *const kOutputFileOverwriteInput{"SEIOutputFileOverwrite"};
+static const char *const kOutputFileSeparatorInput{"SEIOutputFileSeparator"};
+static const char *const kIncludeComponentNameInput{"SEIIncludeComponentName"};
+static const char *const kOutputFolderInput{"SEIOutputFolder"};
+static const char *const kOutputFolderTriggerInput{"SEIOutputFolderTrigger"};
+static const char *const kOutputFilePrefixInput{"SEIOutputFilePrefix"};
+static const char *const kMinimumWallThicknessInput{"SEIMinimumWallThickness"};
+static const char *const kCheckSelfIntersectionsInput{"SEICheckSelfIntersections"};
+static const char *const kOptimizeOrientationInput{"SEIOptimizeOrientation"};
+static const char *const kArrangeOnPlatesInput{"SEIArrangeOnPlates"};
+static const char *const kPlateWidthInput{"SEIPlateWidth"};
+static const char *const kPlateDepthInput{"SEIPlateDepth"};
+static const char *const kPlateSpacingInput{"SEIPlateSpacing"};
+static const char *const kSplitOversizedInput{"SEISplitOversized"};
+static const char *const kBuildHeightInput{"SEIBuildHeight"};
+static const char *const kDowelDiameterInput{"SEIDowelDiameter"};
+static const char *const kSortTrianglesInput{"SEISortTriangles"};
+static const char *const kAdditionalTargetsInput{"SEIAdditionalTargets"};
+static const char *const kVerifyFilesInput{"SEIVerifyFiles"};
+static const char *const kAsciiInput{"SEIAscii"};
+static const char *const kAsciiDigitsInput{"SEIAsciiDigits"};
+static const char *const kStoreFolderInput{"SEIStoreFolder"};
+static const char *const kThumbnailsInput{"SEIThumbnails"};
+static const char *const kMergeBodiesInput{"SEIMergeBodies"};
+static const char *const kCompareWithPreviousInput{"SEICompareWithPrevious"};
+static const char *const kChangeToleranceInput{"SEIChangeTolerance"};
+static const char *const kSkipUnchangedInput{"SEISkipUnchanged"};
+static const char *const kRefinementInput{"SEIRefinement"};
+static const char *const kPresetInput{"SEIPreset"};
+static const char *const kSavePresetInput{"SEISavePreset"};
+static const char *const kUseRulesInput{"SEIUseRules"};
+static const char *const kIncludeComponentsInput{"SEIIncludeComponents"};
+static const char *const kExcludeComponentsInput{"SEIExcludeComponents"};
+static const char *const kIncludeBodiesInput{"SEIIncludeBodies"};
+static const char *const kExcludeBodiesInput{"SEIExcludeBodies"};
+static const char *const kMaterialRuleInput{"SEIMaterialRule"};
+static const char *const kSubtreeRuleInput{"SEISubtreeRule"};
+static const char *const kVisibleOnlyInput{"SEIVisibleOnly"};
+
+// Attribute names
+static const char *const kAttributeGroup{"STLExporterAttributes"};
+static const char *const kAttributeSettings{"SEASettings"};
+static const char *const kAttributePresetPrefix{"SEAPreset:"}; // followed by the preset name
+// Attributes written before all settings moved into kAttributeSettings; read once for migration
+static const char *const kAttributeOutputFileSuffix{"SEAOutputFileSuffix"};
+static const char *const kAttributeOutputFilePrefix{"SEAOutputFilePrefix"};
+static const char *const kAttributeOutputFileSeparator{"SEAOutputFileSeparator"};
+static const char *const kAttributeOutputFolder{"SEAOutputFolder"};
+static const char *const kAttributeOverwrite{"SEAOverwrite"};
+static const char *const kAttributeIncludeComponentName{"SEAIncludeComponentName"};
+
+struct MeshQualityName {
+  af::TriangleMeshQualityOptions quality;
+  const char *name;
+};
+static const MeshQualityName kMeshQualities[] = {
+	{af::LowQualityTriangleMesh, "Low"},
+	{af::NormalQualityTriangleMesh, "Normal"},
+	{af::HighQualityTriangleMesh, "High"},
+	{af::VeryHighQualityTriangleMesh, "Very High"},
+};
+
+template<typename T>
+ac::Ptr<T> filterOnlyBRepBodies(ac::Ptr<T> selection) {
+  return selection && selection->objectType() == af::BRepBody::classType() ? selection : nullptr;
+}
+
+class ExporterParameters {
+
+ public:
+  std::string presetName; // set on parameters loaded from a preset
+  bool newerSettings{false}; // set by LoadFromAttributes if a newer version saved the design's settings
+  fs::path outputFolder{getDownloadsFolder()};
+  std::string outputFileSuffix;
+  std::string outputFilePrefix;
+  std::string outputFileSeparator{kDefaultSeparator};
+  std::vector<ac::Ptr<af::BRepBody>> bodies;
+  std::vector<std::string> bodyTokens; // saved selection; ResolveBodies turns it back into bodies
+  bool overwriteExistingFiles{true};
+  bool includeComponentName{true};
+  double minimumWallThickness{0.0}; // centimeters, zero disables the check
+  bool checkSelfIntersections{false};
+  bool optimizeOrientation{false};
+  bool arrangeOnPlates{false};
+  double plateWidth{20.0}; // centimeters
+  double plateDepth{20.0};
+  double plateSpacing{0.5};
+  bool splitOversized{false}; // cut bodies that do not fit the build volume into pieces that do
+  double buildHeight{20.0}; // centimeters; the build volume is plate width by plate depth by this
+  double dowelDiameter{0.0}; // alignment pin holes on the cut faces, zero for none
+  bool sortTriangles{false};
+  std::vector<OutputTarget> additionalTargets; // written alongside the primary STL, from one tessellation
+  bool verifyFiles{false}; // read every file back and compare it with what was written
+  bool asciiOutput{false}; // primary files as ASCII instead of binary STL
+  int asciiDigits{0}; // significant digits of ASCII numbers, 0 for exact
+  fs::path storeFolder; // content store the output files link to, empty to write them directly
+  bool thumbnails{false}; // a PNG preview next to each primary file
+  bool mergeBodies{false}; // union overlapping bodies and write everything as one mesh
+  bool compareWithPrevious{false}; // measure each body against the file it replaces and report the changes
+  double changeTolerance{0.001}; // centimeters; smaller deviations count as unchanged
+  bool skipUnchanged{false}; // keep the files of unchanged bodies instead of writing them again
+  af::TriangleMeshQualityOptions meshQuality{af::HighQualityTriangleMesh};
+  bool useRules{false}; // pick bodies with `rules` instead of the selection
+  SelectionRules rules;
+
+  bool Validate() const {
+	return !bodies.empty() && ValidateSettings() && IsFolderUsable(outputFolder);
+  }
+
+  // Everything Validate() checks except the selection and the file system.
+  bool ValidateSettings() const {
+	if (outputFolder.empty()) {
+	  return false;
+	}
+	for (auto &&target : additionalTargets) {
+	  if (target.folder.empty())
+		return false;
+	}
+	if (useRules && !RuleMatcher().Compile(rules)) {
+	  return false;
+	}
+	// parts keep the spacing to every plate edge, so a plate this small holds nothing
+	if (arrangeOnPlates && (plateWidth <= 2.0 * plateSpacing || plateDepth <= 2.0 * plateSpacing)) {
+	  return false;
+	}
+	return true;
+  }
+
+  static bool IsFolderUsable(const fs::path &folder) {
+	if (folder.empty()) {
+	  return false;
+	}
+	if (!fs::exists(folder)) {
+	  fs::path parent = folder;
+	  // allow us to create a folder if it doesn't exist
+	  while (!fs::exists(parent) && !parent.empty()) { parent = parent.parent_path(); }
+	  if (parent.empty()) {
+		return false;
+	  }
+	}
+	return true;
+  }
+
+  void Clear() {
+	outputFolder = getDownloadsFolder();
+	outputFileSuffix.clear();
+	outputFilePrefix.clear();
+	outputFileSeparator = "_";
+	bodies.clear();
+	bodyTokens.clear();
+	overwriteExistingFiles = true;
+	includeComponentName = true;
+	minimumWallThickness = 0.0;
+	checkSelfIntersections = false;
+	optimizeOrientation = false;
+	arrangeOnPlates = false;
+	plateWidth = 20.0;
+	plateDepth = 20.0;
+	plateSpacing = 0.5;
+	splitOversized = false;
+	buildHeight = 20.0;
+	dowelDiameter = 0.0;
+	sortTriangles = false;
+	additionalTargets.clear();
+	verifyFiles = false;
+	asciiOutput = false;
+	asciiDigits = 0;
+	storeFolder.clear();
+	thumbnails = false;
+	mergeBodies = false;
+	compareWithPrevious = false;
+	changeTolerance = 0.001;
+	skipUnchanged = false;
+	meshQuality = af::HighQualityTriangleMesh;
+	useRules = false;
+	rules = SelectionRules();
+  }
+
+  AnalysisOptions GetAnalysisOptions() const {
+	AnalysisOptions options;
+	options.minimumWallThickness = static_cast<float>(minimumWallThickness);
+	options.checkSelfIntersections = checkSelfIntersections;
+	return options;
+  }
+
+  PlateOptions GetPlateOptions() const {
+	PlateOptions options;
+	options.width = static_cast<float>(plateWidth);
+	options.depth = static_cast<float>(plateDepth);
+	options.spacing = static_cast<float>(plateSpacing);
+	return options;
+  }
+
+  // Pieces going onto build plates also have to leave the part spacing free on either side.
+  SplitOptions GetSplitOptions() const {
+	SplitOptions options;
+	const double margin = arrangeOnPlates ? 2.0 * plateSpacing : 0.0;
+	options.volume = {static_cast<float>(plateWidth - margin), static_cast<float>(plateDepth - margin),
+					  static_cast<float>(buildHeight)};
+	options.dowelDiameter = static_cast<float>(dowelDiameter);
+	return options;
+  }
+
+  // The content store with a relative folder resolved against the output folder; empty if unused.
+  fs::path GetStoreFolder() const {
+	if (storeFolder.empty() || storeFolder.is_absolute())
+	  return storeFolder;
+	return outputFolder / storeFolder;
+  }
+
+  // With rules enabled the selection is ignored and the bodies are collected from the design.
+  bool ApplyRules(const ac::Ptr<af::Design> &design) {
+	return !useRules || CollectBodies(design, rules, bodies);
+  }
+
+  // The primary target first, then the additional ones with relative folders resolved against it.
+  std::vector<OutputTarget> GetTargets() const {
+	std::vector<OutputTarget> targets;
+	targets.reserve(additionalTargets.size() + 1);
+	OutputTarget primary;
+	primary.folder = outputFolder;
+	primary.format = asciiOutput ? OutputFormat::AsciiSTL : OutputFormat::BinarySTL;
+	primary.digits = asciiDigits;
+	targets.push_back(primary);
+	for (auto &&target : additionalTargets) {
+	  targets.push_back(target);
+	  if (target.folder.is_relative())
+		targets.back().folder = outputFolder / target.folder;
+	}
+	return targets;
+  }
+
+  NameFields GetNameFields(const ac::Ptr<af::BRepBody> &body) const {
+	NameFields fields;
+	fields.prefix = outputFilePrefix;
+	fields.suffix = outputFileSuffix;
+	fields.separator = outputFileSeparator;
+	if (includeComponentName) {
+	  auto c = body->parentComponent();
+	  if (c)
+		fields.component = c->name();
+	}
+	fields.body = body->name();
+	return fields;
+  }
+
+  NameFields GetPlateNameFields(int plate) const {
+	NameFields fields;
+	fields.prefix = outputFilePrefix;
+	fields.suffix = outputFileSuffix;
+	fields.separator = outputFileSeparator;
+	fields.body = "Plate" + outputFileSeparator + std::to_string(plate + 1);
+	return fields;
+  }
+
+  NameFields GetMergedNameFields() const {
+	NameFields fields;
+	fields.prefix = outputFilePrefix;
+	fields.suffix = outputFileSuffix;
+	fields.separator = outputFileSeparator;
+	fields.body = "Merged";
+	return fields;
+  }
+
+  // `fields` of a body cut to fit the build volume, numbered per piece from 1.
+  NameFields GetPieceNameFields(NameFields fields, size_t piece) const {
+	fields.body += outputFileSeparator + "Part" + outputFileSeparator + std::to_string(piece + 1);
+	return fields;
+  }
+
+  // True if bodies are meshed here rather than handed to Fusion's export manager.
+  bool NeedsMesh() const {
+	return meshQuality == af::VeryHighQualityTriangleMesh
+		|| optimizeOrientation
+		|| arrangeOnPlates
+		|| splitOversized
+		|| sortTriangles
+		|| verifyFiles
+		|| !storeFolder.empty()
+		|| thumbnails
+		|| mergeBodies
+		|| compareWithPrevious
+		|| IsAnalysisEnabled(GetAnalysisOptions())
+		|| !additionalTargets.empty();
+  }
+
+  bool SaveToInputs(ac::Ptr<ac::CommandInputs> inputs) {
+	if (!inputs)
+	  return false;
+	ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
+	ac::Ptr<ac::StringValueCommandInput> outputFileSuffixInput = inputs->itemById(kOutputFileSuffixInput);
+	ac::Ptr<ac::StringValueCommandInput> outputFilePrefixInput = inputs->itemById(kOutputFilePrefixInput);
+	ac::Ptr<ac::StringValueCommandInput> outputFileSeparatorInput = inputs->itemById(kOutputFileSeparatorInput);
+	ac::Ptr<ac::TextBoxCommandInput> outputFolderInput = inputs->itemById(kOutputFolderInput);
+	ac::Ptr<ac::BoolValueCommandInput> outputOverwriteInput = inputs->itemById(kOutputFileOverwriteInput);
+	ac::Ptr<ac::BoolValueCommandInput> includeComponentNameInput = inputs->itemById(kIncludeComponentNameInput);
+	ac::Ptr<ac::ValueCommandInput> minimumWallThicknessInput = inputs->itemById(kMinimumWallThicknessInput);
+	ac::Ptr<ac::BoolValueCommandInput> checkSelfIntersectionsInput = inputs->itemById(kCheckSelfIntersectionsInput);
+	ac::Ptr<ac::BoolValueCommandInput> optimizeOrientationInput = inputs->itemById(kOptimizeOrientationInput);
+	ac::Ptr<ac::BoolValueCommandInput> arrangeOnPlatesInput = inputs->itemById(kArrangeOnPlatesInput);
+	ac::Ptr<ac::ValueCommandInput> plateWidthInput = inputs->itemById(kPlateWidthInput);
+	ac::Ptr<ac::ValueCommandInput> plateDepthInput = inputs->itemById(kPlateDepthInput);
+	ac::Ptr<ac::ValueCommandInput> plateSpacingInput = inputs->itemById(kPlateSpacingInput);
+	ac::Ptr<ac::BoolValueCommandInput> splitOversizedInput = inputs->itemById(kSplitOversizedInput);
+	ac::Ptr<ac::ValueCommandInput> buildHeightInput = inputs->itemById(kBuildHeightInput);
+	ac::Ptr<ac::ValueCommandInput> dowelDiameterInput = inputs->itemById(kDowelDiameterInput);
+	ac::Ptr<ac::BoolValueCommandInput> sortTrianglesInput = inputs->itemById(kSortTrianglesInput);
+	ac::Ptr<ac::TextBoxCommandInput> additionalTargetsInput = inputs->itemById(kAdditionalTargetsInput);
+	ac::Ptr<ac::BoolValueCommandInput> verifyFilesInput = inputs->itemById(kVerifyFilesInput);
+	ac::Ptr<ac::BoolValueCommandInput> asciiInput = inputs->itemById(kAsciiInput);
+	ac::Ptr<ac::IntegerSpinnerCommandInput> asciiDigitsInput = inputs->itemById(kAsciiDigitsInput);
+	ac::Ptr<ac::StringValueCommandInput> storeFolderInput = inputs->itemById(kStoreFolderInput);
+	ac::Ptr<ac::BoolValueCommandInput> thumbnailsInput = inputs->itemById(kThumbnailsInput);
+	ac::Ptr<ac::BoolValueCommandInput> mergeBodiesInput = inputs->itemById(kMergeBodiesInput);
+	ac::Ptr<ac::BoolValueCommandInput> compareWithPreviousInput = inputs->itemById(kCompareWithPreviousInput);
+	ac::Ptr<ac::ValueCommandInput> changeToleranceInput = inputs->itemById(kChangeToleranceInput);
+	ac::Ptr<ac::BoolValueCommandInput> skipUnchangedInput = inputs->itemById(kSkipUnchangedInput);
+	ac::Ptr<ac::DropDownCommandInput> refinementInput = inputs->itemById(kRefinementInput);
+	ac::Ptr<ac::BoolValueCommandInput> useRulesInput = inputs->itemById(kUseRulesInput);
+	ac::Ptr<ac::StringValueCommandInput> includeComponentsInput = inputs->itemById(kIncludeComponentsInput);
+	ac::Ptr<ac::StringValueCommandInput> excludeComponentsInput = inputs->itemById(kExcludeComponentsInput);
+	ac::Ptr<ac::StringValueCommandInput> includeBodiesInput = inputs->itemById(kIncludeBodiesInput);
+	ac::Ptr<ac::StringValueCommandInput> excludeBodiesInput = inputs->itemById(kExcludeBodiesInput);
+	ac::Ptr<ac::StringValueCommandInput> materialRuleInput = inputs->itemById(kMaterialRuleInput);
+	ac::Ptr<ac::StringValueCommandInput> subtreeRuleInput = inputs->itemById(kSubtreeRuleInput);
+	ac::Ptr<ac::BoolValueCommandInput> visibleOnlyInput = inputs->itemById(kVisibleOnlyInput);
+
+	if (bodiesInput) {
+	  bodiesInput->addSelectionFilter(ac::SelectionFilters::SolidBodies);
+	  bodiesInput->clearSelection();
+	  for (auto &&b : bodies) {
+		bodiesInput->addSelection(b);
+	  }
+	}
+	if (outputFileSuffixInput) {
+	  outputFileSuffixInput->value(outputFileSuffix);
+	}
+	if (outputFilePrefixInput) {
+	  outputFilePrefixInput->value(outputFilePrefix);
+	}
+	if (outputFileSeparatorInput) {
+	  outputFileSeparatorInput->value(outputFileSeparator);
+	}
+	if (outputFolderInput) {
+	  outputFolderInput->text(outputFolder.string());
+	}
+	if (outputOverwriteInput) {
+	  outputOverwriteInput->value(overwriteExistingFiles);
+	}
+	if (includeComponentNameInput) {
+	  includeComponentNameInput->value(includeComponentName);
+	}
+	if (minimumWallThicknessInput) {
+	  minimumWallThicknessInput->value(minimumWallThickness);
+	}
+	if (checkSelfIntersectionsInput) {
+	  checkSelfIntersectionsInput->value(checkSelfIntersections);
+	}
+	if (optimizeOrientationInput) {
+	  optimizeOrientationInput->value(optimizeOrientation);
+	}
+	if (arrangeOnPlatesInput) {
+	  arrangeOnPlatesInput->value(arrangeOnPlates);
+	}
+	if (plateWidthInput) {
+	  plateWidthInput->value(plateWidth);
+	}
+	if (plateDepthInput) {
+	  plateDepthInput->value(plateDepth);
+	}
+	if (plateSpacingInput) {
+	  plateSpacingInput->value(plateSpacing);
+	}
+	if (splitOversizedInput) {
+	  splitOversizedInput->value(splitOversized);
+	}
+	if (buildHeightInput) {
+	  buildHeightInput->value(buildHeight);
+	}
+	if (dowelDiameterInput) {
+	  dowelDiameterInput->value(dowelDiameter);
+	}
+	if (sortTrianglesInput) {
+	  sortTrianglesInput->value(sortTriangles);
+	}
+	if (additionalTargetsInput) {
+	  additionalTargetsInput->text(FormatTargets(additionalTargets));
+	}
+	if (verifyFilesInput) {
+	  verifyFilesInput->value(verifyFiles);
+	}
+	if (asciiInput) {
+	  asciiInput->value(asciiOutput);
+	}
+	if (asciiDigitsInput) {
+	  asciiDigitsInput->value(asciiDigits);
+	}
+	if (storeFolderInput) {
+	  storeFolderInput->value(storeFolder.string());
+	}
+	if (thumbnailsInput) {
+	  thumbnailsInput->value(thumbnails);
+	}
+	if (mergeBodiesInput) {
+	  mergeBodiesInput->value(mergeBodies);
+	}
+	if (compareWithPreviousInput) {
+	  compareWithPreviousInput->value(compareWithPrevious);
+	}
+	if (changeToleranceInput) {
+	  changeToleranceInput->value(changeTolerance);
+	}
+	if (skipUnchangedInput) {
+	  skipUnchangedInput->value(skipUnchanged);
+	}
+	if (refinementInput && refinementInput->listItems()) {
+	  auto items = refinementInput->listItems();
+	  for (size_t i = 0; i < items->count() && i < std::size(kMeshQualities); ++i) {
+		if (kMeshQualities[i].quality == meshQuality)
+		  items->item(i)->isSelected(true);
+	  }
+	}
+	if (useRulesInput) {
+	  useRulesInput->value(useRules);
+	}
+	if (includeComponentsInput) {
+	  includeComponentsInput->value(rules.includeComponents);
+	}
+	if (excludeComponentsInput) {
+	  excludeComponentsInput->value(rules.excludeComponents);
+	}
+	if (includeBodiesInput) {
+	  includeBodiesInput->value(rules.includeBodies);
+	}
+	if (excludeBodiesInput) {
+	  excludeBodiesInput->value(rules.excludeBodies);
+	}
+	if (materialRuleInput) {
+	  materialRuleInput->value(rules.material);
+	}
+	if (subtreeRuleInput) {
+	  subtreeRuleInput->value(rules.subtree);
+	}
+	if (visibleOnlyInput) {
+	  visibleOnlyInput->value(rules.visibleOnly);
+	}
+	return true;
+  }
+
+  bool LoadFromInputs(ac::Ptr<ac::CommandInputs> inputs) {
+	return LoadSettingsFromInputs(inputs) && LoadBodiesFromInputs(inputs);
+  }
+
+  bool LoadSettingsFromInputs(ac::Ptr<ac::CommandInputs> inputs) {
+	ac::Ptr<ac::StringValueCommandInput> outputFileSuffixInput = inputs->itemById(kOutputFileSuffixInput);
+	ac::Ptr<ac::StringValueCommandInput> outputFilePrefixInput = inputs->itemById(kOutputFilePrefixInput);
+	ac::Ptr<ac::StringValueCommandInput> outputFileSeparatorInput = inputs->itemById(kOutputFileSeparatorInput);
+	ac::Ptr<ac::TextBoxCommandInput> outputFolderInput = inputs->itemById(kOutputFolderInput);
+	ac::Ptr<ac::BoolValueCommandInput> outputOverwriteInput = inputs->itemById(kOutputFileOverwriteInput);
+	ac::Ptr<ac::BoolValueCommandInput> includeComponentNameInput = inputs->itemById(kIncludeComponentNameInput);
+	ac::Ptr<ac::ValueCommandInput> minimumWallThicknessInput = inputs->itemById(kMinimumWallThicknessInput);
+	ac::Ptr<ac::BoolValueCommandInput> checkSelfIntersectionsInput = inputs->itemById(kCheckSelfIntersectionsInput);
+	ac::Ptr<ac::BoolValueCommandInput> optimizeOrientationInput = inputs->itemById(kOptimizeOrientationInput);
+	ac::Ptr<ac::BoolValueCommandInput> arrangeOnPlatesInput = inputs->itemById(kArrangeOnPlatesInput);
+	ac::Ptr<ac::ValueCommandInput> plateWidthInput = inputs->itemById(kPlateWidthInput);
+	ac::Ptr<ac::ValueCommandInput> plateDepthInput = inputs->itemById(kPlateDepthInput);
+	ac::Ptr<ac::ValueCommandInput> plateSpacingInput = inputs->itemById(kPlateSpacingInput);
+	ac::Ptr<ac::BoolValueCommandInput> splitOversizedInput = inputs->itemById(kSplitOversizedInput);
+	ac::Ptr<ac::ValueCommandInput> buildHeightInput = inputs->itemById(kBuildHeightInput);
+	ac::Ptr<ac::ValueCommandInput> dowelDiameterInput = inputs->itemById(kDowelDiameterInput);
+	ac::Ptr<ac::BoolValueCommandInput> sortTrianglesInput = inputs->itemById(kSortTrianglesInput);
+	ac::Ptr<ac::TextBoxCommandInput> additionalTargetsInput = inputs->itemById(kAdditionalTargetsInput);
+	ac::Ptr<ac::BoolValueCommandInput> verifyFilesInput = inputs->itemById(kVerifyFilesInput);
+	ac::Ptr<ac::BoolValueCommandInput> asciiInput = inputs->itemById(kAsciiInput);
+	ac::Ptr<ac::IntegerSpinnerCommandInput> asciiDigitsInput = inputs->itemById(kAsciiDigitsInput);
+	ac::Ptr<ac::StringValueCommandInput> storeFolderInput = inputs->itemById(kStoreFolderInput);
+	ac::Ptr<ac::BoolValueCommandInput> thumbnailsInput = inputs->itemById(kThumbnailsInput);
+	ac::Ptr<ac::BoolValueCommandInput> mergeBodiesInput = inputs->itemById(kMergeBodiesInput);
+	ac::Ptr<ac::BoolValueCommandInput> compareWithPreviousInput = inputs->itemById(kCompareWithPreviousInput);
+	ac::Ptr<ac::ValueCommandInput> changeToleranceInput = inputs->itemById(kChangeToleranceInput);
+	ac::Ptr<ac::BoolValueCommandInput> skipUnchangedInput = inputs->itemById(kSkipUnchangedInput);
+	ac::Ptr<ac::DropDownCommandInput> refinementInput = inputs->itemById(kRefinementInput);
+	ac::Ptr<ac::BoolValueCommandInput> useRulesInput = inputs->itemById(kUseRulesInput);
+	ac::Ptr<ac::StringValueCommandInput> includeComponentsInput = inputs->itemById(kIncludeComponentsInput);
+	ac::Ptr<ac::StringValueCommandInput> excludeComponentsInput = inputs->itemById(kExcludeComponentsInput);
+	ac::Ptr<ac::StringValueCommandInput> includeBodiesInput = inputs->itemById(kIncludeBodiesInput);
+	ac::Ptr<ac::StringValueCommandInput> excludeBodiesInput = inputs->itemById(kExcludeBodiesInput);
+	ac::Ptr<ac::StringValueCommandInput> materialRuleInput = inputs->itemById(kMaterialRuleInput);
+	ac::Ptr<ac::StringValueCommandInput> subtreeRuleInput = inputs->itemById(kSubtreeRuleInput);
+	ac::Ptr<ac::BoolValueCommandInput> visibleOnlyInput = inputs->itemById(kVisibleOnlyInput);
+
+	if (!outputFolderInput || !outputFolderInput->isValid()) {
+	  return false;
+	}
+
+	outputFolder = outputFolderInput->text();
+	outputFileSuffix = outputFileSuffixInput ? outputFileSuffixInput->value() : outputFileSuffix;
+	outputFilePrefix = outputFilePrefixInput ? outputFilePrefixInput->value() : outputFilePrefix;
+	overwriteExistingFiles = outputOverwriteInput ? outputOverwriteInput->value() : overwriteExistingFiles;
+	includeComponentName = includeComponentNameInput ? includeComponentNameInput->value() : includeComponentName;
+	outputFileSeparator = outputFileSeparatorInput ? outputFileSeparatorInput->value() : outputFileSeparator;
+	minimumWallThickness = minimumWallThicknessInput ? minimumWallThicknessInput->value() : minimumWallThickness;
+	checkSelfIntersections = checkSelfIntersectionsInput ? checkSelfIntersectionsInput->value() : checkSelfIntersections;
+	optimizeOrientation = optimizeOrientationInput ? optimizeOrientationInput->value() : optimizeOrientation;
+	arrangeOnPlates = arrangeOnPlatesInput ? arrangeOnPlatesInput->value() : arrangeOnPlates;
+	plateWidth = plateWidthInput ? plateWidthInput->value() : plateWidth;
+	plateDepth = plateDepthInput ? plateDepthInput->value() : plateDepth;
+	plateSpacing = plateSpacingInput ? plateSpacingInput->value() : plateSpacing;
+	splitOversized = splitOversizedInput ? splitOversizedInput->value() : splitOversized;
+	buildHeight = buildHeightInput ? buildHeightInput->value() : buildHeight;
+	dowelDiameter = dowelDiameterInput ? dowelDiameterInput->value() : dowelDiameter;
+	sortTriangles = sortTrianglesInput ? sortTrianglesInput->value() : sortTriangles;
+	verifyFiles = verifyFilesInput ? verifyFilesInput->value() : verifyFiles;
+	asciiOutput = asciiInput ? asciiInput->value() : asciiOutput;
+	asciiDigits = asciiDigitsInput ? asciiDigitsInput->value() : asciiDigits;
+	storeFolder = storeFolderInput ? fs::path(storeFolderInput->value()) : storeFolder;
+	thumbnails = thumbnailsInput ? thumbnailsInput->value() : thumbnails;
+	mergeBodies = mergeBodiesInput ? mergeBodiesInput->value() : mergeBodies;
+	compareWithPrevious = compareWithPreviousInput ? compareWithPreviousInput->value() : compareWithPrevious;
+	changeTolerance = changeToleranceInput ? changeToleranceInput->value() : changeTolerance;
+	skipUnchanged = skipUnchangedInput ? skipUnchangedInput->value() : skipUnchanged;
+	if (refinementInput && refinementInput->selectedItem()) {
+	  const std::string name = refinementInput->selectedItem()->name();
+	  for (auto &&q : kMeshQualities)
+		if (name == q.name)
+		  meshQuality = q.quality;
+	}
+	useRules = useRulesInput ? useRulesInput->value() : useRules;
+	rules.includeComponents = includeComponentsInput ? includeComponentsInput->value() : rules.includeComponents;
+	rules.excludeComponents = excludeComponentsInput ? excludeComponentsInput->value() : rules.excludeComponents;
+	rules.includeBodies = includeBodiesInput ? includeBodiesInput->value() : rules.includeBodies;
+	rules.excludeBodies = excludeBodiesInput ? excludeBodiesInput->value() : rules.excludeBodies;
+	rules.material = materialRuleInput ? materialRuleInput->value() : rules.material;
+	rules.subtree = subtreeRuleInput ? subtreeRuleInput->value() : rules.subtree;
+	rules.visibleOnly = visibleOnlyInput ? visibleOnlyInput->value() : rules.visibleOnly;
+	if (additionalTargetsInput && !ParseTargets(additionalTargetsInput->text(), additionalTargets)) {
+	  return false;
+	}
+	return true;
+  }
+
+  bool LoadBodiesFromInputs(ac::Ptr<ac::CommandInputs> inputs) {
+	ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
+	if (!bodiesInput || !bodiesInput->isValid()) {
+	  return false;
+	}
+	bodies.clear();
+	AppendBodies(bodiesInput, 0);
+	return true;
+  }
+
+  // Resolves selections [first, selectionCount()) and appends the bodies among them.
+  void AppendBodies(const ac::Ptr<ac::SelectionCommandInput> &bodiesInput, int first) {
+	bodies.reserve(bodies.size() + bodiesInput->selectionCount() - first);
+	for (int i = first; i < bodiesInput->selectionCount(); ++i) {
+	  auto selection = bodiesInput->selection(i);
+	  ac::Ptr<af::BRepBody> body = selection ? filterOnlyBRepBodies(selection->entity()) : nullptr;
+	  if (body) {
+		bodies.emplace_back(std::move(body));
+	  }
+	}
+  }
+
+
+  void WriteSettings(SettingsBlob &blob) const {
+	blob.Set("folder", outputFolder.string());
+	blob.Set("suffix", outputFileSuffix);
+	blob.Set("prefix", outputFilePrefix);
+	blob.Set("separator", outputFileSeparator);
+	blob.Set("overwrite", overwriteExistingFiles);
+	blob.Set("component", includeComponentName);
+	blob.Set("wall", minimumWallThickness);
+	blob.Set("intersections", checkSelfIntersections);
+	blob.Set("orient", optimizeOrientation);
+	blob.Set("plates", arrangeOnPlates);
+	blob.Set("plateWidth", plateWidth);
+	blob.Set("plateDepth", plateDepth);
+	blob.Set("plateSpacing", plateSpacing);
+	blob.Set("split", splitOversized);
+	blob.Set("buildHeight", buildHeight);
+	blob.Set("dowelDiameter", dowelDiameter);
+	blob.Set("sort", sortTriangles);
+	blob.Set("targets", FormatTargets(additionalTargets));
+	blob.Set("verify", verifyFiles);
+	blob.Set("ascii", asciiOutput);
+	blob.Set("digits", static_cast<double>(asciiDigits));
+	blob.Set("store", storeFolder.string());
+	blob.Set("thumbnails", thumbnails);
+	blob.Set("merge", mergeBodies);
+	blob.Set("compare", compareWithPrevious);
+	blob.Set("changeTolerance", changeTolerance);
+	blob.Set("skipUnchanged", skipUnchanged);
+	for (auto &&q : kMeshQualities)
+	  if (q.quality == meshQuality)
+		blob.Set("quality", q.name);
+	blob.Set("rules", useRules);
+	blob.Set("includeComponents", rules.includeComponents);
+	blob.Set("excludeComponents", rules.excludeComponents);
+	blob.Set("includeBodies", rules.includeBodies);
+	blob.Set("excludeBodies", rules.excludeBodies);
+	blob.Set("material", rules.material);
+	blob.Set("subtree", rules.subtree);
+	blob.Set("visibleOnly", rules.visibleOnly);
+
+	std::string tokens;
+	if (bodies.empty()) {
+	  for (auto &&token : bodyTokens)
+		tokens += token + "\n";
+	} else {
+	  for (auto &&body : bodies)
+		tokens += body->entityToken() + "\n";
+	}
+	blob.Set("bodies", tokens);
+  }
+
+  void ReadSettings(const SettingsBlob &blob) {
+	std::string folder, targets, store;
+	if (blob.Get("folder", folder))
+	  outputFolder = folder;
+	blob.Get("suffix", outputFileSuffix);
+	blob.Get("prefix", outputFilePrefix);
+	blob.Get("separator", outputFileSeparator);
+	blob.Get("overwrite", overwriteExistingFiles);
+	blob.Get("component", includeComponentName);
+	blob.Get("wall", minimumWallThickness);
+	blob.Get("intersections", checkSelfIntersections);
+	blob.Get("orient", optimizeOrientation);
+	blob.Get("plates", arrangeOnPlates);
+	blob.Get("plateWidth", plateWidth);
+	blob.Get("plateDepth", plateDepth);
+	blob.Get("plateSpacing", plateSpacing);
+	blob.Get("split", splitOversized);
+	blob.Get("buildHeight", buildHeight);
+	blob.Get("dowelDiameter", dowelDiameter);
+	blob.Get("sort", sortTriangles);
+	if (blob.Get("targets", targets))
+	  ParseTargets(targets, additionalTargets);
+	blob.Get("verify", verifyFiles);
+	blob.Get("ascii", asciiOutput);
+	double digits = asciiDigits;
+	if (blob.Get("digits", digits))
+	  asciiDigits = std::clamp(static_cast<int>(digits), 0, kMaxAsciiDigits);
+	if (blob.Get("store", store))
+	  storeFolder = store;
+	blob.Get("thumbnails", thumbnails);
+	blob.Get("merge", mergeBodies);
+	blob.Get("compare", compareWithPrevious);
+	blob.Get("changeTolerance", changeTolerance);
+	blob.Get("skipUnchanged", skipUnchanged);
+	std::string quality;
+	if (blob.Get("quality", quality)) {
+	  for (auto &&q : kMeshQualities)
+		if (quality == q.name)
+		  meshQuality = q.quality;
+	}
+	blob.Get("rules", useRules);
+	blob.Get("includeComponents", rules.includeComponents);
+	blob.Get("excludeComponents", rules.excludeComponents);
+	blob.Get("includeBodies", rules.includeBodies);
+	blob.Get("excludeBodies", rules.excludeBodies);
+	blob.Get("material", rules.material);
+	blob.Get("subtree", rules.subtree);
+	blob.Get("visibleOnly", rules.visibleOnly);
+
+	std::string tokens;
+	if (blob.Get("bodies", tokens)) {
+	  bodyTokens.clear();
+	  for (size_t at = 0, next; at < tokens.size(); at = next + 1) {
+		next = tokens.find('\n', at);
+		if (next == std::string::npos)
+		  next = tokens.size();
+		if (next > at)
+		  bodyTokens.emplace_back(tokens, at, next - at);
+	  }
+	}
+  }
+
+  // Looks up the saved body tokens in `design` and replaces `bodies` with the ones still there.
+  // Tokens of deleted bodies are dropped. Returns the number of tokens dropped.
+  size_t ResolveBodies(const ac::Ptr<af::Design> &design) {
+	bodies.clear();
+	if (!design)
+	  return bodyTokens.size();
+	std::vector<std::string> kept;
+	kept.reserve(bodyTokens.size());
+	for (auto &&token : bodyTokens) {
+	  for (auto &&entity : design->findEntityByToken(token)) {
+		ac::Ptr<af::BRepBody> body = filterOnlyBRepBodies(entity);
+		if (body) {
+		  bodies.emplace_back(std::move(body));
+		  kept.push_back(token);
+		  break;
+		}
+	  }
+	}
+	const size_t dropped = bodyTokens.size() - kept.size();
+	bodyTokens.swap(kept);
+	return dropped;
+  }
+
+  // Writes all settings as one attribute, and only if they differ from what the design holds.
+  bool SaveToAttributes(ac::Ptr<ac::Attributes> attributes) {
+	if (!attributes)
+	  return false;
+	SettingsBlob blob;
+	WriteSettings(blob);
+	const std::string text = blob.Serialize();
+	auto settingsAttribute = attributes->itemByName(kAttributeGroup, kAttributeSettings);
+	if (settingsAttribute && settingsAttribute->value() == text)
+	  return true;
+	if (!settingsAttribute)
+	  DeleteLegacyAttributes(attributes);
+	return attributes->add(kAttributeGroup, kAttributeSettings, text) != nullptr;
+  }
+
+  bool SaveAsPreset(ac::Ptr<ac::Attributes> attributes, const std::string &name) const {
+	if (!attributes || name.empty())
+	  return false;
+	SettingsBlob blob;
+	WriteSettings(blob);
+	return attributes->add(kAttributeGroup, kAttributePresetPrefix + name, blob.Serialize()) != nullptr;
+  }
+
+  // All presets saved in `attributes`, with their bodies still unresolved.
+  static std::vector<ExporterParameters> LoadPresets(ac::Ptr<ac::Attributes> attributes) {
+	std::vector<ExporterParameters> presets;
+	if (!attributes)
+	  return presets;
+	const std::string prefix = kAttributePresetPrefix;
+	for (auto &&attribute : attributes->itemsByGroup(kAttributeGroup)) {
+	  if (!attribute)
+		continue;
+	  const std::string name = attribute->name();
+	  SettingsBlob blob;
+	  if (name.compare(0, prefix.size(), prefix) != 0 || !SettingsBlob::Parse(attribute->value(), blob)
+		  || !blob.Migrate())
+		continue;
+	  presets.emplace_back();
+	  presets.back().presetName = name.substr(prefix.size());
+	  presets.back().ReadSettings(blob);
+	}
+	return presets;
+  }
+
+  bool LoadFromAttributes(ac::Ptr<ac::Attributes> attributes) {
+	if (!attributes)
+	  return false;
+	auto settingsAttribute = attributes->itemByName(kAttributeGroup, kAttributeSettings);
+	SettingsBlob blob;
+	if (settingsAttribute && SettingsBlob::Parse(settingsAttribute->value(), blob)) {
+	  // settings a newer version saved are left alone rather than misread
+	  newerSettings = !blob.Migrate();
+	  if (newerSettings)
+		return false;
+	  ReadSettings(blob);
+	  return true;
+	}
+	return LoadFromLegacyAttributes(attributes);
+  }
+
+ private:
+  static void DeleteLegacyAttributes(const ac::Ptr<ac::Attributes> &attributes) {
+	static const char *const legacy[] = {
+		kAttributeOutputFileSuffix, kAttributeOutputFilePrefix, kAttributeOutputFileSeparator, kAttributeOutputFolder,
+		kAttributeOverwrite, kAttributeIncludeComponentName,
+	};
+	for (auto &&attribute : attributes->itemsByGroup(kAttributeGroup)) {
+	  if (!attribute)
+		continue;
+	  const std::string name = attribute->name();
+	  for (const char *legacyName : legacy) {
+		if (name == legacyName) {
+		  attribute->deleteMe();
+		  break;
+		}
+	  }
+	}
+  }
+
+  bool LoadFromLegacyAttributes(const ac::Ptr<ac::Attributes> &attributes) {
+	if (!attributes)
+	  return false;
+
+	auto outputFileSuffixAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFileSuffix);
+	if (outputFileSuffixAttribute)
+	  outputFileSuffix = outputFileSuffixAttribute->value();
+
+	auto outputFilePrefixAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFilePrefix);
+	if (outputFilePrefixAttribute)
+	  outputFilePrefix = outputFilePrefixAttribute->value();
+
+	auto outputFileSeparatorAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFileSeparator);
+	if (outputFileSeparatorAttribute)
+	  outputFileSeparator = outputFileSeparatorAttribute->value();
+
+	auto outputFolderAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFolder);
+	if (outputFolderAttribute)
+	  outputFolder = outputFolderAttribute->value();
+
+	auto outputOverwriteAttribute = attributes->itemByName(kAttributeGroup, kAttributeOverwrite);
+	if (outputOverwriteAttribute)
+	  overwriteExistingFiles = outputOverwriteAttribute->value() == "true";
+
+	auto includeComponentNameAttribute = attributes->itemByName(kAttributeGroup, kAttributeIncludeComponentName);
+	if (includeComponentNameAttribute)
+	  includeComponentName = includeComponentNameAttribute->value() == "true";
+
+	return true;
+  }
+};
+
+#endif //STLHELPER__EXPORTERPARAMETERS_H_
@@ -0,0 +1,745 @@
+#include "ExporterPipeline.h"
+#include "ExporterCommit.h"
+#include "ExporterDiff.h"
+#include "ExporterHash.h"
+#include "ExporterHistory.h"
+#include "ExporterIO.h"
+#include "ExporterJournal.h"
+#include "ExporterMerge.h"
+#include "ExporterMeshPool.h"
+#include "ExporterMorton.h"
+#include "ExporterOrientation.h"
+#include "ExporterSTLReader.h"
+#include "ExporterSplit.h"
+#include "ExporterStore.h"
+#include "ExporterTessellation.h"
+#include "ExporterThumbnail.h"
+#include "ExporterWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+namespace {
+using MeshPtr = std::shared_ptr<const Mesh>;
+const char *const kChangeReportFile = "changes.csv";
+
+std::string FormatMillimeters(double centimeters) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.2f mm", centimeters * 10.0);
+  return buffer;
+}
+
+void ShowError(const ac::Ptr<ac::UserInterface> &ui, const std::string &message) {
+  ui->messageBox(message,
+				 "Error",
+				 ac::MessageBoxButtonTypes::OKButtonType,
+				 ac::MessageBoxIconTypes::CriticalIconType);
+}
+
+// The outputs of one journaled body that are not committed yet. Each is counted when it is queued
+// and the export holds one count of its own until the body is fully queued, so the body is
+// recorded as done only once everything it produced is in place. A body with an output that
+// failed is never recorded and is exported again by a resumed run.
+struct BodyOutputs {
+  ExportJournal *journal{nullptr};
+  std::string token;
+  std::atomic<size_t> pending{1};
+  std::atomic<size_t> files{0};
+  std::atomic<bool> failed{false};
+
+  void Expect() {
+	++pending;
+	++files;
+  }
+
+  void Fail() { failed = true; }
+
+  void Release() {
+	if (--pending == 0 && !failed)
+	  journal->RecordBody(token, files);
+  }
+};
+using BodyOutputsPtr = std::shared_ptr<BodyOutputs>;
+
+// Records `file` as an output of `outputs`, if the body is journaled, once the committer has put it
+// in place.
+FileCommitter::Committed JournalEntry(const BodyOutputsPtr &outputs, const fs::path &file, uint64_t contentHash) {
+  if (!outputs)
+	return nullptr;
+  return [outputs, file, contentHash](uint64_t size) {
+	outputs->journal->Record(outputs->token, file, size, contentHash);
+	outputs->Release();
+  };
+}
+
+// Gives up on an expected output of `outputs`, if the body is journaled.
+void AbandonOutput(const BodyOutputsPtr &outputs) {
+  if (!outputs)
+	return;
+  outputs->Fail();
+  outputs->Release();
+}
+
+// Queues `mesh` for every target, counting the files and the thumbnail as outputs of `outputs` if
+// the body is journaled. Files are written under temporary names and handed to `committer`. With
+// a `store`, files already in it are linked instead of written again. Existing files, the
+// thumbnail included, are kept unless overwriting is on; the thumbnail is also left alone when the
+// first target's file beside it is kept. Returns the number of files queued.
+size_t QueueWrites(const ExporterParameters &params,
+				   const std::vector<OutputTarget> &targets,
+				   const NameFields &fields,
+				   const MeshPtr &mesh,
+				   const BodyOutputsPtr &outputs,
+				   const ContentStore *store,
+				   FileCommitter &committer,
+				   WriterPool &writers,
+				   const ac::Ptr<ac::UserInterface> &ui) {
+  size_t queued = 0;
+  bool keptFront = false; // the thumbnail belongs to the first target's file
+  for (auto &&target : targets) {
+	fs::path filePath = target.folder / TargetFileName(target, fields);
+	if (fs::exists(filePath) && !params.overwriteExistingFiles) {
+	  ShowError(ui, "File already exists: " + filePath.string());
+	  if (outputs)
+		outputs->Fail();
+	  keptFront = keptFront || &target == &targets.front();
+	  continue;
+	}
+	if (outputs)
+	  outputs->Expect();
+	const bool verify = params.verifyFiles;
+	writers.Submit([mesh, target, filePath, outputs, verify, store, &committer] {
+	  fs::path object;
+	  ContentStore::Key key{};
+	  if (store) {
+		key = ContentStore::KeyFor(*mesh, target);
+		object = store->ObjectPath(key, filePath.extension());
+		uint64_t hash = 0;
+		if (!store->ClaimWrite(key, hash)) {
+		  // another job queued the file; the link commits in its batch or a later one
+		  committer.Link(object, filePath, JournalEntry(outputs, filePath, hash));
+		  return true;
+		}
+		if (fs::exists(object)) {
+		  store->FinishWrite(key, false); // later claims find the file as well
+		  if (outputs && !HashFile(object, hash)) {
+			AbandonOutput(outputs);
+			committer.Link(object, filePath);
+		  } else {
+			committer.Link(object, filePath, JournalEntry(outputs, filePath, hash));
+		  }
+		  return true;
+		}
+		std::error_code ignored;
+		fs::create_directories(object.parent_path(), ignored);
+	  }
+	  const fs::path tempPath = FileCommitter::TempPathFor(store ? object : filePath);
+	  STLSummary summary;
+	  // a file that does not read back as written never replaces the previous one
+	  if (!WriteTarget(*mesh, target, tempPath, &summary) || (verify && !VerifyTarget(target, tempPath, summary))) {
+		std::error_code ignored;
+		fs::remove(tempPath, ignored);
+		if (store)
+		  store->FinishWrite(key, false);
+		AbandonOutput(outputs);
+		return false;
+	  }
+	  FileCommitter::Committed recorded = JournalEntry(outputs, filePath, summary.contentHash);
+	  if (store) {
+		committer.Add(tempPath, object);
+		store->FinishWrite(key, true, summary.contentHash);
+		committer.Link(object, filePath, std::move(recorded));
+	  } else {
+		committer.Add(tempPath, filePath, std::move(recorded));
+	  }
+	  return true;
+	}, filePath.string());
+	++queued;
+  }
+  if (params.thumbnails && !targets.empty() && !keptFront) {
+	fs::path imagePath = targets.front().folder / TargetFileName(targets.front(), fields);
+	imagePath.replace_extension(".png");
+	if (fs::exists(imagePath) && !params.overwriteExistingFiles) {
+	  ShowError(ui, "File already exists: " + imagePath.string());
+	  if (outputs)
+		outputs->Fail();
+	  return queued;
+	}
+	if (outputs)
+	  outputs->Expect();
+	writers.Submit([mesh, imagePath, outputs, &committer] {
+	  const fs::path tempPath = FileCommitter::TempPathFor(imagePath);
+	  uint64_t hash = 0;
+	  if (!WriteThumbnail(*mesh, tempPath) || (outputs && !HashFile(tempPath, hash))) {
+		std::error_code ignored;
+		fs::remove(tempPath, ignored);
+		AbandonOutput(outputs);
+		return false;
+	  }
+	  committer.Add(tempPath, imagePath, JournalEntry(outputs, imagePath, hash));
+	  return true;
+	}, imagePath.string());
+	++queued;
+  }
+  return queued;
+}
+
+void WritePlates(const ExporterParameters &params,
+				 const std::vector<OutputTarget> &targets,
+				 const std::vector<MeshPtr> &parts,
+				 const std::vector<NameFields> &partNames,
+				 const ContentStore *store,
+				 MeshPool &pool,
+				 FileCommitter &committer,
+				 WriterPool &writers,
+				 const ac::Ptr<ac::UserInterface> &ui) {
+  std::vector<const Mesh *> pointers;
+  pointers.reserve(parts.size());
+  for (auto &&part : parts)
+	pointers.push_back(part.get());
+  PlateLayout layout = ArrangeOnPlates(pointers, params.GetPlateOptions());
+
+  std::vector<size_t> plateTriangles(layout.plateCount), plateVertices(layout.plateCount);
+  for (auto &&placement : layout.placements) {
+	plateTriangles[placement.plate] += parts[placement.part]->TriangleCount();
+	plateVertices[placement.plate] += parts[placement.part]->VertexCount();
+  }
+  std::vector<std::shared_ptr<Mesh>> plates(layout.plateCount);
+  for (int i = 0; i < layout.plateCount; ++i)
+	plates[i] = pool.Acquire(plateTriangles[i], plateVertices[i]);
+  for (auto &&placement : layout.placements)
+	AppendPlacedPart(*plates[placement.plate], *parts[placement.part], placement);
+  if (params.sortTriangles) {
+	for (auto &&plate : plates)
+	  SortTrianglesByMorton(*plate);
+  }
+
+  for (int i = 0; i < layout.plateCount; ++i)
+	QueueWrites(params, targets, params.GetPlateNameFields(i), plates[i], nullptr, store, committer, writers, ui);
+
+  // Bodies larger than a plate still go out, one file each, so nothing silently goes missing.
+  if (layout.oversized.empty())
+	return;
+  std::string message = "These bodies do not fit on the build plate and were exported individually:\n\n";
+  for (size_t part : layout.oversized) {
+	QueueWrites(params, targets, partNames[part], parts[part], nullptr, store, committer, writers, ui);
+	message += TargetFileName(targets.front(), partNames[part]);
+	message += "\n";
+  }
+  ui->messageBox(message,
+				 "Build Plates",
+				 ac::MessageBoxButtonTypes::OKButtonType,
+				 ac::MessageBoxIconTypes::WarningIconType);
+}
+
+// One parameter set's share of a run.
+struct RunState {
+  const ExporterParameters *params{nullptr};
+  std::vector<OutputTarget> targets;
+  bool useExportManager{false};
+  AnalysisOptions analysisOptions;
+  std::string analysisReport;
+  std::vector<MeshPtr> plateParts;
+  std::vector<NameFields> platePartNames;
+  std::vector<MeshPtr> mergedParts; // written as one mesh unless they go on plates
+  std::vector<ac::Ptr<af::BRepBody>> bodies; // the selection, or the merged bodies
+  std::vector<BodyChange> changes; // bodies measured against the previous export
+  std::shared_ptr<const ContentStore> store; // shared by runs with the same store folder
+  ExportJournal journal; // only opened for runs that write one set of files per body
+  BodyOutputsPtr outputs; // of the body being exported, while it is journaled
+};
+
+af::MeshRefinementSettings ToMeshRefinement(af::TriangleMeshQualityOptions quality) {
+  switch (quality) {
+	case af::LowQualityTriangleMesh: return af::MeshRefinementLow;
+	case af::NormalQualityTriangleMesh: return af::MeshRefinementMedium;
+	default: return af::MeshRefinementHigh;
+  }
+}
+
+void ExportWithManager(RunState &state,
+					   const ac::Ptr<af::BRepBody> &body,
+					   const ac::Ptr<af::ExportManager> &exportManager,
+					   FileCommitter &committer,
+					   const ac::Ptr<ac::UserInterface> &ui) {
+  const ExporterParameters &params = *state.params;
+  const OutputTarget &target = state.targets.front();
+  fs::path filePath = target.folder / TargetFileName(target, params.GetNameFields(body));
+  if (fs::exists(filePath) && !params.overwriteExistingFiles) {
+	ShowError(ui, "File already exists: " + filePath.string());
+	if (state.outputs)
+	  state.outputs->Fail();
+	return;
+  }
+  const fs::path tempPath = FileCommitter::TempPathFor(filePath);
+  auto stlExportOptions = exportManager->createSTLExportOptions(body, tempPath.string());
+  stlExportOptions->sendToPrintUtility(false);
+  stlExportOptions->meshRefinement(ToMeshRefinement(params.meshQuality));
+  if (!exportManager->execute(stlExportOptions) || !fs::exists(tempPath)) {
+	std::error_code ignored;
+	fs::remove(tempPath, ignored);
+	ShowError(ui, "Failed to export: " + filePath.string());
+	if (state.outputs)
+	  state.outputs->Fail();
+	return;
+  }
+  uint64_t hash = 0;
+  if (state.outputs && !HashFile(tempPath, hash)) {
+	state.outputs->Fail();
+	committer.Add(tempPath, filePath);
+	return;
+  }
+  if (state.outputs)
+	state.outputs->Expect();
+  committer.Add(tempPath, filePath, JournalEntry(state.outputs, filePath, hash));
+}
+
+// Measures `mesh` against the primary file an earlier export left for it and adds the result to the
+// run's change report. Returns false if the body is unchanged and its files should be left alone.
+bool CompareWithPrevious(RunState &state, const NameFields &fields, const Mesh &mesh) {
+  const ExporterParameters &params = *state.params;
+  const OutputTarget &target = state.targets.front();
+  BodyChange change;
+  change.file = TargetFileName(target, fields);
+  change.triangles = mesh.TriangleCount();
+  Mesh previous;
+  if (!ReadSTL(target.folder / change.file, previous)) {
+	state.changes.push_back(std::move(change));
+	return true;
+  }
+  const float toCentimeters = 1.0f / UnitScale(target.units);
+  for (auto &&coordinate : previous.positions)
+	coordinate *= toCentimeters;
+  WeldVertices(previous); // each shared vertex is then measured once
+  change.previousTriangles = previous.TriangleCount();
+
+  // Below half the tolerance the exact distance no longer matters, which ends most searches early.
+  const float tolerance = static_cast<float>(params.changeTolerance);
+  change.difference = CompareMeshes(mesh, previous, 0.0f, tolerance * 0.5f);
+  const bool changed = change.difference.Hausdorff() > tolerance;
+  change.status = changed ? BodyChange::Status::Changed : BodyChange::Status::Unchanged;
+  change.leftOut = !changed && params.skipUnchanged;
+  const float toMillimeters = UnitScale(OutputUnits::Millimeters);
+  for (SurfaceDistance *side : {&change.difference.forward, &change.difference.backward}) {
+	side->distance *= toMillimeters;
+	side->where = side->where * toMillimeters;
+  }
+  state.changes.push_back(std::move(change));
+  return !state.changes.back().leftOut;
+}
+
+// Replaces the change report in the primary output folder through `committer`.
+void QueueChangeReport(const RunState &state, FileCommitter &committer, const ac::Ptr<ac::UserInterface> &ui) {
+  const fs::path path = state.targets.front().folder / kChangeReportFile;
+  const fs::path tempPath = FileCommitter::TempPathFor(path);
+  const std::string report = FormatChangeReport(state.changes);
+  OutputFile file;
+  if (!file.Open(tempPath, report.size()) || !file.Write(report.data(), report.size()) || !file.Close()) {
+	std::error_code ignored;
+	fs::remove(tempPath, ignored);
+	ShowError(ui, "Failed to write the change report: " + path.string());
+	return;
+  }
+  committer.Add(tempPath, path);
+}
+
+// One line per run that compared its bodies, naming the bodies that changed the most.
+std::string SummarizeChanges(const RunState &state) {
+  size_t added = 0, changed = 0, unchanged = 0, leftOut = 0;
+  const BodyChange *largest = nullptr;
+  for (auto &&change : state.changes) {
+	added += change.status == BodyChange::Status::Added;
+	changed += change.status == BodyChange::Status::Changed;
+	unchanged += change.status == BodyChange::Status::Unchanged;
+	leftOut += change.leftOut;
+	if (change.status == BodyChange::Status::Changed
+		&& (!largest || change.difference.Hausdorff() > largest->difference.Hausdorff()))
+	  largest = &change;
+  }
+  std::string summary = std::to_string(changed) + " changed, " + std::to_string(unchanged) + " unchanged";
+  if (leftOut > 0)
+	summary += " (" + std::to_string(leftOut) + " left as they were)";
+  summary += ", " + std::to_string(added) + " new.";
+  if (largest) {
+	summary += " Largest change: " + largest->file + ", up to ";
+	summary += FormatMillimeters(largest->difference.Hausdorff() / UnitScale(OutputUnits::Millimeters)) + ".";
+  }
+  return summary + "\n";
+}
+
+// Sorts `mesh` if asked to and queues it for writing, or for the build plates.
+void QueueMesh(RunState &state,
+			   NameFields fields,
+			   const std::shared_ptr<Mesh> &mesh,
+			   FileCommitter &committer,
+			   WriterPool &writers,
+			   const ac::Ptr<ac::UserInterface> &ui) {
+  const ExporterParameters &params = *state.params;
+  if (params.sortTriangles)
+	SortTrianglesByMorton(*mesh);
+  if (params.arrangeOnPlates) {
+	state.plateParts.emplace_back(mesh);
+	state.platePartNames.emplace_back(std::move(fields));
+	return;
+  }
+  if (params.compareWithPrevious && !CompareWithPrevious(state, fields, *mesh))
+	return;
+  QueueWrites(params, state.targets, fields, mesh, state.outputs, state.store.get(), committer,
+			  writers, ui);
+}
+
+// Runs the mesh stages of one parameter set on `base` and queues the result. `base` may be shared
+// with other parameter sets, so it is only changed in place when `exclusive` is set.
+void ExportMesh(RunState &state,
+				NameFields fields,
+				const std::shared_ptr<Mesh> &base,
+				bool exclusive,
+				MeshPool &pool,
+				FileCommitter &committer,
+				WriterPool &writers,
+				const ac::Ptr<ac::UserInterface> &ui) {
+  const ExporterParameters &params = *state.params;
+  std::shared_ptr<Mesh> mesh = base;
+  if (!exclusive && (params.optimizeOrientation || params.sortTriangles))
+	mesh = pool.Copy(*base);
+  if (params.optimizeOrientation)
+	ApplyOrientation(*mesh, FindBestOrientation(*mesh, OrientationOptions()));
+
+  if (IsAnalysisEnabled(state.analysisOptions)) {
+	AnalysisResult result = AnalyzeMesh(*mesh, state.analysisOptions);
+	if (result.IsFlagged()) {
+	  state.analysisReport += TargetFileName(state.targets.front(), fields);
+	  state.analysisReport += ":";
+	  if (result.IsThin()) {
+		state.analysisReport += " walls down to " + FormatMillimeters(result.minimumWallThickness);
+		state.analysisReport += " (" + std::to_string(static_cast<int>(100.0 * result.thinArea / result.totalArea + 0.5));
+		state.analysisReport += "% of the area is below " + FormatMillimeters(params.minimumWallThickness) + ")";
+	  }
+	  if (result.selfIntersections > 0) {
+		state.analysisReport += " " + std::to_string(result.selfIntersections) + " self-intersecting triangle pairs";
+	  }
+	  state.analysisReport += "\n";
+	}
+  }
+
+  // Cut in the orientation it is printed in; each piece then goes out like a body of its own.
+  if (params.splitOversized) {
+	const SplitOptions split = params.GetSplitOptions();
+	if (PlanSplit(mesh->Bounds(), split) != std::array<int, 3>{1, 1, 1}) {
+	  std::vector<Mesh> pieces = SplitToBuildVolume(*mesh, split);
+	  for (size_t i = 0; i < pieces.size(); ++i) {
+		std::shared_ptr<Mesh> piece = pool.Copy(pieces[i]);
+		pieces[i] = Mesh();
+		QueueMesh(state, params.GetPieceNameFields(fields, i), piece, committer, writers, ui);
+	  }
+	  return;
+	}
+  }
+  QueueMesh(state, std::move(fields), mesh, committer, writers, ui);
+}
+
+// True if an interrupted earlier run already wrote every output of the body with `token` for this
+// run, split pieces and thumbnails included.
+bool IsAlreadyExported(RunState &state, const std::string &token) {
+  return state.journal.IsOpen() && !token.empty() && state.journal.IsBodyDone(token);
+}
+
+// Settings a run is filed under in the export history. The body selection is left out, so runs of
+// the same options over other bodies still compare; several parameter sets are stored by preset.
+SettingsBlob HistorySettings(const std::vector<ExporterParameters> &runs) {
+  SettingsBlob settings;
+  for (auto &&params : runs) {
+	SettingsBlob blob;
+	params.WriteSettings(blob);
+	blob.Set("bodies", "");
+	if (runs.size() == 1)
+	  return blob;
+	settings.Set(params.presetName, blob.Serialize());
+  }
+  return settings;
+}
+
+void RecordHistory(const std::vector<ExporterParameters> &runs,
+				   const StageTimer &timer,
+				   uint32_t bodies,
+				   uint64_t triangles,
+				   uint64_t bytes) {
+  const SettingsBlob settings = HistorySettings(runs);
+  const std::string text = settings.Serialize();
+  StreamHash hash;
+  hash.Update(text.data(), text.size());
+
+  RunRecord record;
+  record.time = static_cast<int64_t>(std::time(nullptr));
+  record.settingsHash = hash.Value();
+  for (auto &&params : runs)
+	record.label += (record.label.empty() ? "" : ", ") + params.presetName;
+  if (auto app = ac::Application::get())
+	record.fusionVersion = app->version();
+  record.bodies = bodies;
+  record.triangles = triangles;
+  record.bytes = bytes;
+  record.seconds = timer.TotalSeconds();
+  record.stageSeconds = timer.Seconds();
+  ExportHistory().Append(record, settings);
+}
+}
+
+bool RunExport(const ExporterParameters &params,
+			   const ac::Ptr<af::Design> &design,
+			   const ac::Ptr<ac::UserInterface> &ui) {
+  return RunExports({params}, design, ui);
+}
+
+bool RunExports(const std::vector<ExporterParameters> &runs,
+				const ac::Ptr<af::Design> &design,
+				const ac::Ptr<ac::UserInterface> &ui) {
+  StageTimer timer;
+  std::vector<RunState> states(runs.size());
+  bool anyExportManager = false;
+  for (size_t r = 0; r < runs.size(); ++r) {
+	RunState &state = states[r];
+	state.params = &runs[r];
+	state.targets = runs[r].GetTargets();
+	state.analysisOptions = runs[r].GetAnalysisOptions();
+	for (auto &&target : state.targets) {
+	  if (!fs::exists(target.folder) && !fs::create_directories(target.folder)) {
+		ShowError(ui, "Invalid Output folder: " + target.folder.string());
+		return false;
+	  }
+	  FileCommitter::RemoveStaleTemps(target.folder);
+	}
+	if (!runs[r].storeFolder.empty()) {
+	  const fs::path storeFolder = runs[r].GetStoreFolder();
+	  for (size_t earlier = 0; earlier < r && !state.store; ++earlier) {
+		if (states[earlier].store && states[earlier].store->Folder() == storeFolder)
+		  state.store = states[earlier].store;
+	  }
+	  if (!state.store) {
+		auto store = std::make_shared<ContentStore>(storeFolder);
+		if (!store->Open()) {
+		  ShowError(ui, "Invalid content store folder: " + store->Folder().string());
+		  return false;
+		}
+		state.store = std::move(store);
+	  }
+	}
+	// The export manager can only write bodies where they sit, as plain STL in millimeters; anything
+	// else is meshed here once and fanned out to the targets.
+	state.useExportManager = !runs[r].NeedsMesh() && state.targets.size() == 1 && state.targets.front().IsNative()
+		&& state.targets.front().nameTemplate.empty();
+	anyExportManager |= state.useExportManager;
+
+	if (runs[r].mergeBodies) {
+	  size_t failed = 0;
+	  state.bodies = UnionOverlappingBodies(runs[r].bodies, failed);
+	  if (failed > 0)
+		ShowError(ui, std::to_string(failed) + " groups of overlapping bodies could not be merged and are written as separate pieces.");
+	} else {
+	  state.bodies = runs[r].bodies;
+	}
+
+	// Plates and merged files depend on every body at once, so only per-body outputs can be resumed.
+	if (!runs[r].arrangeOnPlates && !runs[r].mergeBodies) {
+	  SettingsBlob settings;
+	  runs[r].WriteSettings(settings);
+	  const std::string text = settings.Serialize();
+	  StreamHash runHash;
+	  runHash.Update(text.data(), text.size());
+	  state.journal.Open(state.targets.front().folder, runHash.Value());
+	}
+  }
+  auto exportManager = design->exportManager();
+  if (anyExportManager && !exportManager) {
+	ShowError(ui, "Export Manager not available");
+	return false;
+  }
+
+  // Bodies selected by several parameter sets are only visited once.
+  struct BodyUse {
+	ac::Ptr<af::BRepBody> body;
+	std::string token;
+	std::vector<size_t> runs;
+  };
+  std::vector<BodyUse> uses;
+  if (runs.size() == 1) {
+	const bool journaled = states.front().journal.IsOpen();
+	for (auto &&body : states.front().bodies)
+	  uses.push_back({body, journaled ? body->entityToken() : std::string(), {0}});
+  } else {
+	std::unordered_map<std::string, size_t> byToken;
+	for (size_t r = 0; r < runs.size(); ++r) {
+	  for (auto &&body : states[r].bodies) {
+		if (runs[r].mergeBodies) {
+		  uses.push_back({body, {}, {r}}); // merged bodies are temporary and belong to this run alone
+		  continue;
+		}
+		std::string token = body->entityToken();
+		auto inserted = byToken.emplace(token, uses.size());
+		if (inserted.second)
+		  uses.push_back({body, std::move(token), {}});
+		uses[inserted.first->second].runs.push_back(r);
+	  }
+	}
+  }
+
+  // Declared before the writers so queued jobs never outlive them.
+  MeshPool pool;
+  FileCommitter committer;
+  WriterPool writers;
+  std::vector<size_t> pending;
+  uint32_t bodiesExported = 0;
+  uint64_t trianglesMeshed = 0;
+  size_t lastTriangles = 0, lastVertices = 0; // bodies often come in runs of similar size
+  for (auto &&use : uses) {
+	pending.clear();
+	bool exported = false;
+	for (size_t r : use.runs) {
+	  if (IsAlreadyExported(states[r], use.token))
+		continue;
+	  exported = true;
+	  if (states[r].journal.IsOpen() && !use.token.empty()) {
+		states[r].outputs = std::make_shared<BodyOutputs>();
+		states[r].outputs->journal = &states[r].journal;
+		states[r].outputs->token = use.token;
+	  }
+	  if (states[r].useExportManager) {
+		timer.Enter(ExportStage::Tessellate);
+		ExportWithManager(states[r], use.body, exportManager, committer, ui);
+	  } else {
+		pending.push_back(r);
+	  }
+	}
+	bodiesExported += exported ? 1 : 0;
+
+	// One tessellation per distinct quality; coarser targets are decimated on the writer threads.
+	while (!pending.empty()) {
+	  const af::TriangleMeshQualityOptions quality = runs[pending.front()].meshQuality;
+	  std::vector<size_t> group;
+	  for (size_t r : pending)
+		if (runs[r].meshQuality == quality)
+		  group.push_back(r);
+	  pending.erase(std::remove_if(pending.begin(), pending.end(),
+								   [&](size_t r) { return runs[r].meshQuality == quality; }),
+					pending.end());
+
+	  std::shared_ptr<Mesh> base = pool.Acquire(lastTriangles, lastVertices);
+	  timer.Enter(ExportStage::Tessellate);
+	  const bool tessellated = TessellateBody(use.body, quality, *base);
+	  timer.Enter(ExportStage::Process);
+	  trianglesMeshed += base->TriangleCount();
+	  lastTriangles = base->TriangleCount();
+	  lastVertices = base->VertexCount();
+	  if (!tessellated) {
+		for (size_t r : group) {
+		  const OutputTarget &target = states[r].targets.front();
+		  ShowError(ui, "Failed to export: " + (target.folder / TargetFileName(target, runs[r].GetNameFields(use.body))).string());
+		  if (states[r].outputs)
+			states[r].outputs->Fail();
+		}
+		continue;
+	  }
+	  bool shared = false; // an earlier parameter set queued or kept `base` itself
+	  for (size_t i = 0; i < group.size(); ++i) {
+		const ExporterParameters &params = runs[group[i]];
+		RunState &state = states[group[i]];
+		if (params.mergeBodies && !params.arrangeOnPlates) {
+		  // the pieces are oriented and sorted together once they are one mesh
+		  state.mergedParts.push_back(base);
+		  shared = true;
+		  continue;
+		}
+		const NameFields fields = params.mergeBodies ? params.GetMergedNameFields() : params.GetNameFields(use.body);
+		ExportMesh(state, fields, base, i + 1 == group.size() && !shared, pool, committer, writers, ui);
+		shared |= !params.optimizeOrientation && !params.sortTriangles;
+	  }
+	}
+
+	// everything of this body is queued; it is done once the committer has put the last piece in place
+	for (size_t r : use.runs) {
+	  if (states[r].outputs) {
+		states[r].outputs->Release();
+		states[r].outputs.reset();
+	  }
+	}
+  }
+  timer.Enter(ExportStage::Process);
+  for (auto &&state : states) {
+	if (state.mergedParts.empty())
+	  continue;
+	size_t triangles = 0, vertices = 0;
+	for (auto &&part : state.mergedParts) {
+	  triangles += part->TriangleCount();
+	  vertices += part->VertexCount();
+	}
+	std::shared_ptr<Mesh> merged = pool.Acquire(triangles, vertices);
+	for (auto &&part : state.mergedParts)
+	  AppendMesh(*merged, *part);
+	state.mergedParts.clear();
+	ExportMesh(state, state.params->GetMergedNameFields(), merged, true, pool, committer, writers, ui);
+  }
+  for (auto &&state : states) {
+	if (!state.plateParts.empty())
+	  WritePlates(*state.params, state.targets, state.plateParts, state.platePartNames,
+				  state.store.get(), pool, committer, writers, ui);
+  }
+
+  for (auto &&state : states) {
+	if (!state.changes.empty())
+	  QueueChangeReport(state, committer, ui);
+  }
+
+  timer.Enter(ExportStage::Write);
+  std::vector<std::string> failed = writers.Wait();
+  timer.Enter(ExportStage::Commit);
+  for (auto &&filePath : committer.Commit())
+	failed.push_back(filePath);
+  for (auto &&filePath : failed)
+	ShowError(ui, "Failed to export: " + filePath);
+  for (auto &&state : states)
+	state.journal.Finish(failed.empty());
+  // Replaced links dropped the reference counts of the files they pointed to.
+  std::set<fs::path> stores;
+  for (auto &&state : states) {
+	if (state.store && stores.insert(state.store->Folder()).second)
+	  state.store->CollectGarbage();
+  }
+  // Failed runs and runs with nothing left to do would only skew the comparison.
+  if (failed.empty() && bodiesExported > 0)
+	RecordHistory(runs, timer, bodiesExported, trianglesMeshed, committer.BytesCommitted());
+
+  std::string analysisReport;
+  for (auto &&state : states) {
+	if (state.analysisReport.empty())
+	  continue;
+	if (!state.params->presetName.empty())
+	  analysisReport += state.params->presetName + "\n";
+	analysisReport += state.analysisReport;
+  }
+  std::string changeReport;
+  for (auto &&state : states) {
+	if (state.changes.empty())
+	  continue;
+	if (!state.params->presetName.empty())
+	  changeReport += state.params->presetName + ": ";
+	changeReport += SummarizeChanges(state);
+  }
+  if (!changeReport.empty()) {
+	ui->messageBox("Compared with the previous export:\n\n" + changeReport + "\nDetails are in " + kChangeReportFile + ".",
+				   "Changes",
+				   ac::MessageBoxButtonTypes::OKButtonType,
+				   ac::MessageBoxIconTypes::InformationIconType);
+  }
+  if (!analysisReport.empty()) {
+	ui->messageBox("Some bodies may not print reliably:\n\n" + analysisReport,
+				   "Printability Check",
+				   ac::MessageBoxButtonTypes::OKButtonType,
+				   ac::MessageBoxIconTypes::WarningIconType);
+  }
+  return failed.empty();
+}
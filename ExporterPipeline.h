@@ -0,0 +1,20 @@
+#ifndef STLHELPER__EXPORTERPIPELINE_H_
+#define STLHELPER__EXPORTERPIPELINE_H_
+#pragma once
+
+#include "ExporterParameters.h"
+
+// Exports `params.bodies` to every output target. Each body is tessellated once on the main thread
+// and the finished mesh is handed to writer threads for all targets; when only a plain STL is
+// wanted the export manager writes it directly. Problems are reported through `ui`.
+bool RunExport(const ExporterParameters &params,
+			   const ac::Ptr<af::Design> &design,
+			   const ac::Ptr<ac::UserInterface> &ui);
+
+// Exports several parameter sets in one pass. Bodies they share are tessellated once per distinct
+// mesh quality and every set's outputs are written from that tessellation.
+bool RunExports(const std::vector<ExporterParameters> &runs,
+				const ac::Ptr<af::Design> &design,
+				const ac::Ptr<ac::UserInterface> &ui);
+
+#endif //STLHELPER__EXPORTERPIPELINE_H_
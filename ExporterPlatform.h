@@ -4,10 +4,21 @@
 #include <filesystem>
 namespace fs = std::filesystem;
 
+#include <charconv>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
 #ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
 #include <combaseapi.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 enum class KnownFolders {
@@ -15,10 +26,11 @@ enum class KnownFolders {
   Downloads,
   Documents,
   Desktop,
+  AppData, // per-user, per-machine application data
 };
 
 #ifdef _WIN32
-REFKNOWNFOLDERID getKnownFolderId(KnownFolders folder) {
+inline REFKNOWNFOLDERID getKnownFolderId(KnownFolders folder) {
 		switch (folder) {
 			case KnownFolders::Home:
 				return FOLDERID_Profile;
@@ -28,11 +40,13 @@ REFKNOWNFOLDERID getKnownFolderId(KnownFolders folder) {
 				return FOLDERID_Documents;
 			case KnownFolders::Desktop:
 				return FOLDERID_Desktop;
+			case KnownFolders::AppData:
+				return FOLDERID_LocalAppData;
 			default:
 				throw std::runtime_error("Unknown known folder.");
 		}
 	}
-	fs::path getKnownFolderPath(REFKNOWNFOLDERID folderId) {
+	inline fs::path getKnownFolderPath(REFKNOWNFOLDERID folderId) {
 		PWSTR path = NULL;
 		HRESULT result = SHGetKnownFolderPath(folderId, 0, NULL, &path);
 
@@ -46,7 +60,7 @@ REFKNOWNFOLDERID getKnownFolderId(KnownFolders folder) {
 	}
 #endif
 
-fs::path getKnownFolderPath(KnownFolders folder) {
+inline fs::path getKnownFolderPath(KnownFolders folder) {
 #ifdef _WIN32
   return getKnownFolderPath(getKnownFolderId(folder));
 #else
@@ -56,25 +70,155 @@ fs::path getKnownFolderPath(KnownFolders folder) {
 	case KnownFolders::Downloads: return home / "Downloads";
 	case KnownFolders::Documents: return home / "Documents";
 	case KnownFolders::Desktop: return home / "Desktop";
+#ifdef __APPLE__
+	case KnownFolders::AppData: return home / "Library" / "Application Support";
+#else
+	case KnownFolders::AppData: {
+	  const char *data = std::getenv("XDG_DATA_HOME");
+	  return data && *data ? fs::path(data) : home / ".local" / "share";
+	}
+#endif
 	default: throw std::runtime_error("Unknown known folder.");
   }
 #endif
 }
 
-fs::path getHomeFolder() {
+inline fs::path getHomeFolder() {
   return getKnownFolderPath(KnownFolders::Home);
 }
 
-fs::path getDownloadsFolder() {
+inline fs::path getDownloadsFolder() {
   return getKnownFolderPath(KnownFolders::Downloads);
 }
 
-fs::path getDocumentsFolder() {
+inline fs::path getDocumentsFolder() {
   return getKnownFolderPath(KnownFolders::Documents);
 }
 
-fs::path getDesktopFolder() {
+inline fs::path getDesktopFolder() {
   return getKnownFolderPath(KnownFolders::Desktop);
 }
 
+inline fs::path getAppDataFolder() {
+  return getKnownFolderPath(KnownFolders::AppData);
+}
+
+// Opens `path` with a C stdio `mode`; paths are wide on Windows.
+inline std::FILE *openFile(const fs::path &path, const char *mode) {
+#ifdef _WIN32
+  std::wstring wideMode(mode, mode + std::strlen(mode));
+  return _wfopen(path.c_str(), wideMode.c_str());
+#else
+  return std::fopen(path.c_str(), mode);
+#endif
+}
+
+// Pushes everything written to `file` through the C library and the OS cache to the device.
+inline bool syncFile(std::FILE *file) {
+  if (std::fflush(file) != 0)
+	return false;
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+#ifdef F_FULLFSYNC
+  // plain fsync on macOS leaves the data in the drive's cache
+  if (fcntl(fileno(file), F_FULLFSYNC) == 0)
+	return true;
+#endif
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Flushes a file that was already written and closed.
+inline bool syncPath(const fs::path &path) {
+  std::FILE *file = openFile(path, "r+b");
+  if (!file)
+	return false;
+  const bool synced = syncFile(file);
+  std::fclose(file);
+  return synced;
+}
+
+#ifdef __linux__
+// Flushes every dirty file on the file system holding `path` with a single syncfs call.
+inline bool syncFileSystem(const fs::path &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+	return false;
+  const bool synced = syncfs(fd) == 0;
+  close(fd);
+  return synced;
+}
+#endif
+
+// Makes renames inside `folder` durable. Windows has no directory sync; replaceFile asks for
+// write-through there instead.
+inline bool syncFolder(const fs::path &folder) {
+#ifdef _WIN32
+  return true;
+#else
+  int fd = open(folder.c_str(), O_RDONLY);
+  if (fd < 0)
+	return false;
+  const bool synced = fsync(fd) == 0;
+  close(fd);
+  return synced;
+#endif
+}
+
+// Atomically replaces `to` with `from`; both must be on the same volume.
+inline bool replaceFile(const fs::path &from, const fs::path &to) {
+#ifdef _WIN32
+  return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// Parses the number at the start of [first, last) the way std::from_chars does, whatever the
+// C locale: '.' is the decimal point and there is no leading whitespace or '+'. Returns the end of
+// the number, or nullptr if there is none. Apple's libc++ only gained floating-point from_chars
+// in LLVM 20, so without it the text goes to strtod with the locale's decimal point swapped in.
+template<typename T>
+inline const char *parseNumber(const char *first, const char *last, T &value) {
+  static_assert(std::is_floating_point_v<T>);
+#if defined(__cpp_lib_to_chars)
+  auto result = std::from_chars(first, last, value);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+  if (first == last || *first == '+')
+	return nullptr;
+  const char *point = std::localeconv()->decimal_point;
+  const size_t pointLength = std::strlen(point);
+  char buffer[64];
+  size_t length = 0;
+  size_t pointAt = sizeof(buffer); // where the decimal point went in `buffer`, if anywhere
+  for (const char *at = first; at < last && length + pointLength < sizeof(buffer) - 1; ++at) {
+	if (*at == '.' && pointAt == sizeof(buffer)) {
+	  pointAt = length;
+	  std::memcpy(buffer + length, point, pointLength);
+	  length += pointLength;
+	} else if ((*at >= '0' && *at <= '9') || *at == '-' || *at == 'e' || *at == 'E') {
+	  buffer[length++] = *at;
+	} else {
+	  break;
+	}
+  }
+  buffer[length] = '\0';
+  char *end = nullptr;
+  T parsed;
+  if constexpr (std::is_same_v<T, float>)
+	parsed = std::strtof(buffer, &end);
+  else
+	parsed = static_cast<T>(std::strtod(buffer, &end));
+  if (end == buffer)
+	return nullptr;
+  size_t used = static_cast<size_t>(end - buffer);
+  if (used > pointAt)
+	used -= pointLength - 1;
+  value = parsed;
+  return first + used;
+#endif
+}
+
 #endif //STLHELPER__EXPORTER_PLATFORM_H_
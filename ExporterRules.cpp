@@ -0,0 +1,133 @@
+#include "ExporterRules.h"
+
+#include <unordered_set>
+
+namespace ac = adsk::core;
+namespace af = adsk::fusion;
+
+namespace {
+bool CompilePattern(const std::string &text, std::regex &pattern, bool &active, std::string *error) {
+  active = !text.empty();
+  if (!active)
+	return true;
+  try {
+	pattern = std::regex(text, std::regex::ECMAScript | std::regex::optimize);
+  } catch (const std::regex_error &) {
+	if (error)
+	  *error = "Invalid pattern: " + text;
+	return false;
+  }
+  return true;
+}
+
+// Occurrence names are "<component>:<n>".
+std::string ComponentOfOccurrence(const std::string &name) {
+  const size_t colon = name.rfind(':');
+  return colon == std::string::npos ? name : name.substr(0, colon);
+}
+}
+
+bool RuleMatcher::Compile(const SelectionRules &rules, std::string *error) {
+  m_visibleOnly = rules.visibleOnly;
+  return CompilePattern(rules.includeComponents, m_includeComponents, m_hasIncludeComponents, error)
+	  && CompilePattern(rules.excludeComponents, m_excludeComponents, m_hasExcludeComponents, error)
+	  && CompilePattern(rules.includeBodies, m_includeBodies, m_hasIncludeBodies, error)
+	  && CompilePattern(rules.excludeBodies, m_excludeBodies, m_hasExcludeBodies, error)
+	  && CompilePattern(rules.material, m_material, m_hasMaterial, error)
+	  && CompilePattern(rules.subtree, m_subtree, m_hasSubtree, error);
+}
+
+bool RuleMatcher::MatchesSubtree(const std::vector<std::string> &path) const {
+  if (!m_hasSubtree)
+	return true;
+  for (auto &&component : path)
+	if (std::regex_search(component, m_subtree))
+	  return true;
+  return false;
+}
+
+bool RuleMatcher::MatchesComponent(const std::string &component) const {
+  return Search(m_includeComponents, m_hasIncludeComponents, component)
+	  && !(m_hasExcludeComponents && std::regex_search(component, m_excludeComponents));
+}
+
+bool RuleMatcher::MatchesBody(const std::string &body) const {
+  return Search(m_includeBodies, m_hasIncludeBodies, body)
+	  && !(m_hasExcludeBodies && std::regex_search(body, m_excludeBodies));
+}
+
+bool RuleMatcher::MatchesMaterial(const std::string &material) const {
+  return Search(m_material, m_hasMaterial, material);
+}
+
+bool CollectBodies(const ac::Ptr<af::Design> &design,
+				   const SelectionRules &rules,
+				   std::vector<ac::Ptr<af::BRepBody>> &bodies) {
+  RuleMatcher matcher;
+  if (!matcher.Compile(rules))
+	return false;
+  bodies.clear();
+  if (!design)
+	return true;
+  auto root = design->rootComponent();
+  if (!root)
+	return true;
+
+  // Cheap string checks run before the API calls they could save. A component used several times
+  // lists its bodies under every occurrence, all named alike and so written to the same file; only
+  // the first occurrence of each body is kept.
+  std::unordered_set<std::string> seen; // entity tokens of the bodies in their own component
+  auto addBodies = [&](const ac::Ptr<af::BRepBodies> &candidates) {
+	if (!candidates)
+	  return;
+	for (size_t i = 0; i < candidates->count(); ++i) {
+	  auto body = candidates->item(i);
+	  if (!body || !matcher.MatchesBody(body->name()))
+		continue;
+	  if (matcher.VisibleOnly() && !body->isVisible())
+		continue;
+	  if (matcher.NeedsMaterial()) {
+		auto material = body->material();
+		if (!material || !matcher.MatchesMaterial(material->name()))
+		  continue;
+	  }
+	  auto native = body->nativeObject(); // null for bodies that are not proxies
+	  if (!seen.insert((native ? native : body)->entityToken()).second)
+		continue;
+	  bodies.push_back(body);
+	}
+  };
+
+  std::vector<std::string> path{root->name()};
+  if (matcher.MatchesSubtree(path) && matcher.MatchesComponent(root->name()))
+	addBodies(root->bRepBodies());
+
+  auto occurrences = root->allOccurrences();
+  if (!occurrences)
+	return true;
+  for (size_t i = 0; i < occurrences->count(); ++i) {
+	auto occurrence = occurrences->item(i);
+	if (!occurrence)
+	  continue;
+	auto component = occurrence->component();
+	if (!component || !matcher.MatchesComponent(component->name()))
+	  continue;
+	if (matcher.VisibleOnly() && !occurrence->isVisible())
+	  continue;
+	if (matcher.NeedsSubtree()) {
+	  // fullPathName is "<occurrence>+<occurrence>+..." from the top level down.
+	  const std::string fullPath = occurrence->fullPathName();
+	  path.resize(1);
+	  for (size_t at = 0, next; at < fullPath.size(); at = next + 1) {
+		next = fullPath.find('+', at);
+		if (next == std::string::npos)
+		  next = fullPath.size();
+		path.push_back(ComponentOfOccurrence(fullPath.substr(at, next - at)));
+	  }
+	  if (!matcher.MatchesSubtree(path))
+		continue;
+	}
+	addBodies(occurrence->bRepBodies());
+  }
+  return true;
+}
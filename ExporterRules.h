@@ -0,0 +1,59 @@
+#ifndef STLHELPER__EXPORTERRULES_H_
+#define STLHELPER__EXPORTERRULES_H_
+#pragma once
+
+#include <Core/CoreAll.h>
+#include <Fusion/FusionAll.h>
+
+#include <regex>
+#include <string>
+#include <vector>
+
+// Picks bodies by name instead of by hand. Every pattern is an ECMAScript regular expression that
+// only has to match part of the name; empty patterns do not constrain anything.
+struct SelectionRules {
+  std::string includeComponents;
+  std::string excludeComponents;
+  std::string includeBodies;
+  std::string excludeBodies;
+  std::string material;
+  std::string subtree; // some component on the path from the root to the body must match
+  bool visibleOnly{true};
+};
+
+// SelectionRules with the patterns compiled, so a whole design is matched against them without
+// building a regex per body.
+class RuleMatcher {
+ public:
+  // Returns false and sets `error` if a pattern does not compile.
+  bool Compile(const SelectionRules &rules, std::string *error = nullptr);
+
+  bool NeedsMaterial() const { return m_hasMaterial; }
+  bool NeedsSubtree() const { return m_hasSubtree; }
+  bool VisibleOnly() const { return m_visibleOnly; }
+
+  // `path` holds the component names from the root down to the body's component.
+  bool MatchesSubtree(const std::vector<std::string> &path) const;
+  bool MatchesComponent(const std::string &component) const;
+  bool MatchesBody(const std::string &body) const;
+  bool MatchesMaterial(const std::string &material) const;
+
+ private:
+  static bool Search(const std::regex &pattern, bool active, const std::string &text) {
+	return !active || std::regex_search(text, pattern);
+  }
+
+  std::regex m_includeComponents, m_excludeComponents, m_includeBodies, m_excludeBodies, m_material, m_subtree;
+  bool m_hasIncludeComponents{false}, m_hasExcludeComponents{false}, m_hasIncludeBodies{false};
+  bool m_hasExcludeBodies{false}, m_hasMaterial{false}, m_hasSubtree{false};
+  bool m_visibleOnly{true};
+};
+
+// Walks the root component and every occurrence once and returns the bodies matching `rules`,
+// as proxies in the context of their occurrence. A body of a component used several times is
+// returned for its first matching occurrence only. Returns false if a pattern does not compile.
+bool CollectBodies(const adsk::core::Ptr<adsk::fusion::Design> &design,
+				   const SelectionRules &rules,
+				   std::vector<adsk::core::Ptr<adsk::fusion::BRepBody>> &bodies);
+
+#endif //STLHELPER__EXPORTERRULES_H_
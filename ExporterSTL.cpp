@@ -0,0 +1,251 @@
+#include "ExporterSTL.h"
+#include "ExporterHash.h"
+#include "ExporterIO.h"
+#include "ExporterPlatform.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t kHeaderSize = 80;
+constexpr size_t kFacetSize = 50;
+constexpr size_t kFacetsPerChunk = 1 << 14;
+constexpr size_t kAsciiFacetsPerChunk = 1 << 12;
+constexpr size_t kMaxAsciiFacetSize = 512; // keywords plus twelve numbers of at most 16 characters
+
+void PutFloat(char *&out, float f) {
+  std::memcpy(out, &f, sizeof(float)); // STL is little-endian, as are all platforms Fusion runs on
+  out += sizeof(float);
+}
+
+void PutText(char *&out, const char *text, size_t size) {
+  std::memcpy(out, text, size);
+  out += size;
+}
+
+template<size_t N>
+void PutText(char *&out, const char (&text)[N]) {
+  PutText(out, text, N - 1);
+}
+
+// 10^i for i in [-kPowerBias, kPowerBias], covering every float and the digits on top.
+constexpr int kPowerBias = 60;
+const double *Powers() {
+  static const auto powers = [] {
+	std::vector<double> p(2 * kPowerBias + 1);
+	for (int i = -kPowerBias; i <= kPowerBias; ++i)
+	  p[i + kPowerBias] = std::pow(10.0, i);
+	return p;
+  }();
+  return powers.data() + kPowerBias;
+}
+
+// `f` rounded to `digits` significant digits, laid out like printf's %g. Integer arithmetic on a
+// scaled double is several times faster than to_chars with a precision and, with at most nine
+// digits, far inside the double's own accuracy.
+void PutRounded(char *&out, float f, int digits) {
+  double v = f;
+  if (!std::isfinite(v)) {
+	out = std::to_chars(out, out + 16, f).ptr;
+	return;
+  }
+  if (v < 0.0) {
+	*out++ = '-';
+	v = -v;
+  }
+  if (v == 0.0) {
+	*out++ = '0';
+	return;
+  }
+  const double *powers = Powers();
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const int binary = std::max(static_cast<int>(bits >> 23 & 0xFF), 1) - 127; // floor(log2(v)) for normal floats
+  int e = binary >= 0 ? (binary * 78913) >> 18 : -((-binary * 78913 + (1 << 18) - 1) >> 18);
+  while (v >= powers[e + 1]) // the estimate is at most one too small, more for subnormals
+	++e;
+  while (v < powers[e])
+	--e;
+  uint64_t scaled = static_cast<uint64_t>(v * powers[digits - 1 - e] + 0.5);
+  if (scaled >= static_cast<uint64_t>(powers[digits])) { // rounded up to the next power of ten
+	++e;
+	scaled /= 10;
+  }
+  static const char kPairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+							  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+							  "8081828384858687888990919293949596979899";
+  char text[kMaxAsciiDigits + 1];
+  uint32_t rest = static_cast<uint32_t>(scaled);
+  int i = digits;
+  for (; i >= 2; i -= 2, rest /= 100)
+	std::memcpy(text + i - 2, kPairs + 2 * (rest % 100), 2);
+  if (i == 1)
+	text[0] = static_cast<char>('0' + rest);
+  int used = digits;
+  while (used > 1 && text[used - 1] == '0')
+	--used;
+
+  if (e < -5 || e >= digits) {
+	*out++ = text[0];
+	if (used > 1) {
+	  *out++ = '.';
+	  PutText(out, text + 1, used - 1);
+	}
+	*out++ = 'e';
+	*out++ = e < 0 ? '-' : '+';
+	const int magnitude = e < 0 ? -e : e;
+	*out++ = static_cast<char>('0' + magnitude / 10);
+	*out++ = static_cast<char>('0' + magnitude % 10);
+  } else if (e < 0) {
+	PutText(out, "0.");
+	for (int place = -1; place > e; --place)
+	  *out++ = '0';
+	PutText(out, text, used);
+  } else {
+	const int whole = e + 1;
+	PutText(out, text, std::min(used, whole));
+	for (int place = used; place < whole; ++place)
+	  *out++ = '0';
+	if (used > whole) {
+	  *out++ = '.';
+	  PutText(out, text + whole, used - whole);
+	}
+  }
+}
+
+// Shortest text that reads back as exactly `f`, or `digits` significant digits if that is not 0.
+void PutNumber(char *&out, float f, int digits) {
+  f = f == 0.0f ? 0.0f : f; // no "-0"
+  if (digits > 0)
+	PutRounded(out, f, digits);
+  else
+	out = std::to_chars(out, out + 16, f).ptr;
+}
+
+void PutTriple(char *&out, const Vec3 &v, int digits) {
+  for (int a = 0; a < 3; ++a) {
+	*out++ = ' ';
+	PutNumber(out, v[a], digits);
+  }
+}
+
+// `f` as a reader of the file will see it.
+float AsWritten(float f, int digits) {
+  if (digits <= 0)
+	return f;
+  char text[16];
+  char *end = text;
+  PutNumber(end, f, digits);
+  parseNumber(text, end, f);
+  return f;
+}
+}
+
+bool WriteBinarySTL(const Mesh &mesh, const std::filesystem::path &path, float scale, STLSummary *summary) {
+  const uint32_t count = static_cast<uint32_t>(mesh.TriangleCount());
+  OutputFile file;
+  if (!file.Open(path, kHeaderSize + sizeof(count) + uint64_t{count} * kFacetSize))
+	return false;
+
+  char header[kHeaderSize] = {};
+  std::strncpy(header, "binary STL written by STL Exporter", kHeaderSize);
+  file.Write(header, kHeaderSize);
+  file.Write(&count, sizeof(count));
+  StreamHash hash;
+  BoundingBox bounds;
+  hash.Update(header, kHeaderSize);
+  hash.Update(&count, sizeof(count));
+
+  // Called from the writer threads, which end with the run; the buffer is reused for all their files.
+  thread_local std::vector<char> chunk(kFacetsPerChunk * kFacetSize);
+  for (size_t first = 0; first < count; first += kFacetsPerChunk) {
+	const size_t last = std::min<size_t>(count, first + kFacetsPerChunk);
+	char *out = chunk.data();
+	for (size_t t = first; t < last; ++t) {
+	  Vec3 n = mesh.FaceNormal(t);
+	  for (float f : n)
+		PutFloat(out, f);
+	  for (int c = 0; c < 3; ++c) {
+		const Vec3 corner = mesh.Corner(t, c) * scale;
+		bounds.Extend(corner);
+		for (float f : corner)
+		  PutFloat(out, f);
+	  }
+	  *out++ = 0; // attribute byte count
+	  *out++ = 0;
+	}
+	if (!file.Write(chunk.data(), static_cast<size_t>(out - chunk.data())))
+	  return false;
+	hash.Update(chunk.data(), static_cast<size_t>(out - chunk.data()));
+  }
+  if (summary) {
+	summary->triangles = count;
+	summary->bounds = bounds;
+	summary->contentHash = hash.Value();
+  }
+  return file.Close();
+}
+
+bool WriteAsciiSTL(const Mesh &mesh, const std::filesystem::path &path, float scale, int digits, STLSummary *summary) {
+  digits = std::clamp(digits, 0, kMaxAsciiDigits);
+  const size_t count = mesh.TriangleCount();
+  OutputFile file;
+  // a rough size is enough for the allocation hint
+  if (!file.Open(path, count * (digits > 0 ? 140 + 12 * size_t(digits) : 230)))
+	return false;
+
+  // Files are written under temporary names, and a name in the contents would keep identical meshes
+  // from giving identical files, so every solid has the same name.
+  const std::string header = "solid STLExporter\n";
+  const std::string footer = "endsolid STLExporter\n";
+  StreamHash hash;
+  BoundingBox bounds;
+  file.Write(header.data(), header.size());
+  hash.Update(header.data(), header.size());
+
+  // Called from the writer threads, which end with the run; the buffer is reused for all their files.
+  thread_local std::vector<char> chunk(kAsciiFacetsPerChunk * kMaxAsciiFacetSize);
+  for (size_t first = 0; first < count; first += kAsciiFacetsPerChunk) {
+	const size_t last = std::min(count, first + kAsciiFacetsPerChunk);
+	char *out = chunk.data();
+	for (size_t t = first; t < last; ++t) {
+	  const Vec3 corners[3] = {mesh.Corner(t, 0) * scale, mesh.Corner(t, 1) * scale, mesh.Corner(t, 2) * scale};
+	  Vec3 n = Cross(corners[1] - corners[0], corners[2] - corners[0]);
+	  const float length = std::sqrt(Dot(n, n));
+	  n = length > 0.0f ? n * (1.0f / length) : Vec3{0, 0, 0};
+	  PutText(out, "facet normal");
+	  PutTriple(out, n, digits);
+	  PutText(out, "\n outer loop\n");
+	  for (const Vec3 &corner : corners) {
+		bounds.Extend(corner);
+		PutText(out, "  vertex");
+		PutTriple(out, corner, digits);
+		*out++ = '\n';
+	  }
+	  PutText(out, " endloop\nendfacet\n");
+	}
+	if (!file.Write(chunk.data(), static_cast<size_t>(out - chunk.data())))
+	  return false;
+	hash.Update(chunk.data(), static_cast<size_t>(out - chunk.data()));
+  }
+  file.Write(footer.data(), footer.size());
+  hash.Update(footer.data(), footer.size());
+
+  if (summary) {
+	// rounding is monotonic, so the rounded extremes are the extremes of the rounded values
+	if (!bounds.IsEmpty()) {
+	  for (int a = 0; a < 3; ++a) {
+		bounds.min[a] = AsWritten(bounds.min[a], digits);
+		bounds.max[a] = AsWritten(bounds.max[a], digits);
+	  }
+	}
+	summary->triangles = count;
+	summary->bounds = bounds;
+	summary->contentHash = hash.Value();
+  }
+  return file.Close();
+}
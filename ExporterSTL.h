@@ -0,0 +1,37 @@
+#ifndef STLHELPER__EXPORTERSTL_H_
+#define STLHELPER__EXPORTERSTL_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <filesystem>
+
+// Fusion works in centimeters; STL has no unit field and slicers assume millimeters.
+constexpr float kCentimetersToMillimeters = 10.0f;
+
+// What a written file holds, gathered while writing it so the file can be checked afterwards.
+struct STLSummary {
+  uint64_t triangles{0};
+  BoundingBox bounds; // of the coordinates as written, after scaling
+  uint64_t contentHash{0}; // StreamHash of the file
+};
+
+// Writes `mesh` as binary STL, scaling coordinates by `scale`. Facet normals are recomputed from
+// the (scaled) corners. If `summary` is given it receives the counts, bounds and hash written.
+bool WriteBinarySTL(const Mesh &mesh,
+					const std::filesystem::path &path,
+					float scale = kCentimetersToMillimeters,
+					STLSummary *summary = nullptr);
+
+constexpr int kMaxAsciiDigits = 9; // enough to round-trip any float
+
+// Writes `mesh` as ASCII STL for tools that cannot read the binary form. Numbers are written with
+// the fewest digits that read back as the same float, or rounded to `digits` significant digits
+// (1 to kMaxAsciiDigits) for smaller files. Otherwise behaves like WriteBinarySTL.
+bool WriteAsciiSTL(const Mesh &mesh,
+				   const std::filesystem::path &path,
+				   float scale = kCentimetersToMillimeters,
+				   int digits = 0,
+				   STLSummary *summary = nullptr);
+
+#endif //STLHELPER__EXPORTERSTL_H_
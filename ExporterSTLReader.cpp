@@ -0,0 +1,176 @@
+#include "ExporterSTLReader.h"
+#include "ExporterHash.h"
+#include "ExporterIO.h"
+#include "ExporterParallel.h"
+#include "ExporterPlatform.h"
+
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace {
+constexpr size_t kHeaderSize = 80;
+constexpr size_t kFacetSize = 50;
+constexpr size_t kAsciiChunkSize = size_t{1} << 20;
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+void SkipSpace(std::string_view text, size_t &at) {
+  while (at < text.size() && IsSpace(text[at]))
+	++at;
+}
+
+std::string_view NextWord(std::string_view text, size_t &at) {
+  SkipSpace(text, at);
+  const size_t begin = at;
+  while (at < text.size() && !IsSpace(text[at]))
+	++at;
+  return text.substr(begin, at - begin);
+}
+
+bool NextFloat(std::string_view text, size_t &at, float &value) {
+  SkipSpace(text, at);
+  if (at < text.size() && text[at] == '+')
+	++at; // parseNumber does not take an explicit plus sign
+  const char *first = text.data() + at;
+  const char *end = parseNumber(first, text.data() + text.size(), value);
+  if (!end)
+	return false;
+  at += static_cast<size_t>(end - first);
+  return true;
+}
+
+// Offset of the first "facet" keyword at or after `from`, or the text size if there is none.
+size_t FindFacet(std::string_view text, size_t from) {
+  for (size_t at = text.find("facet", from); at != std::string_view::npos; at = text.find("facet", at + 1)) {
+	const bool startsWord = at == 0 || IsSpace(text[at - 1]); // rejects "endfacet"
+	const bool endsWord = at + 5 == text.size() || IsSpace(text[at + 5]);
+	if (startsWord && endsWord)
+	  return at;
+  }
+  return text.size();
+}
+
+// Parses the facets whose keyword starts in [begin, end).
+bool ParseFacets(std::string_view text, size_t begin, size_t end, std::vector<float> &positions) {
+  for (size_t at = FindFacet(text, begin); at < end; at = FindFacet(text, at)) {
+	at += 5;
+	int corners = 0;
+	while (true) {
+	  const std::string_view word = NextWord(text, at);
+	  if (word.empty())
+		return false;
+	  if (word == "endfacet")
+		break;
+	  if (word != "vertex")
+		continue; // normal, outer loop, endloop
+	  if (++corners > 3)
+		return false;
+	  for (int a = 0; a < 3; ++a) {
+		float value;
+		if (!NextFloat(text, at, value))
+		  return false;
+		positions.push_back(value);
+	  }
+	}
+	if (corners != 3)
+	  return false;
+  }
+  return true;
+}
+
+bool ReadBinary(const char *data, size_t size, Mesh &mesh, Parallelism parallelism) {
+  uint32_t count;
+  std::memcpy(&count, data + kHeaderSize, sizeof(count));
+  mesh.positions.resize(9 * size_t{count});
+  mesh.indices.resize(3 * size_t{count});
+  const char *facets = data + kHeaderSize + sizeof(count);
+  ParallelFor(count, 1 << 14, [&](size_t begin, size_t end) {
+	for (size_t t = begin; t < end; ++t) {
+	  // skip the normal, keep the nine corner coordinates
+	  std::memcpy(&mesh.positions[9 * t], facets + t * kFacetSize + 3 * sizeof(float), 9 * sizeof(float));
+	  for (uint32_t c = 0; c < 3; ++c)
+		mesh.indices[3 * t + c] = static_cast<uint32_t>(3 * t + c);
+	}
+  }, parallelism);
+  return size == kHeaderSize + sizeof(count) + kFacetSize * size_t{count};
+}
+
+bool ReadAscii(std::string_view text, Mesh &mesh, Parallelism parallelism) {
+  const size_t chunks = std::max<size_t>(1, (text.size() + kAsciiChunkSize - 1) / kAsciiChunkSize);
+  std::vector<std::vector<float>> parts(chunks);
+  std::vector<char> valid(chunks, 1);
+  ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+	for (size_t c = begin; c < end; ++c) {
+	  const size_t first = c * kAsciiChunkSize;
+	  const size_t last = std::min(text.size(), first + kAsciiChunkSize);
+	  valid[c] = ParseFacets(text, first, last, parts[c]);
+	}
+  }, parallelism);
+  size_t total = 0;
+  for (size_t c = 0; c < chunks; ++c) {
+	if (!valid[c])
+	  return false;
+	total += parts[c].size();
+  }
+  mesh.positions.clear();
+  mesh.positions.reserve(total);
+  for (auto &&part : parts)
+	mesh.positions.insert(mesh.positions.end(), part.begin(), part.end());
+  mesh.indices.resize(total / 3);
+  for (size_t i = 0; i < mesh.indices.size(); ++i)
+	mesh.indices[i] = static_cast<uint32_t>(i);
+  return true;
+}
+}
+
+bool ReadSTL(const std::filesystem::path &path, Mesh &mesh, uint64_t *contentHash, Parallelism parallelism) {
+  mesh.Clear();
+  MappedFile file;
+  if (!file.Open(path))
+	return false;
+  const char *data = file.Data();
+  const size_t size = file.Size();
+  if (contentHash) {
+	StreamHash hash;
+	hash.Update(data, size);
+	*contentHash = hash.Value();
+  }
+
+  // Binary files may also start with "solid", so the exact size decides first.
+  if (size >= kHeaderSize + sizeof(uint32_t)) {
+	uint32_t count;
+	std::memcpy(&count, data + kHeaderSize, sizeof(count));
+	if (size == kHeaderSize + sizeof(count) + kFacetSize * size_t{count})
+	  return ReadBinary(data, size, mesh, parallelism);
+  }
+  const std::string_view text(data, size);
+  size_t at = 0;
+  if (NextWord(text, at) != "solid")
+	return false;
+  return ReadAscii(text, mesh, parallelism);
+}
+
+bool MatchesSummary(const Mesh &mesh, uint64_t contentHash, const STLSummary &expected) {
+  if (contentHash != expected.contentHash || mesh.TriangleCount() != expected.triangles)
+	return false;
+  // Text formats round coordinates, so the bounds only have to agree to a fraction of their size.
+  const BoundingBox bounds = mesh.Bounds();
+  const Vec3 size = expected.bounds.Size();
+  const float tolerance = 1e-5f * std::max(size[0], std::max(size[1], size[2]));
+  for (int a = 0; a < 3; ++a) {
+	if (std::fabs(bounds.min[a] - expected.bounds.min[a]) > tolerance
+		|| std::fabs(bounds.max[a] - expected.bounds.max[a]) > tolerance)
+	  return false;
+  }
+  return true;
+}
+
+bool VerifySTL(const std::filesystem::path &path, const STLSummary &expected) {
+  Mesh mesh;
+  uint64_t hash = 0;
+  return ReadSTL(path, mesh, &hash, Parallelism::Serial) && MatchesSummary(mesh, hash, expected);
+}
@@ -0,0 +1,26 @@
+#ifndef STLHELPER__EXPORTERSTLREADER_H_
+#define STLHELPER__EXPORTERSTLREADER_H_
+#pragma once
+
+#include "ExporterParallel.h"
+#include "ExporterSTL.h"
+
+#include <filesystem>
+
+// Reads a binary or ASCII STL file into `mesh`, three unshared vertices per facet, coordinates as
+// stored. The file is memory-mapped; ASCII text is split at facet boundaries and parsed on all
+// worker threads unless `parallelism` is Serial. If `contentHash` is given it receives the
+// StreamHash of the file.
+bool ReadSTL(const std::filesystem::path &path,
+			 Mesh &mesh,
+			 uint64_t *contentHash = nullptr,
+			 Parallelism parallelism = Parallelism::Workers);
+
+// True if `mesh`, read from a file with hash `contentHash`, is what `expected` describes.
+bool MatchesSummary(const Mesh &mesh, uint64_t contentHash, const STLSummary &expected);
+
+// Reads `path` back and checks it against what was written: triangle count, bounding box and hash.
+// Parses on the calling thread, since files are verified by the writer that wrote them.
+bool VerifySTL(const std::filesystem::path &path, const STLSummary &expected);
+
+#endif //STLHELPER__EXPORTERSTLREADER_H_
@@ -0,0 +1,138 @@
+#include "ExporterSettings.h"
+#include "ExporterPlatform.h"
+
+#include <charconv>
+#include <cstdlib>
+
+void SettingsBlob::Set(const std::string &key, const std::string &value) {
+  for (auto &&entry : m_values) {
+	if (entry.first == key) {
+	  entry.second = value;
+	  return;
+	}
+  }
+  m_values.emplace_back(key, value);
+}
+
+void SettingsBlob::Set(const std::string &key, bool value) {
+  Set(key, value ? "1" : "0");
+}
+
+void SettingsBlob::Set(const std::string &key, double value) {
+  // shortest text that round-trips, with '.' whatever the locale: the blob travels with the design
+  char buffer[32];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  Set(key, std::string(buffer, result.ptr));
+}
+
+const std::string *SettingsBlob::Find(const std::string &key) const {
+  for (auto &&entry : m_values)
+	if (entry.first == key)
+	  return &entry.second;
+  return nullptr;
+}
+
+bool SettingsBlob::Get(const std::string &key, std::string &value) const {
+  const std::string *found = Find(key);
+  if (!found)
+	return false;
+  value = *found;
+  return true;
+}
+
+bool SettingsBlob::Get(const std::string &key, bool &value) const {
+  const std::string *found = Find(key);
+  if (!found || (*found != "0" && *found != "1"))
+	return false;
+  value = *found == "1";
+  return true;
+}
+
+bool SettingsBlob::Get(const std::string &key, double &value) const {
+  const std::string *found = Find(key);
+  if (!found || found->empty())
+	return false;
+  const char *last = found->data() + found->size();
+  double parsed;
+  if (parseNumber(found->data(), last, parsed) != last)
+	return false;
+  value = parsed;
+  return true;
+}
+
+bool SettingsBlob::Migrate() {
+  if (m_version > kVersion)
+	return false;
+  // Version 1 is the first schema. Later versions convert the keys of each older one here, one
+  // version at a time.
+  m_version = kVersion;
+  return true;
+}
+
+std::vector<std::string> SettingsBlob::DifferingKeys(const SettingsBlob &other) const {
+  std::vector<std::string> keys;
+  for (auto &&entry : m_values) {
+	const std::string *found = other.Find(entry.first);
+	if (!found || *found != entry.second)
+	  keys.push_back(entry.first);
+  }
+  for (auto &&entry : other.m_values) {
+	if (!Find(entry.first))
+	  keys.push_back(entry.first);
+  }
+  return keys;
+}
+
+std::string SettingsBlob::Serialize() const {
+  std::string text = "v" + std::to_string(m_version);
+  for (auto &&entry : m_values) {
+	text += '\n';
+	text += entry.first;
+	text += '=';
+	for (char c : entry.second) {
+	  if (c == '\\')
+		text += "\\\\";
+	  else if (c == '\n')
+		text += "\\n";
+	  else
+		text += c;
+	}
+  }
+  return text;
+}
+
+bool SettingsBlob::Parse(const std::string &text, SettingsBlob &blob) {
+  if (text.size() < 2 || text[0] != 'v')
+	return false;
+  char *end = nullptr;
+  long version = std::strtol(text.c_str() + 1, &end, 10);
+  if (version <= 0 || (*end != '\n' && *end != '\0'))
+	return false;
+
+  SettingsBlob parsed;
+  parsed.m_version = static_cast<int>(version);
+  size_t at = static_cast<size_t>(end - text.c_str());
+  while (at < text.size()) {
+	size_t next = text.find('\n', at + 1);
+	if (next == std::string::npos)
+	  next = text.size();
+	const std::string line = text.substr(at + 1, next - at - 1);
+	at = next;
+	const size_t equals = line.find('=');
+	if (equals == std::string::npos || equals == 0)
+	  return false;
+	std::string value;
+	value.reserve(line.size() - equals - 1);
+	for (size_t i = equals + 1; i < line.size(); ++i) {
+	  if (line[i] == '\\' && i + 1 < line.size()) {
+		++i;
+		value += line[i] == 'n' ? '\n' : line[i];
+	  } else {
+		value += line[i];
+	  }
+	}
+	parsed.m_values.emplace_back(line.substr(0, equals), std::move(value));
+  }
+  blob = std::move(parsed);
+  return true;
+}
@@ -0,0 +1,49 @@
+#ifndef STLHELPER__EXPORTERSETTINGS_H_
+#define STLHELPER__EXPORTERSETTINGS_H_
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Flat, versioned key/value record stored as the value of a single attribute, so saving or loading
+// all settings costs one API call instead of one per setting. The text form is
+//   v<version>\n<key>=<value>\n...
+// with backslash and newline escaped in values. Keys keep the order they were set in, so equal
+// settings always serialize to equal text.
+class SettingsBlob {
+ public:
+  static constexpr int kVersion = 1;
+
+  int Version() const { return m_version; }
+
+  // Brings a blob saved by an older version up to kVersion. Returns false and leaves the blob as it
+  // is if a newer version saved it, since its keys may mean something else by then.
+  bool Migrate();
+
+  void Set(const std::string &key, const std::string &value);
+  void Set(const std::string &key, const char *value) { Set(key, std::string(value)); }
+  void Set(const std::string &key, bool value);
+  void Set(const std::string &key, double value);
+
+  // Leave `value` untouched and return false if the key is missing or malformed.
+  bool Get(const std::string &key, std::string &value) const;
+  bool Get(const std::string &key, bool &value) const;
+  bool Get(const std::string &key, double &value) const;
+
+  // Keys whose values differ between the two blobs, including keys only one of them has, in the
+  // order they were set.
+  std::vector<std::string> DifferingKeys(const SettingsBlob &other) const;
+
+  std::string Serialize() const;
+  // Returns false if `text` is not a settings blob; unknown keys are kept but otherwise ignored.
+  static bool Parse(const std::string &text, SettingsBlob &blob);
+
+ private:
+  const std::string *Find(const std::string &key) const;
+
+  int m_version{kVersion};
+  std::vector<std::pair<std::string, std::string>> m_values;
+};
+
+#endif //STLHELPER__EXPORTERSETTINGS_H_
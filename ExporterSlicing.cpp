@@ -0,0 +1,291 @@
+#include "ExporterSlicing.h"
+#include "ExporterHash.h"
+#include "ExporterIO.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace {
+constexpr char kMagic[4] = {'S', 'E', 'C', 'L'};
+constexpr uint8_t kVersion = 1;
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+// Point where the edge from `below` to `above` crosses `z`. Always interpolating from the lower end
+// gives bit-identical points for an edge shared by two triangles, so endpoints can be joined exactly.
+// A vertex on the plane is returned as it is: it ends edges from several lower vertices, and
+// interpolating to it from each of them would round to slightly different points.
+Vec2 Crossing(const Vec3 &below, const Vec3 &above, float z) {
+  if (above[2] == z)
+	return {above[0], above[1]};
+  const float t = (z - below[2]) / (above[2] - below[2]);
+  return {below[0] + t * (above[0] - below[0]), below[1] + t * (above[1] - below[1])};
+}
+
+// The part of `triangle` on plane `z`, directed so the solid lies on its left seen from above.
+// Vertices on the plane count as above it, so a plane through a vertex still gives one segment.
+bool Cut(const Mesh &mesh, size_t triangle, float z, ContourSegment &segment) {
+  const Vec3 p[3] = {mesh.Corner(triangle, 0), mesh.Corner(triangle, 1), mesh.Corner(triangle, 2)};
+  const bool above[3] = {p[0][2] >= z, p[1][2] >= z, p[2][2] >= z};
+  const int count = above[0] + above[1] + above[2];
+  if (count == 0 || count == 3)
+	return false;
+  // the vertex alone on its side, and the other two
+  const bool loneAbove = count == 1;
+  int lone = 0;
+  while (above[lone] != loneAbove)
+	++lone;
+  const Vec3 &a = p[lone], &b = p[(lone + 1) % 3], &c = p[(lone + 2) % 3];
+  segment.from = above[lone] ? Crossing(b, a, z) : Crossing(a, b, z);
+  segment.to = above[lone] ? Crossing(c, a, z) : Crossing(a, c, z);
+  // an outward normal in the plane points to the right of the direction of travel
+  const Vec3 n = Cross(p[1] - p[0], p[2] - p[0]);
+  const float dx = segment.to[0] - segment.from[0], dy = segment.to[1] - segment.from[1];
+  if (dx * -n[1] + dy * n[0] < 0.0f)
+	std::swap(segment.from, segment.to);
+  return segment.from != segment.to;
+}
+
+uint64_t PointKey(const Vec2 &p) {
+  uint32_t bits[2];
+  for (int a = 0; a < 2; ++a) {
+	const float f = p[a] == 0.0f ? 0.0f : p[a]; // fold -0 into +0
+	std::memcpy(&bits[a], &f, sizeof(float));
+  }
+  return uint64_t{bits[0]} << 32 | bits[1];
+}
+
+size_t HashKey(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDull;
+  key ^= key >> 33;
+  return static_cast<size_t>(key);
+}
+
+}
+
+std::vector<std::vector<Vec2>> JoinSegments(const std::vector<ContourSegment> &segments) {
+  std::vector<std::vector<Vec2>> polygons;
+  const size_t count = segments.size();
+  size_t capacity = 16;
+  while (capacity < 2 * count)
+	capacity <<= 1;
+  // Open addressing on the start point; segments sharing a start point are linked through `next`.
+  std::vector<uint32_t> slots(capacity, kNone), next(count, kNone);
+  std::vector<uint64_t> slotKeys(capacity);
+  for (size_t s = 0; s < count; ++s) {
+	const uint64_t key = PointKey(segments[s].from);
+	size_t slot = HashKey(key) & (capacity - 1);
+	while (slots[slot] != kNone && slotKeys[slot] != key)
+	  slot = (slot + 1) & (capacity - 1);
+	next[s] = slots[slot];
+	slots[slot] = static_cast<uint32_t>(s);
+	slotKeys[slot] = key;
+  }
+  std::vector<bool> used(count, false);
+  auto find = [&](uint64_t key) {
+	size_t slot = HashKey(key) & (capacity - 1);
+	while (slots[slot] != kNone && slotKeys[slot] != key)
+	  slot = (slot + 1) & (capacity - 1);
+	// used segments are dropped from the front of their chain, so each is skipped only once
+	while (slots[slot] != kNone && used[slots[slot]])
+	  slots[slot] = next[slots[slot]];
+	uint32_t s = slots[slot];
+	while (s != kNone && used[s])
+	  s = next[s];
+	return s;
+  };
+
+  for (size_t first = 0; first < count; ++first) {
+	if (used[first])
+	  continue;
+	const uint64_t start = PointKey(segments[first].from);
+	std::vector<Vec2> polygon;
+	uint32_t current = static_cast<uint32_t>(first);
+	while (current != kNone) {
+	  used[current] = true;
+	  polygon.push_back(segments[current].from);
+	  const uint64_t end = PointKey(segments[current].to);
+	  current = end == start ? kNone : find(end);
+	}
+	if (polygon.size() >= 3)
+	  polygons.push_back(std::move(polygon));
+  }
+  return polygons;
+}
+
+std::vector<SliceLayer> SliceMesh(const Mesh &mesh, float layerHeight, Parallelism parallelism) {
+  std::vector<SliceLayer> layers;
+  const BoundingBox box = mesh.Bounds();
+  if (box.IsEmpty() || !(layerHeight > 0.0f))
+	return layers;
+  const float height = box.max[2] - box.min[2];
+  const size_t count = std::max<size_t>(1, static_cast<size_t>(height / layerHeight + 0.5f));
+  layers.resize(count);
+  for (size_t i = 0; i < count; ++i)
+	layers[i].z = box.min[2] + (static_cast<float>(i) + 0.5f) * layerHeight;
+
+  // Bucket the triangles by the layers they span: counts, prefix sums, then fill.
+  const size_t triangles = mesh.TriangleCount();
+  const float top = static_cast<float>(count - 1);
+  std::vector<int32_t> firstLayer(triangles), lastLayer(triangles); // first > last if no plane cuts it
+  std::vector<size_t> offsets(count + 1, 0);
+  for (size_t t = 0; t < triangles; ++t) {
+	float lo = mesh.Corner(t, 0)[2], hi = lo;
+	for (int c = 1; c < 3; ++c) {
+	  lo = std::min(lo, mesh.Corner(t, c)[2]);
+	  hi = std::max(hi, mesh.Corner(t, c)[2]);
+	}
+	// one layer of slack either way, so rounding never drops a triangle that touches a plane
+	firstLayer[t] = static_cast<int32_t>(std::clamp(std::ceil((lo - box.min[2]) / layerHeight - 1.5f), 0.0f, top + 1.0f));
+	lastLayer[t] = static_cast<int32_t>(std::clamp(std::floor((hi - box.min[2]) / layerHeight + 0.5f), -1.0f, top));
+	for (int32_t l = firstLayer[t]; l <= lastLayer[t]; ++l)
+	  ++offsets[l + 1];
+  }
+  for (size_t l = 0; l < count; ++l)
+	offsets[l + 1] += offsets[l];
+  std::vector<uint32_t> buckets(offsets[count]);
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < triangles; ++t)
+	for (int32_t l = firstLayer[t]; l <= lastLayer[t]; ++l)
+	  buckets[fill[l]++] = static_cast<uint32_t>(t);
+
+  ParallelFor(count, 4, [&](size_t begin, size_t end) {
+	std::vector<ContourSegment> segments;
+	for (size_t l = begin; l < end; ++l) {
+	  segments.clear();
+	  ContourSegment segment;
+	  for (size_t i = offsets[l]; i < offsets[l + 1]; ++i)
+		if (Cut(mesh, buckets[i], layers[l].z, segment))
+		  segments.push_back(segment);
+	  layers[l].polygons = JoinSegments(segments);
+	}
+  }, parallelism);
+  return layers;
+}
+
+namespace {
+void AppendNumber(std::string &out, float value) {
+  char buffer[32];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr);
+}
+
+bool WriteAll(const std::filesystem::path &path, const void *data, size_t size, STLSummary *summary) {
+  OutputFile file;
+  if (!file.Open(path, size))
+	return false;
+  file.Write(data, size);
+  if (summary) {
+	StreamHash hash;
+	hash.Update(data, size);
+	summary->contentHash = hash.Value();
+  }
+  return file.Close();
+}
+
+BoundingBox ScaledBounds(const std::vector<SliceLayer> &layers, float scale) {
+  BoundingBox bounds;
+  for (auto &&layer : layers)
+	for (auto &&polygon : layer.polygons)
+	  for (auto &&p : polygon)
+		bounds.Extend(Vec3{p[0] * scale, p[1] * scale, layer.z * scale});
+  return bounds;
+}
+}
+
+bool WriteSliceSVG(const std::vector<SliceLayer> &layers,
+				   const std::filesystem::path &path,
+				   float scale,
+				   float layerHeight,
+				   STLSummary *summary) {
+  const BoundingBox bounds = ScaledBounds(layers, scale);
+  const float minX = bounds.IsEmpty() ? 0.0f : bounds.min[0];
+  const float maxY = bounds.IsEmpty() ? 0.0f : bounds.max[1];
+  const Vec3 size = bounds.Size();
+
+  std::string svg = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 ";
+  AppendNumber(svg, size[0]);
+  svg += ' ';
+  AppendNumber(svg, size[1]);
+  svg += "\" data-layer-height=\"";
+  AppendNumber(svg, layerHeight * scale);
+  svg += "\">\n";
+  for (size_t l = 0; l < layers.size(); ++l) {
+	svg += "<g id=\"layer";
+	svg += std::to_string(l);
+	svg += "\" data-z=\"";
+	AppendNumber(svg, layers[l].z * scale);
+	svg += "\">";
+	if (!layers[l].polygons.empty()) {
+	  svg += "<path fill-rule=\"evenodd\" d=\"";
+	  for (auto &&polygon : layers[l].polygons) {
+		char command = 'M';
+		for (auto &&p : polygon) {
+		  svg += command;
+		  AppendNumber(svg, p[0] * scale - minX);
+		  svg += ',';
+		  AppendNumber(svg, maxY - p[1] * scale);
+		  command = 'L';
+		}
+		svg += 'Z';
+	  }
+	  svg += "\"/>";
+	}
+	svg += "</g>\n";
+  }
+  svg += "</svg>\n";
+
+  if (summary) {
+	summary->triangles = 0;
+	summary->bounds = bounds;
+  }
+  return WriteAll(path, svg.data(), svg.size(), summary);
+}
+
+bool WriteSliceContours(const std::vector<SliceLayer> &layers,
+						const std::filesystem::path &path,
+						float scale,
+						float layerHeight,
+						STLSummary *summary) {
+  size_t size = 16;
+  for (auto &&layer : layers) {
+	size += 8;
+	for (auto &&polygon : layer.polygons)
+	  size += 4 + 8 * polygon.size();
+  }
+  std::vector<uint8_t> data(size);
+  uint8_t *out = data.data();
+  auto putU32 = [&out](uint32_t v) {
+	std::memcpy(out, &v, sizeof(v));
+	out += sizeof(v);
+  };
+  auto putF32 = [&out](float v) {
+	std::memcpy(out, &v, sizeof(v));
+	out += sizeof(v);
+  };
+  std::memcpy(out, kMagic, sizeof(kMagic));
+  out[4] = kVersion;
+  out += 8;
+  putU32(static_cast<uint32_t>(layers.size()));
+  putF32(layerHeight * scale);
+  for (auto &&layer : layers) {
+	putF32(layer.z * scale);
+	putU32(static_cast<uint32_t>(layer.polygons.size()));
+	for (auto &&polygon : layer.polygons) {
+	  putU32(static_cast<uint32_t>(polygon.size()));
+	  for (auto &&p : polygon) {
+		putF32(p[0] * scale);
+		putF32(p[1] * scale);
+	  }
+	}
+  }
+
+  if (summary) {
+	summary->triangles = 0;
+	summary->bounds = ScaledBounds(layers, scale);
+  }
+  return WriteAll(path, data.data(), data.size(), summary);
+}
@@ -0,0 +1,59 @@
+#ifndef STLHELPER__EXPORTERSLICING_H_
+#define STLHELPER__EXPORTERSLICING_H_
+#pragma once
+
+#include "ExporterNesting.h"
+#include "ExporterParallel.h"
+#include "ExporterSTL.h"
+
+#include <filesystem>
+#include <vector>
+
+constexpr int kMinLayerMicrons = 1;
+constexpr int kMaxLayerMicrons = 10000;
+constexpr int kDefaultLayerMicrons = 50;
+
+// One slice plane. Polygons are closed (the last point connects to the first); outer boundaries
+// run counterclockwise seen from above and holes clockwise.
+struct SliceLayer {
+  float z{0.0f};
+  std::vector<std::vector<Vec2>> polygons;
+};
+
+// A directed piece of a cut contour.
+struct ContourSegment {
+  Vec2 from, to;
+};
+
+// Chains segments into polygons, following each segment to the one that starts where it ends.
+// Endpoints are matched by their exact bits, so segments must come from one shared computation.
+std::vector<std::vector<Vec2>> JoinSegments(const std::vector<ContourSegment> &segments);
+
+// Cuts `mesh` with horizontal planes `layerHeight` apart, in the middle of each layer, starting
+// half a layer above its lowest point. Triangles are bucketed by the layers they span, the layers
+// are cut in parallel unless `parallelism` is Serial, and the segments are chained into polygons by
+// joining equal endpoints. Open meshes give open chains, which are returned closed by a straight
+// edge.
+std::vector<SliceLayer> SliceMesh(const Mesh &mesh,
+								  float layerHeight,
+								  Parallelism parallelism = Parallelism::Workers);
+
+// Writes the layers as one SVG with a <g> per layer holding a single even-odd path, coordinates
+// multiplied by `scale` and Y pointing down as SVG expects. `summary`, if given, receives the
+// content hash and scaled bounds.
+bool WriteSliceSVG(const std::vector<SliceLayer> &layers,
+				   const std::filesystem::path &path,
+				   float scale,
+				   float layerHeight,
+				   STLSummary *summary = nullptr);
+
+// Compact binary contours, little-endian: "SECL", version (1 byte), 3 reserved bytes, layer count
+// (uint32) and layer height (float); then per layer its Z (float) and polygon count (uint32), and
+// per polygon its point count (uint32) followed by the X, Y pairs (floats).
+bool WriteSliceContours(const std::vector<SliceLayer> &layers,
+						const std::filesystem::path &path,
+						float scale,
+						float layerHeight,
+						STLSummary *summary = nullptr);
+
+#endif //STLHELPER__EXPORTERSLICING_H_
@@ -0,0 +1,784 @@
+#include "ExporterSplit.h"
+#include "ExporterParallel.h"
+#include "ExporterSlicing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr size_t kTrianglesPerBlock = 4096;
+constexpr size_t kVerticesPerBlock = 65536;
+constexpr int kMaxSlabs = 64; // per axis
+constexpr float kPlaneShift = 0.005f; // centimeters a plane may move to stay clear of vertices
+constexpr int kDowelSegments = 24;
+constexpr float kDowelDepth = 1.5f; // of each hole, in diameters
+constexpr int kDowelSamples = 16; // candidate centers per side of a cut region's bounding box
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+constexpr float kTwoPi = 6.28318530717958647692f;
+
+// The plane where coordinate `axis` equals `offset`. Points on it count as above.
+struct Plane {
+  int axis{0};
+  float offset{0.0f};
+};
+
+// In-plane coordinates: the next two axes in cyclic order, so the cap is seen from +axis.
+Vec2 Project(const Vec3 &p, int axis) { return {p[(axis + 1) % 3], p[(axis + 2) % 3]}; }
+
+Vec3 Unproject(const Vec2 &p, const Plane &plane) {
+  Vec3 q;
+  q[plane.axis] = plane.offset;
+  q[(plane.axis + 1) % 3] = p[0];
+  q[(plane.axis + 2) % 3] = p[1];
+  return q;
+}
+
+// Twice the signed area of (a, b, c), positive when they turn counterclockwise.
+float Cross2(const Vec2 &a, const Vec2 &b, const Vec2 &c) {
+  return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+// Inclusive test against the counterclockwise triangle (a, b, c).
+bool PointInTriangle(const Vec2 &a, const Vec2 &b, const Vec2 &c, const Vec2 &p) {
+  return Cross2(p, a, b) >= 0.0f && Cross2(p, b, c) >= 0.0f && Cross2(p, c, a) >= 0.0f;
+}
+
+float SignedArea(const std::vector<Vec2> &polygon) {
+  float area = 0.0f;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+	area += (polygon[j][0] - polygon[i][0]) * (polygon[j][1] + polygon[i][1]);
+  return 0.5f * area;
+}
+
+bool PointInPolygon(const std::vector<Vec2> &polygon, const Vec2 &p) {
+  bool inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+	const Vec2 &a = polygon[i], &b = polygon[j];
+	if ((a[1] > p[1]) != (b[1] > p[1]) && p[0] < a[0] + (p[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]))
+	  inside = !inside;
+  }
+  return inside;
+}
+
+float SegmentDistanceSquared(const Vec2 &p, const Vec2 &a, const Vec2 &b) {
+  const float dx = b[0] - a[0], dy = b[1] - a[1];
+  const float length = dx * dx + dy * dy;
+  float t = length > 0.0f ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / length : 0.0f;
+  t = std::clamp(t, 0.0f, 1.0f);
+  const float ex = a[0] + t * dx - p[0], ey = a[1] + t * dy - p[1];
+  return ex * ex + ey * ey;
+}
+
+// Point where the edge from `below` to `above` crosses `plane`. Interpolating from the lower end
+// gives the same bits for an edge shared by two triangles, and the point is put exactly on the
+// plane, so the clipped triangles, the cut contour and the cap all meet without gaps.
+Vec3 Crossing(const Vec3 &below, const Vec3 &above, const Plane &plane) {
+  const float t = (plane.offset - below[plane.axis]) / (above[plane.axis] - below[plane.axis]);
+  Vec3 p = below + (above - below) * t;
+  p[plane.axis] = plane.offset;
+  return p;
+}
+
+// Moves `plane` by up to kPlaneShift into the middle of the widest gap between the vertices near
+// it. A plane through vertices, as the middle of a symmetric part often is, leaves slivers and
+// nearly coincident contour points that the cap triangulation cannot tell apart.
+void AvoidVertices(const Mesh &mesh, Plane &plane) {
+  std::vector<float> near{plane.offset - kPlaneShift, plane.offset + kPlaneShift};
+  for (size_t i = plane.axis; i < mesh.positions.size(); i += 3) {
+	if (std::abs(mesh.positions[i] - plane.offset) < kPlaneShift)
+	  near.push_back(mesh.positions[i]);
+  }
+  std::sort(near.begin(), near.end());
+  float widest = 0.0f;
+  for (size_t i = 1; i < near.size(); ++i) {
+	if (near[i] - near[i - 1] > widest) {
+	  widest = near[i] - near[i - 1];
+	  plane.offset = 0.5f * (near[i] + near[i - 1]);
+	}
+  }
+}
+
+// Separating axis test of a triangle against the box around `center` with half sizes `half`.
+bool TriangleOverlapsBox(const Vec3 &a, const Vec3 &b, const Vec3 &c, const Vec3 &center, const Vec3 &half) {
+  const Vec3 v[3] = {a - center, b - center, c - center};
+  for (int axis = 0; axis < 3; ++axis) {
+	if (std::min({v[0][axis], v[1][axis], v[2][axis]}) > half[axis]
+		|| std::max({v[0][axis], v[1][axis], v[2][axis]}) < -half[axis])
+	  return false;
+  }
+  auto separates = [&](const Vec3 &direction) {
+	const float p0 = Dot(direction, v[0]), p1 = Dot(direction, v[1]), p2 = Dot(direction, v[2]);
+	const float r = half[0] * std::abs(direction[0]) + half[1] * std::abs(direction[1]) + half[2] * std::abs(direction[2]);
+	return std::min({p0, p1, p2}) > r || std::max({p0, p1, p2}) < -r;
+  };
+  const Vec3 edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+  if (separates(Cross(edges[0], edges[1])))
+	return false;
+  for (auto &&edge : edges) {
+	for (int axis = 0; axis < 3; ++axis) {
+	  Vec3 unit{0.0f, 0.0f, 0.0f};
+	  unit[axis] = 1.0f;
+	  if (separates(Cross(unit, edge)))
+		return false;
+	}
+  }
+  return true;
+}
+
+// Ear clipping of one cut region, after the approach of Mapbox's earcut: holes are bridged into the
+// outer loop, leaving a single loop in a circular doubly linked list, and ears are clipped from it.
+// A grid over the nodes keeps each ear test to the points near the ear.
+class EarClipper {
+ public:
+  explicit EarClipper(const std::vector<Vec2> &points) : m_points(points) {}
+
+  // `loops` index ranges of `points`: the outer loop first, counterclockwise, then its holes,
+  // clockwise. Appends counterclockwise triangles of point indices to `triangles`.
+  void Triangulate(const std::vector<std::pair<uint32_t, uint32_t>> &loops, std::vector<uint32_t> &triangles) {
+	uint32_t outer = AddLoop(loops.front().first, loops.front().second);
+	if (outer == kNone)
+	  return;
+	std::vector<uint32_t> holes;
+	for (size_t h = 1; h < loops.size(); ++h) {
+	  const uint32_t hole = AddLoop(loops[h].first, loops[h].second);
+	  if (hole != kNone)
+		holes.push_back(Leftmost(hole));
+	}
+	// Left to right, so each bridge only has to see the outer loop and holes bridged before it.
+	std::sort(holes.begin(), holes.end(), [&](uint32_t a, uint32_t b) { return At(a)[0] < At(b)[0]; });
+	for (uint32_t hole : holes) {
+	  const uint32_t bridge = FindBridge(hole, outer);
+	  if (bridge != kNone)
+		Split(bridge, hole);
+	}
+	outer = Filter(outer);
+	if (m_next[outer] == m_prev[outer])
+	  return;
+	BuildGrid(outer);
+	ClipEars(outer, triangles);
+  }
+
+ private:
+  const Vec2 &At(uint32_t node) const { return m_points[m_point[node]]; }
+
+  uint32_t Insert(uint32_t point, uint32_t after) {
+	const uint32_t node = static_cast<uint32_t>(m_point.size());
+	m_point.push_back(point);
+	m_removed.push_back(0);
+	if (after == kNone) {
+	  m_prev.push_back(node);
+	  m_next.push_back(node);
+	} else {
+	  m_prev.push_back(after);
+	  m_next.push_back(m_next[after]);
+	  m_prev[m_next[after]] = node;
+	  m_next[after] = node;
+	}
+	return node;
+  }
+
+  void Remove(uint32_t node) {
+	m_next[m_prev[node]] = m_next[node];
+	m_prev[m_next[node]] = m_prev[node];
+	m_removed[node] = 1;
+  }
+
+  uint32_t AddLoop(uint32_t begin, uint32_t end) {
+	if (end - begin < 3)
+	  return kNone;
+	uint32_t last = kNone;
+	for (uint32_t p = begin; p < end; ++p)
+	  last = Insert(p, last);
+	return m_next[last];
+  }
+
+  uint32_t Leftmost(uint32_t start) const {
+	uint32_t node = start, best = start;
+	do {
+	  if (At(node)[0] < At(best)[0] || (At(node)[0] == At(best)[0] && At(node)[1] < At(best)[1]))
+		best = node;
+	  node = m_next[node];
+	} while (node != start);
+	return best;
+  }
+
+  // Drops points equal to the next one. Points in a straight run stay: leaving one out of the cap
+  // would open a gap next to the clipped triangles that end there.
+  uint32_t Filter(uint32_t start) {
+	uint32_t node = start, end = start;
+	bool again;
+	do {
+	  again = false;
+	  const uint32_t next = m_next[node];
+	  if (next != node && At(node) == At(next)) {
+		Remove(node);
+		node = end = m_prev[node];
+		if (node == m_next[node])
+		  break;
+		again = true;
+	  } else {
+		node = next;
+	  }
+	} while (again || node != end);
+	return end;
+  }
+
+  // True if the diagonal from `a` towards `b` starts into the inside of the loop at `a`.
+  bool LocallyInside(uint32_t a, uint32_t b) const {
+	const Vec2 &p = At(a), &q = At(b), &before = At(m_prev[a]), &after = At(m_next[a]);
+	return Cross2(before, p, after) > 0.0f ? Cross2(p, q, after) <= 0.0f && Cross2(p, before, q) <= 0.0f
+										   : Cross2(p, q, before) > 0.0f || Cross2(p, after, q) > 0.0f;
+  }
+
+  // A node of the outer loop the leftmost node of a hole can be joined to: cast a ray to the left,
+  // take the nearer end of the edge it hits, and if loop points inside the triangle so formed could
+  // block the view, the one at the smallest angle to the ray instead.
+  uint32_t FindBridge(uint32_t hole, uint32_t outer) const {
+	const Vec2 h = At(hole);
+	float hitX = -std::numeric_limits<float>::max();
+	uint32_t node = outer, bridge = kNone;
+	do {
+	  const Vec2 &p = At(node), &q = At(m_next[node]);
+	  if (h[1] <= p[1] && h[1] >= q[1] && q[1] != p[1]) {
+		const float x = p[0] + (h[1] - p[1]) * (q[0] - p[0]) / (q[1] - p[1]);
+		if (x <= h[0] && x > hitX) {
+		  hitX = x;
+		  bridge = p[0] < q[0] ? node : m_next[node];
+		  if (x == h[0])
+			return bridge; // the hole touches this edge
+		}
+	  }
+	  node = m_next[node];
+	} while (node != outer);
+	if (bridge == kNone)
+	  return kNone;
+
+	const uint32_t stop = bridge;
+	const Vec2 m = At(bridge);
+	float tanMin = std::numeric_limits<float>::max();
+	node = bridge;
+	do {
+	  const Vec2 &p = At(node);
+	  if (h[0] >= p[0] && p[0] >= m[0] && h[0] != p[0]
+		  && PointInTriangle({h[1] < m[1] ? h[0] : hitX, h[1]}, m, {h[1] < m[1] ? hitX : h[0], h[1]}, p)) {
+		const float tan = std::abs(h[1] - p[1]) / (h[0] - p[0]);
+		if (LocallyInside(node, hole) && (tan < tanMin || (tan == tanMin && p[0] > At(bridge)[0]))) {
+		  bridge = node;
+		  tanMin = tan;
+		}
+	  }
+	  node = m_next[node];
+	} while (node != stop);
+	return bridge;
+  }
+
+  // Joins the hole at `b` into the loop at `a` with a pair of coincident edges.
+  void Split(uint32_t a, uint32_t b) {
+	const uint32_t a2 = Insert(m_point[a], kNone), b2 = Insert(m_point[b], kNone);
+	const uint32_t an = m_next[a], bp = m_prev[b];
+	m_next[a] = b;
+	m_prev[b] = a;
+	m_next[a2] = an;
+	m_prev[an] = a2;
+	m_next[b2] = a2;
+	m_prev[a2] = b2;
+	m_next[bp] = b2;
+	m_prev[b2] = bp;
+  }
+
+  void BuildGrid(uint32_t start) {
+	m_min = At(start);
+	Vec2 max = m_min;
+	size_t count = 0;
+	uint32_t node = start;
+	do {
+	  const Vec2 &p = At(node);
+	  m_min = {std::min(m_min[0], p[0]), std::min(m_min[1], p[1])};
+	  max = {std::max(max[0], p[0]), std::max(max[1], p[1])};
+	  ++count;
+	  node = m_next[node];
+	} while (node != start);
+	m_cells = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(count)) * 0.5f));
+	const float extent = std::max(max[0] - m_min[0], max[1] - m_min[1]);
+	m_scale = extent > 0.0f ? static_cast<float>(m_cells) / extent : 0.0f;
+	// counting sort of the nodes into cells
+	m_cellStart.assign(static_cast<size_t>(m_cells) * m_cells + 1, 0);
+	do {
+	  ++m_cellStart[Cell(At(node)) + 1];
+	  node = m_next[node];
+	} while (node != start);
+	for (size_t c = 1; c < m_cellStart.size(); ++c)
+	  m_cellStart[c] += m_cellStart[c - 1];
+	m_cellNodes.resize(count);
+	std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+	do {
+	  m_cellNodes[fill[Cell(At(node))]++] = node;
+	  node = m_next[node];
+	} while (node != start);
+  }
+
+  int Coordinate(float value, float origin) const {
+	return std::clamp(static_cast<int>((value - origin) * m_scale), 0, m_cells - 1);
+  }
+  size_t Cell(const Vec2 &p) const {
+	return static_cast<size_t>(Coordinate(p[1], m_min[1])) * m_cells + Coordinate(p[0], m_min[0]);
+  }
+
+  // An ear is a convex corner whose triangle holds no reflex point of the loop.
+  bool IsEar(uint32_t ear) const {
+	const uint32_t a = m_prev[ear], c = m_next[ear];
+	const Vec2 &pa = At(a), &pb = At(ear), &pc = At(c);
+	if (Cross2(pa, pb, pc) <= 0.0f)
+	  return false;
+	const int x0 = Coordinate(std::min({pa[0], pb[0], pc[0]}), m_min[0]);
+	const int x1 = Coordinate(std::max({pa[0], pb[0], pc[0]}), m_min[0]);
+	const int y0 = Coordinate(std::min({pa[1], pb[1], pc[1]}), m_min[1]);
+	const int y1 = Coordinate(std::max({pa[1], pb[1], pc[1]}), m_min[1]);
+	for (int y = y0; y <= y1; ++y) {
+	  for (int x = x0; x <= x1; ++x) {
+		const size_t cell = static_cast<size_t>(y) * m_cells + x;
+		for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+		  const uint32_t p = m_cellNodes[i];
+		  if (m_removed[p] || p == a || p == ear || p == c)
+			continue;
+		  if (PointInTriangle(pa, pb, pc, At(p)) && Cross2(At(m_prev[p]), At(p), At(m_next[p])) <= 0.0f)
+			return false;
+		}
+	  }
+	}
+	return true;
+  }
+
+  void ClipEars(uint32_t ear, std::vector<uint32_t> &triangles) {
+	uint32_t stop = ear;
+	while (m_prev[ear] != m_next[ear]) {
+	  const uint32_t a = m_prev[ear], c = m_next[ear];
+	  if (IsEar(ear)) {
+		triangles.insert(triangles.end(), {m_point[a], m_point[ear], m_point[c]});
+		Remove(ear);
+		// skipping the next corner gives fewer slivers
+		ear = stop = m_next[c];
+		continue;
+	  }
+	  ear = c;
+	  if (ear != stop)
+		continue;
+	  // A full round without an ear: rounding has made the loop touch or cross itself, which happens
+	  // where it folds back within a few units in the last place. Clipping a convex corner anyway may
+	  // overlap a neighbour there, but every edge stays matched, so the piece stays closed.
+	  uint32_t corner = ear;
+	  do {
+		if (Cross2(At(m_prev[corner]), At(corner), At(m_next[corner])) > 0.0f)
+		  break;
+		corner = m_next[corner];
+	  } while (corner != ear);
+	  triangles.insert(triangles.end(), {m_point[m_prev[corner]], m_point[corner], m_point[m_next[corner]]});
+	  ear = stop = m_next[corner];
+	  Remove(corner);
+	}
+  }
+
+  const std::vector<Vec2> &m_points;
+  std::vector<uint32_t> m_point, m_prev, m_next;
+  std::vector<uint8_t> m_removed;
+  Vec2 m_min{0.0f, 0.0f};
+  float m_scale{0.0f};
+  int m_cells{1};
+  std::vector<uint32_t> m_cellStart, m_cellNodes;
+};
+
+// Groups loops into cut regions: each counterclockwise loop with the clockwise loops directly
+// inside it. Holes with no loop around them and loops without area are dropped.
+std::vector<std::vector<size_t>> GroupLoops(const std::vector<std::vector<Vec2>> &loops) {
+  std::vector<float> areas(loops.size());
+  std::vector<BoundingBox> boxes(loops.size());
+  std::vector<std::vector<size_t>> regions;
+  std::vector<size_t> regionOf(loops.size(), kNone);
+  for (size_t l = 0; l < loops.size(); ++l) {
+	areas[l] = SignedArea(loops[l]);
+	for (auto &&p : loops[l])
+	  boxes[l].Extend(Vec3{p[0], p[1], 0.0f});
+	if (areas[l] > 0.0f) {
+	  regionOf[l] = regions.size();
+	  regions.push_back({l});
+	}
+  }
+  for (size_t h = 0; h < loops.size(); ++h) {
+	if (!(areas[h] < 0.0f))
+	  continue;
+	const Vec2 &p = loops[h].front();
+	size_t around = kNone;
+	for (auto &&region : regions) {
+	  const size_t o = region.front();
+	  if (p[0] < boxes[o].min[0] || p[0] > boxes[o].max[0] || p[1] < boxes[o].min[1] || p[1] > boxes[o].max[1])
+		continue;
+	  if ((around == kNone || areas[o] < areas[around]) && PointInPolygon(loops[o], p))
+		around = o;
+	}
+	if (around != kNone)
+	  regions[regionOf[around]].push_back(h);
+  }
+  return regions;
+}
+
+// Centers for up to two dowels in a cut region: the sample point farthest from its edges, then the
+// sample farthest from that one, both at least `clearance` inside.
+std::vector<Vec2> DowelCenters(const std::vector<std::vector<Vec2>> &loops, const std::vector<size_t> &region, float clearance) {
+  std::vector<Vec2> centers;
+  const std::vector<Vec2> &outer = loops[region.front()];
+  BoundingBox box;
+  for (auto &&p : outer)
+	box.Extend(Vec3{p[0], p[1], 0.0f});
+  const Vec3 size = box.Size();
+  if (size[0] < 2.0f * clearance || size[1] < 2.0f * clearance)
+	return centers;
+
+  struct Sample {
+	Vec2 p;
+	float clearance;
+  };
+  std::vector<Sample> samples;
+  for (int j = 0; j < kDowelSamples; ++j) {
+	for (int i = 0; i < kDowelSamples; ++i) {
+	  const Vec2 p{box.min[0] + size[0] * (static_cast<float>(i) + 0.5f) / kDowelSamples,
+				   box.min[1] + size[1] * (static_cast<float>(j) + 0.5f) / kDowelSamples};
+	  bool inside = false;
+	  float nearest = std::numeric_limits<float>::max();
+	  for (size_t l : region) {
+		const std::vector<Vec2> &loop = loops[l];
+		inside ^= PointInPolygon(loop, p);
+		for (size_t e = 0, f = loop.size() - 1; e < loop.size(); f = e++)
+		  nearest = std::min(nearest, SegmentDistanceSquared(p, loop[f], loop[e]));
+	  }
+	  if (inside && nearest >= clearance * clearance)
+		samples.push_back({p, nearest});
+	}
+  }
+  if (samples.empty())
+	return centers;
+  const Sample &first = *std::max_element(samples.begin(), samples.end(),
+										  [](const Sample &a, const Sample &b) { return a.clearance < b.clearance; });
+  centers.push_back(first.p);
+  float farthest = 4.0f * clearance * clearance; // the holes and their walls must not touch
+  const Sample *second = nullptr;
+  for (auto &&sample : samples) {
+	const float dx = sample.p[0] - first.p[0], dy = sample.p[1] - first.p[1];
+	if (dx * dx + dy * dy >= farthest) {
+	  farthest = dx * dx + dy * dy;
+	  second = &sample;
+	}
+  }
+  if (second)
+	centers.push_back(second->p);
+  return centers;
+}
+
+// Drops the dowels whose holes, with a wall around them, would reach the surface of `mesh` or cross
+// another cutting plane. What is left is surrounded by material on both sides of `plane`.
+void CheckDowels(const Mesh &mesh, const Plane &plane, const std::vector<Plane> &planes, float radius,
+				 std::vector<Vec2> &centers) {
+  const float depth = 2.0f * radius * kDowelDepth;
+  Vec3 half;
+  half[plane.axis] = depth + radius;
+  half[(plane.axis + 1) % 3] = half[(plane.axis + 2) % 3] = 2.0f * radius;
+  std::vector<Vec3> boxCenters;
+  BoundingBox all;
+  for (auto &&center : centers) {
+	const Vec3 c = Unproject(center, plane);
+	boxCenters.push_back(c);
+	all.Extend(c - half);
+	all.Extend(c + half);
+  }
+  std::vector<std::atomic<bool>> blocked(centers.size());
+  for (size_t d = 0; d < centers.size(); ++d) {
+	blocked[d] = false;
+	for (auto &&other : planes) {
+	  const float c = boxCenters[d][other.axis], h = half[other.axis];
+	  if ((other.axis != plane.axis || other.offset != plane.offset) && c - h <= other.offset && other.offset <= c + h)
+		blocked[d] = true;
+	}
+  }
+  const size_t triangles = mesh.TriangleCount();
+  ParallelFor(triangles, kTrianglesPerBlock, [&](size_t begin, size_t end) {
+	for (size_t t = begin; t < end; ++t) {
+	  const Vec3 a = mesh.Corner(t, 0), b = mesh.Corner(t, 1), c = mesh.Corner(t, 2);
+	  BoundingBox box;
+	  box.Extend(a);
+	  box.Extend(b);
+	  box.Extend(c);
+	  if (!box.Overlaps(all))
+		continue;
+	  for (size_t d = 0; d < centers.size(); ++d) {
+		if (!blocked[d].load(std::memory_order_relaxed) && TriangleOverlapsBox(a, b, c, boxCenters[d], half))
+		  blocked[d].store(true, std::memory_order_relaxed);
+	  }
+	}
+  });
+  size_t kept = 0;
+  for (size_t d = 0; d < centers.size(); ++d)
+	if (!blocked[d])
+	  centers[kept++] = centers[d];
+  centers.resize(kept);
+}
+
+void AddTriangle(Mesh &mesh, const Vec3 &a, const Vec3 &b, const Vec3 &c, bool flip) {
+  const uint32_t base = static_cast<uint32_t>(mesh.VertexCount());
+  for (const Vec3 *p : {&a, flip ? &c : &b, flip ? &b : &c})
+	mesh.positions.insert(mesh.positions.end(), p->begin(), p->end());
+  mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2});
+}
+
+// Clips every triangle of `mesh` against `plane` into `below` and `above`. Each block of triangles
+// knows up front how many triangles and vertices it adds to either side, so after a prefix sum all
+// blocks write their share in place on all worker threads. Returns the cut contour.
+std::vector<ContourSegment> Clip(const Mesh &mesh, const Plane &plane, Mesh &below, Mesh &above) {
+  const size_t vertices = mesh.VertexCount(), triangles = mesh.TriangleCount();
+  const int axis = plane.axis;
+  std::vector<uint8_t> side(vertices);
+  ParallelFor(vertices, kVerticesPerBlock, [&](size_t begin, size_t end) {
+	for (size_t v = begin; v < end; ++v)
+	  side[v] = mesh.positions[3 * v + axis] >= plane.offset;
+  });
+  // every vertex is kept on its own side, in order
+  std::vector<uint32_t> remap(vertices);
+  uint32_t kept[2] = {0, 0};
+  for (size_t v = 0; v < vertices; ++v)
+	remap[v] = kept[side[v]]++;
+
+  struct Counts {
+	size_t triangles[2]{0, 0};
+	size_t vertices[2]{0, 0};
+	size_t segments{0};
+  };
+  const size_t blocks = (triangles + kTrianglesPerBlock - 1) / kTrianglesPerBlock;
+  std::vector<Counts> offsets(blocks + 1);
+  ParallelFor(blocks, 1, [&](size_t first, size_t last) {
+	for (size_t b = first; b < last; ++b) {
+	  Counts &counts = offsets[b + 1];
+	  for (size_t t = b * kTrianglesPerBlock, end = std::min(triangles, t + kTrianglesPerBlock); t < end; ++t) {
+		const uint32_t *corner = &mesh.indices[3 * t];
+		const int up = side[corner[0]] + side[corner[1]] + side[corner[2]];
+		if (up == 0 || up == 3) {
+		  ++counts.triangles[up == 3];
+		  continue;
+		}
+		// the lone corner's side gets one triangle, the other side a quad; both get two new points
+		const int lone = up == 1;
+		++counts.triangles[lone];
+		counts.triangles[!lone] += 2;
+		counts.vertices[0] += 2;
+		counts.vertices[1] += 2;
+		++counts.segments;
+	  }
+	}
+  });
+  for (size_t b = 1; b <= blocks; ++b) {
+	for (int s = 0; s < 2; ++s) {
+	  offsets[b].triangles[s] += offsets[b - 1].triangles[s];
+	  offsets[b].vertices[s] += offsets[b - 1].vertices[s];
+	}
+	offsets[b].segments += offsets[b - 1].segments;
+  }
+
+  Mesh *out[2] = {&below, &above};
+  for (int s = 0; s < 2; ++s) {
+	out[s]->positions.resize(3 * (kept[s] + offsets[blocks].vertices[s]));
+	out[s]->indices.resize(3 * offsets[blocks].triangles[s]);
+  }
+  ParallelFor(vertices, kVerticesPerBlock, [&](size_t begin, size_t end) {
+	for (size_t v = begin; v < end; ++v)
+	  std::copy_n(&mesh.positions[3 * v], 3, &out[side[v]]->positions[3 * remap[v]]);
+  });
+  std::vector<ContourSegment> segments(offsets[blocks].segments);
+  ParallelFor(blocks, 1, [&](size_t first, size_t last) {
+	for (size_t b = first; b < last; ++b) {
+	  size_t triangle[2] = {offsets[b].triangles[0], offsets[b].triangles[1]};
+	  uint32_t vertex[2] = {static_cast<uint32_t>(kept[0] + offsets[b].vertices[0]),
+							static_cast<uint32_t>(kept[1] + offsets[b].vertices[1])};
+	  size_t segment = offsets[b].segments;
+	  auto emit = [&](int s, uint32_t i0, uint32_t i1, uint32_t i2) {
+		uint32_t *indices = &out[s]->indices[3 * triangle[s]++];
+		indices[0] = i0;
+		indices[1] = i1;
+		indices[2] = i2;
+	  };
+	  auto point = [&](int s, const Vec3 &p) {
+		std::copy(p.begin(), p.end(), &out[s]->positions[3 * vertex[s]]);
+		return vertex[s]++;
+	  };
+	  for (size_t t = b * kTrianglesPerBlock, end = std::min(triangles, t + kTrianglesPerBlock); t < end; ++t) {
+		const uint32_t *corner = &mesh.indices[3 * t];
+		const int up = side[corner[0]] + side[corner[1]] + side[corner[2]];
+		if (up == 0 || up == 3) {
+		  const int s = up == 3;
+		  emit(s, remap[corner[0]], remap[corner[1]], remap[corner[2]]);
+		  continue;
+		}
+		const int lone = up == 1;
+		int l = 0;
+		while (side[corner[l]] != lone)
+		  ++l;
+		const uint32_t il = corner[l], ib = corner[(l + 1) % 3], ic = corner[(l + 2) % 3];
+		const Vec3 pl = mesh.Vertex(il), pb = mesh.Vertex(ib), pc = mesh.Vertex(ic);
+		const Vec3 xb = lone ? Crossing(pb, pl, plane) : Crossing(pl, pb, plane);
+		const Vec3 xc = lone ? Crossing(pc, pl, plane) : Crossing(pl, pc, plane);
+		emit(lone, remap[il], point(lone, xb), point(lone, xc));
+		const uint32_t ob = point(!lone, xb), oc = point(!lone, xc);
+		emit(!lone, ob, remap[ib], remap[ic]);
+		emit(!lone, ob, remap[ic], oc);
+
+		// Directed so the solid lies on its left seen from +axis. This follows from the winding alone;
+		// the direction of the points would be noise for the tiny pieces cut next to a vertex.
+		ContourSegment &cut = segments[segment++];
+		cut.from = Project(lone ? xb : xc, axis);
+		cut.to = Project(lone ? xc : xb, axis);
+	  }
+	}
+  });
+  segments.erase(std::remove_if(segments.begin(), segments.end(), [](const ContourSegment &s) { return s.from == s.to; }),
+				 segments.end());
+  return segments;
+}
+
+// Cuts `mesh` in two along `plane` and closes both halves. `planes` are all the cuts of the split,
+// which dowel holes must stay clear of.
+void SplitAlong(const Mesh &mesh, const Plane &plane, const std::vector<Plane> &planes, const SplitOptions &options,
+				Mesh &below, Mesh &above) {
+  std::vector<std::vector<Vec2>> loops = JoinSegments(Clip(mesh, plane, below, above));
+  std::vector<std::vector<size_t>> regions = GroupLoops(loops);
+
+  // Dowel holes join the cap as extra clockwise loops, and get walls and a floor on either side.
+  const float radius = 0.5f * options.dowelDiameter;
+  std::vector<std::vector<Vec2>> dowels;
+  if (radius > 0.0f) {
+	for (auto &&region : regions) {
+	  std::vector<Vec2> centers = DowelCenters(loops, region, 2.0f * radius);
+	  CheckDowels(mesh, plane, planes, radius, centers);
+	  for (auto &&center : centers) {
+		std::vector<Vec2> ring(kDowelSegments);
+		for (int i = 0; i < kDowelSegments; ++i) {
+		  const float angle = kTwoPi * static_cast<float>(i) / kDowelSegments;
+		  ring[i] = {center[0] + radius * std::cos(angle), center[1] + radius * std::sin(angle)};
+		}
+		region.push_back(loops.size());
+		loops.emplace_back(ring.rbegin(), ring.rend());
+		dowels.push_back(std::move(ring));
+	  }
+	}
+  }
+
+  std::vector<Vec2> points;
+  std::vector<std::pair<uint32_t, uint32_t>> ranges(loops.size());
+  for (size_t l = 0; l < loops.size(); ++l) {
+	ranges[l].first = static_cast<uint32_t>(points.size());
+	points.insert(points.end(), loops[l].begin(), loops[l].end());
+	ranges[l].second = static_cast<uint32_t>(points.size());
+  }
+  std::vector<std::vector<uint32_t>> regionTriangles(regions.size());
+  ParallelFor(regions.size(), 1, [&](size_t begin, size_t end) {
+	for (size_t r = begin; r < end; ++r) {
+	  std::vector<std::pair<uint32_t, uint32_t>> region;
+	  for (size_t l : regions[r])
+		region.push_back(ranges[l]);
+	  EarClipper(points).Triangulate(region, regionTriangles[r]);
+	}
+  });
+
+  // The cap faces +axis on the lower half and -axis on the upper one.
+  for (int s = 0; s < 2; ++s) {
+	Mesh &half = s ? above : below;
+	const uint32_t base = static_cast<uint32_t>(half.VertexCount());
+	half.positions.reserve(half.positions.size() + 3 * points.size());
+	for (auto &&p : points) {
+	  const Vec3 q = Unproject(p, plane);
+	  half.positions.insert(half.positions.end(), q.begin(), q.end());
+	}
+	for (auto &&triangles : regionTriangles) {
+	  for (size_t i = 0; i < triangles.size(); i += 3) {
+		half.indices.insert(half.indices.end(), {base + triangles[i], base + triangles[i + (s ? 2 : 1)],
+												 base + triangles[i + (s ? 1 : 2)]});
+	  }
+	}
+	const float depth = (s ? 2.0f : -2.0f) * radius * kDowelDepth;
+	for (auto &&ring : dowels) {
+	  Vec2 center{0.0f, 0.0f};
+	  for (auto &&p : ring)
+		center = {center[0] + p[0] / kDowelSegments, center[1] + p[1] / kDowelSegments};
+	  const Plane floor{plane.axis, plane.offset + depth};
+	  const Vec3 middle = Unproject(center, floor);
+	  for (int i = 0; i < kDowelSegments; ++i) {
+		const Vec2 &p = ring[i], &q = ring[(i + 1) % kDowelSegments];
+		const Vec3 top0 = Unproject(p, plane), top1 = Unproject(q, plane);
+		const Vec3 bottom0 = Unproject(p, floor), bottom1 = Unproject(q, floor);
+		AddTriangle(half, top0, bottom1, bottom0, s);
+		AddTriangle(half, top0, top1, bottom1, s);
+		AddTriangle(half, middle, bottom0, bottom1, s);
+	  }
+	}
+  }
+}
+}
+
+std::array<int, 3> PlanSplit(const BoundingBox &box, const SplitOptions &options) {
+  std::array<int, 3> slabs{1, 1, 1};
+  if (box.IsEmpty())
+	return slabs;
+  const Vec3 size = box.Size();
+  // room for the planes to move away from vertices
+  auto count = [](float length, float limit) {
+	if (length <= limit || limit <= 2.0f * kPlaneShift)
+	  return 1;
+	return std::clamp(static_cast<int>(std::ceil(length / (limit - 2.0f * kPlaneShift))), 1, kMaxSlabs);
+  };
+  const std::array<int, 3> turned{count(size[0], options.volume[1]), count(size[1], options.volume[0]),
+								  count(size[2], options.volume[2])};
+  for (int axis = 0; axis < 3; ++axis)
+	slabs[axis] = count(size[axis], options.volume[axis]);
+  return turned[0] * turned[1] < slabs[0] * slabs[1] ? turned : slabs;
+}
+
+std::vector<Mesh> SplitToBuildVolume(const Mesh &mesh, const SplitOptions &options) {
+  std::vector<Mesh> pieces;
+  const BoundingBox box = mesh.Bounds();
+  const std::array<int, 3> slabs = PlanSplit(box, options);
+  std::vector<Plane> planes;
+  for (int axis = 0; axis < 3; ++axis) {
+	for (int i = 1; i < slabs[axis]; ++i) {
+	  Plane plane{axis, box.min[axis] + (box.max[axis] - box.min[axis]) * static_cast<float>(i) / slabs[axis]};
+	  AvoidVertices(mesh, plane);
+	  planes.push_back(plane);
+	}
+  }
+  pieces.push_back(mesh);
+  if (planes.empty())
+	return pieces;
+
+  // One axis at a time, each piece from its lower end up, so a plane only sees the part above the
+  // previous one.
+  for (int axis = 0; axis < 3; ++axis) {
+	std::vector<Mesh> next;
+	for (Mesh &piece : pieces) {
+	  Mesh rest = std::move(piece);
+	  for (auto &&plane : planes) {
+		if (plane.axis != axis)
+		  continue;
+		const BoundingBox bounds = rest.Bounds();
+		if (bounds.min[axis] >= plane.offset)
+		  continue;
+		if (bounds.max[axis] < plane.offset)
+		  break;
+		Mesh below, above;
+		SplitAlong(rest, plane, planes, options, below, above);
+		if (!below.Empty())
+		  next.push_back(std::move(below));
+		rest = std::move(above);
+	  }
+	  if (!rest.Empty())
+		next.push_back(std::move(rest));
+	}
+	pieces.swap(next);
+  }
+  return pieces;
+}
@@ -0,0 +1,27 @@
+#ifndef STLHELPER__EXPORTERSPLIT_H_
+#define STLHELPER__EXPORTERSPLIT_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <array>
+#include <vector>
+
+struct SplitOptions {
+  Vec3 volume{20.0f, 20.0f, 20.0f}; // centimeters the printer can build along X, Y and Z
+  float dowelDiameter{0.0f}; // holes for alignment pins on the cut faces, zero for none
+};
+
+// Number of equal slabs each axis has to be cut into for every piece to fit `options.volume`. A
+// quarter turn about Z is allowed when it needs fewer pieces. All ones if the box fits already.
+std::array<int, 3> PlanSplit(const BoundingBox &box, const SplitOptions &options);
+
+// Cuts `mesh` with the planes PlanSplit asks for and closes every cut with a flat cap, so a closed
+// mesh gives closed pieces. Triangles are clipped against each plane on all worker threads; the
+// cut contours are chained into loops and the caps triangulated by ear clipping with holes bridged
+// in. With a dowel diameter, up to two blind holes are sunk into each cut region wide enough to
+// hold them with a wall around, at matching spots on both pieces. Pieces that come out empty are
+// left out, so the result can have fewer pieces than the plan; a mesh that fits is returned whole.
+std::vector<Mesh> SplitToBuildVolume(const Mesh &mesh, const SplitOptions &options);
+
+#endif //STLHELPER__EXPORTERSPLIT_H_
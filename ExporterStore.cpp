@@ -0,0 +1,101 @@
+#include "ExporterStore.h"
+#include "ExporterCommit.h"
+#include "ExporterHash.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Bump when a writer changes its output, so files from older versions are no longer matched.
+constexpr uint32_t kKeyVersion = 2;
+constexpr auto kGracePeriod = std::chrono::minutes(10);
+
+bool IsFanOutFolder(const fs::path &path) {
+  const std::string name = path.filename().string();
+  return name.size() == 2 && std::isxdigit(static_cast<unsigned char>(name[0]))
+	  && std::isxdigit(static_cast<unsigned char>(name[1]));
+}
+}
+
+bool ContentStore::Open() const {
+  std::error_code error;
+  fs::create_directories(m_folder, error);
+  if (error)
+	return false;
+  for (fs::directory_iterator it(m_folder, error), end; !error && it != end; it.increment(error)) {
+	if (IsFanOutFolder(it->path()))
+	  FileCommitter::RemoveStaleTemps(it->path());
+  }
+  return true;
+}
+
+ContentStore::Key ContentStore::KeyFor(const Mesh &mesh, const OutputTarget &target) {
+  Sha256 hash;
+  const int32_t settings[] = {static_cast<int32_t>(kKeyVersion), static_cast<int32_t>(target.format),
+							  static_cast<int32_t>(target.units), target.decimation, target.digits, target.gridBits,
+							  target.layerMicrons};
+  hash.Update(settings, sizeof(settings));
+  const uint64_t sizes[] = {mesh.positions.size(), mesh.indices.size()};
+  hash.Update(sizes, sizeof(sizes));
+  hash.Update(mesh.positions.data(), mesh.positions.size() * sizeof(float));
+  hash.Update(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+  return hash.Value();
+}
+
+fs::path ContentStore::ObjectPath(const Key &key, const fs::path &extension) const {
+  char name[2 * sizeof(Key) + 1];
+  for (size_t i = 0; i < key.size(); ++i)
+	std::snprintf(name + 2 * i, 3, "%02x", key[i]);
+  return m_folder / std::string(name, 2) / (std::string(name + 2) + extension.string());
+}
+
+bool ContentStore::ClaimWrite(const Key &key, uint64_t &contentHash) const {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+	auto [claim, first] = m_claims.emplace(key, std::nullopt);
+	if (first)
+	  return true;
+	if (claim->second) {
+	  contentHash = *claim->second;
+	  return false;
+	}
+	m_finished.wait(lock);
+  }
+}
+
+void ContentStore::FinishWrite(const Key &key, bool queued, uint64_t contentHash) const {
+  {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (queued)
+	  m_claims[key] = contentHash;
+	else
+	  m_claims.erase(key);
+  }
+  m_finished.notify_all();
+}
+
+uint64_t ContentStore::CollectGarbage() const {
+  uint64_t freed = 0;
+  const auto cutoff = fs::file_time_type::clock::now() - kGracePeriod;
+  std::error_code error;
+  for (fs::directory_iterator folder(m_folder, error), end; !error && folder != end; folder.increment(error)) {
+	if (!IsFanOutFolder(folder->path()))
+	  continue;
+	std::error_code inner;
+	for (fs::directory_iterator it(folder->path(), inner); !inner && it != end; it.increment(inner)) {
+	  std::error_code ignored;
+	  if (!it->is_regular_file(ignored) || it->hard_link_count(ignored) != 1 || ignored)
+		continue;
+	  const auto written = it->last_write_time(ignored);
+	  if (ignored || written > cutoff)
+		continue;
+	  const uint64_t size = it->file_size(ignored);
+	  if (fs::remove(it->path(), ignored))
+		freed += size;
+	}
+  }
+  return freed;
+}
@@ -0,0 +1,58 @@
+#ifndef STLHELPER__EXPORTERSTORE_H_
+#define STLHELPER__EXPORTERSTORE_H_
+#pragma once
+
+#include "ExporterHash.h"
+#include "ExporterTargets.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+
+// Content-addressed store for output files. A file is written once, named after a hash of the
+// mesh and target settings it is made from, and every named file with the same contents is a hard
+// link to it (or a copy where the file system cannot link). The link count of a stored file is its
+// reference count: files no named file links to any more are deleted by CollectGarbage.
+class ContentStore {
+ public:
+  explicit ContentStore(std::filesystem::path folder) : m_folder(std::move(folder)) {}
+
+  const std::filesystem::path &Folder() const { return m_folder; }
+
+  // Creates the store folder and removes temporary files a crashed run left in it.
+  bool Open() const;
+
+  // Identifies the file WriteTarget produces for `mesh` and `target`; the writers are deterministic,
+  // so equal keys mean equal files. A SHA-256 digest, as an existing file with the same key is
+  // linked without being compared.
+  using Key = Sha256::Digest;
+  static Key KeyFor(const Mesh &mesh, const OutputTarget &target);
+
+  // Where the file for `key` lives. Files are spread over 256 subfolders by their first byte.
+  std::filesystem::path ObjectPath(const Key &key, const std::filesystem::path &extension) const;
+
+  // Claims the file for `key` for the calling writer job. A file only appears in the store once its
+  // commit batch does, so jobs of one export needing the same key would all miss it and write it.
+  // The first claim returns true and the job writes the file, then calls FinishWrite. Later claims
+  // wait for that and return false once the file is queued, with its StreamHash in `contentHash`;
+  // their jobs link to it.
+  bool ClaimWrite(const Key &key, uint64_t &contentHash) const;
+
+  // Ends a claim. Unless the file was `queued` for commit, the next claim of `key` writes it.
+  void FinishWrite(const Key &key, bool queued, uint64_t contentHash = 0) const;
+
+  // Deletes stored files that are no longer linked from anywhere, except ones written recently,
+  // which another export may be about to link. Returns the number of bytes freed.
+  uint64_t CollectGarbage() const;
+
+ private:
+  std::filesystem::path m_folder;
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_finished;
+  mutable std::map<Key, std::optional<uint64_t>> m_claims; // content hashes of queued files
+};
+
+#endif //STLHELPER__EXPORTERSTORE_H_
@@ -0,0 +1,259 @@
+#include "ExporterTargets.h"
+#include "ExporterSTL.h"
+#include "ExporterHash.h"
+#include "ExporterSTLReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+struct UnitName {
+  OutputUnits units;
+  const char *name;
+  float scale;
+};
+const UnitName kUnitNames[] = {
+	{OutputUnits::Millimeters, "mm", 10.0f},
+	{OutputUnits::Centimeters, "cm", 1.0f},
+	{OutputUnits::Meters, "m", 0.01f},
+	{OutputUnits::Inches, "in", 1.0f / 2.54f},
+};
+
+std::string Trim(const std::string &s) {
+  size_t first = s.find_first_not_of(" \t\r");
+  if (first == std::string::npos)
+	return {};
+  return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+std::string Lower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return s;
+}
+
+void ReplaceAll(std::string &s, const std::string &token, const std::string &value) {
+  for (size_t at = s.find(token); at != std::string::npos; at = s.find(token, at + value.size()))
+	s.replace(at, token.size(), value);
+}
+
+const char *Extension(OutputFormat format) {
+  switch (format) {
+	case OutputFormat::BinarySTL: return ".stl";
+	case OutputFormat::AsciiSTL: return ".stl";
+	case OutputFormat::CompactMesh: return ".secm";
+	case OutputFormat::SliceSVG: return ".svg";
+	case OutputFormat::SliceContours: return ".secl";
+  }
+  return ".stl";
+}
+
+std::string FormatName(const OutputTarget &target) {
+  switch (target.format) {
+	case OutputFormat::BinarySTL: return "stl";
+	case OutputFormat::AsciiSTL: return target.digits > 0 ? "ascii:" + std::to_string(target.digits) : "ascii";
+	case OutputFormat::CompactMesh:
+	  return target.gridBits != kDefaultCompactBits ? "compact:" + std::to_string(target.gridBits) : "compact";
+	case OutputFormat::SliceSVG:
+	  return target.layerMicrons != kDefaultLayerMicrons ? "svg:" + std::to_string(target.layerMicrons) : "svg";
+	case OutputFormat::SliceContours:
+	  return target.layerMicrons != kDefaultLayerMicrons ? "contours:" + std::to_string(target.layerMicrons) : "contours";
+  }
+  return "stl";
+}
+
+bool ParseFormat(const std::string &text, OutputTarget &target) {
+  std::string name = Lower(text);
+  if (name.empty() || name == "stl" || name == "binary stl") {
+	target.format = OutputFormat::BinarySTL;
+	return true;
+  }
+  long option = 0;
+  const size_t colon = name.find(':');
+  if (colon != std::string::npos) {
+	char *end = nullptr;
+	option = std::strtol(name.c_str() + colon + 1, &end, 10);
+	if (colon + 1 == name.size() || *end != '\0')
+	  return false;
+	name = Trim(name.substr(0, colon));
+  }
+  if (name == "ascii" || name == "ascii stl") {
+	if (colon != std::string::npos && (option < 1 || option > kMaxAsciiDigits))
+	  return false;
+	target.format = OutputFormat::AsciiSTL;
+	target.digits = static_cast<int>(option);
+	return true;
+  }
+  if (name == "compact") {
+	if (colon != std::string::npos && (option < kMinCompactBits || option > kMaxCompactBits))
+	  return false;
+	target.format = OutputFormat::CompactMesh;
+	target.gridBits = colon != std::string::npos ? static_cast<int>(option) : kDefaultCompactBits;
+	return true;
+  }
+  if (name == "svg" || name == "contours") {
+	if (colon != std::string::npos && (option < kMinLayerMicrons || option > kMaxLayerMicrons))
+	  return false;
+	target.format = name == "svg" ? OutputFormat::SliceSVG : OutputFormat::SliceContours;
+	target.layerMicrons = colon != std::string::npos ? static_cast<int>(option) : kDefaultLayerMicrons;
+	return true;
+  }
+  return false;
+}
+
+bool ParseUnits(const std::string &text, OutputUnits &units) {
+  std::string name = Lower(text);
+  if (name.empty()) {
+	units = OutputUnits::Millimeters;
+	return true;
+  }
+  for (auto &&u : kUnitNames) {
+	if (name == u.name) {
+	  units = u.units;
+	  return true;
+	}
+  }
+  return false;
+}
+}
+
+float UnitScale(OutputUnits units) {
+  for (auto &&u : kUnitNames)
+	if (u.units == units)
+	  return u.scale;
+  return kCentimetersToMillimeters;
+}
+
+std::string TargetFileName(const OutputTarget &target, const NameFields &fields) {
+  std::string fileName;
+  if (target.nameTemplate.empty()) {
+	if (!fields.prefix.empty()) {
+	  fileName += fields.prefix;
+	  fileName += fields.separator;
+	}
+	if (!fields.component.empty()) {
+	  fileName += fields.component;
+	  fileName += fields.separator;
+	}
+	fileName += fields.body;
+	if (!fields.suffix.empty()) {
+	  fileName += fields.separator;
+	  fileName += fields.suffix;
+	}
+  } else {
+	fileName = target.nameTemplate;
+	ReplaceAll(fileName, "{prefix}", fields.prefix);
+	ReplaceAll(fileName, "{component}", fields.component);
+	ReplaceAll(fileName, "{body}", fields.body);
+	ReplaceAll(fileName, "{suffix}", fields.suffix);
+	ReplaceAll(fileName, "{sep}", fields.separator);
+  }
+  fileName += Extension(target.format);
+  return fileName;
+}
+
+bool ParseTargets(const std::string &text, std::vector<OutputTarget> &targets) {
+  std::vector<OutputTarget> parsed;
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+	line = Trim(line);
+	if (line.empty() || line[0] == '#')
+	  continue;
+	std::vector<std::string> fields;
+	std::istringstream columns(line);
+	std::string column;
+	while (std::getline(columns, column, '|'))
+	  fields.push_back(Trim(column));
+	fields.resize(std::max<size_t>(fields.size(), 5));
+	if (fields.size() > 5 || fields[0].empty())
+	  return false;
+
+	OutputTarget target;
+	target.folder = fields[0];
+	if (!ParseFormat(fields[1], target) || !ParseUnits(fields[2], target.units))
+	  return false;
+	if (!fields[3].empty()) {
+	  char *end = nullptr;
+	  long level = std::strtol(fields[3].c_str(), &end, 10);
+	  if (*end != '\0' || level < 0 || level > kMaxDecimationLevel)
+		return false;
+	  target.decimation = static_cast<int>(level);
+	}
+	target.nameTemplate = fields[4];
+	parsed.push_back(std::move(target));
+  }
+  targets = std::move(parsed);
+  return true;
+}
+
+std::string FormatTargets(const std::vector<OutputTarget> &targets) {
+  std::string text;
+  for (auto &&target : targets) {
+	if (!text.empty())
+	  text += "\n";
+	text += target.folder.string();
+	text += " | ";
+	text += FormatName(target);
+	text += " | ";
+	for (auto &&u : kUnitNames)
+	  if (u.units == target.units)
+		text += u.name;
+	text += " | ";
+	text += std::to_string(target.decimation);
+	if (!target.nameTemplate.empty()) {
+	  text += " | ";
+	  text += target.nameTemplate;
+	}
+  }
+  return text;
+}
+
+bool WriteTarget(const Mesh &mesh,
+				 const OutputTarget &target,
+				 const std::filesystem::path &path,
+				 STLSummary *summary) {
+  const Mesh *source = &mesh;
+  if (target.decimation > 0) {
+	// Writer threads live for one run, so this scratch copy is reused across its files and freed with it.
+	thread_local Mesh decimated;
+	decimated.positions.assign(mesh.positions.begin(), mesh.positions.end());
+	decimated.indices.assign(mesh.indices.begin(), mesh.indices.end());
+	ClusterVertices(decimated, 2048u >> std::min(target.decimation, kMaxDecimationLevel));
+	source = &decimated;
+  }
+  switch (target.format) {
+	case OutputFormat::BinarySTL: return WriteBinarySTL(*source, path, UnitScale(target.units), summary);
+	case OutputFormat::AsciiSTL: return WriteAsciiSTL(*source, path, UnitScale(target.units), target.digits, summary);
+	case OutputFormat::CompactMesh: return WriteCompactMesh(*source, path, UnitScale(target.units), target.gridBits, summary);
+	case OutputFormat::SliceSVG:
+	case OutputFormat::SliceContours: {
+	  const float layerHeight = target.layerMicrons * 1e-4f; // centimeters
+	  // targets are written on the writer threads, which already keep every core busy
+	  const std::vector<SliceLayer> layers = SliceMesh(*source, layerHeight, Parallelism::Serial);
+	  return target.format == OutputFormat::SliceSVG
+		  ? WriteSliceSVG(layers, path, UnitScale(target.units), layerHeight, summary)
+		  : WriteSliceContours(layers, path, UnitScale(target.units), layerHeight, summary);
+	}
+  }
+  return false;
+}
+
+bool VerifyTarget(const OutputTarget &target, const std::filesystem::path &path, const STLSummary &expected) {
+  switch (target.format) {
+	case OutputFormat::BinarySTL:
+	case OutputFormat::AsciiSTL: return VerifySTL(path, expected);
+	case OutputFormat::CompactMesh: {
+	  Mesh mesh;
+	  uint64_t hash = 0;
+	  return ReadCompactMesh(path, mesh, &hash) && MatchesSummary(mesh, hash, expected);
+	}
+	case OutputFormat::SliceSVG:
+	case OutputFormat::SliceContours: {
+	  uint64_t hash = 0;
+	  return HashFile(path, hash) && hash == expected.contentHash;
+	}
+  }
+  return false;
+}
@@ -0,0 +1,83 @@
+#ifndef STLHELPER__EXPORTERTARGETS_H_
+#define STLHELPER__EXPORTERTARGETS_H_
+#pragma once
+
+#include "ExporterCompact.h"
+#include "ExporterSTL.h"
+#include "ExporterSlicing.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+enum class OutputFormat {
+  BinarySTL,
+  AsciiSTL,
+  CompactMesh,
+  SliceSVG, // layer contours instead of a mesh
+  SliceContours,
+};
+
+enum class OutputUnits {
+  Millimeters,
+  Centimeters,
+  Meters,
+  Inches,
+};
+
+constexpr int kMaxDecimationLevel = 8;
+
+// One destination for every exported body. The dialog's own settings form the primary target;
+// further targets reuse the same tessellation and are written in parallel.
+struct OutputTarget {
+  std::filesystem::path folder;
+  OutputFormat format{OutputFormat::BinarySTL};
+  OutputUnits units{OutputUnits::Millimeters};
+  int decimation{0}; // 0 writes the full tessellation, each level halves the clustering grid
+  int digits{0}; // significant digits of ASCII numbers, 0 for exact
+  int gridBits{kDefaultCompactBits}; // quantization of compact meshes
+  int layerMicrons{kDefaultLayerMicrons}; // layer height of sliced formats
+  std::string nameTemplate; // empty keeps the prefix/component/body/suffix naming of the dialog
+
+  // True if Fusion's own STL export would produce the same file.
+  bool IsNative() const {
+	return format == OutputFormat::BinarySTL && units == OutputUnits::Millimeters && decimation == 0;
+  }
+};
+
+// The pieces a file name is made of; `component` is empty when it should not be included.
+struct NameFields {
+  std::string prefix;
+  std::string component;
+  std::string body;
+  std::string suffix;
+  std::string separator;
+};
+
+// Scale from Fusion's centimeters to `units`.
+float UnitScale(OutputUnits units);
+
+// File name (with extension) for a body written to `target`. Templates may use {prefix},
+// {component}, {body}, {suffix} and {sep}.
+std::string TargetFileName(const OutputTarget &target, const NameFields &fields);
+
+// Reads targets from text with one target per line:
+//   folder | format | units | decimation | name template
+// Formats are "stl", "ascii", optionally with digits ("ascii:6"), "compact", optionally with
+// grid bits ("compact:12"), and the sliced "svg" and "contours", optionally with the layer height
+// in micrometers ("svg:25"). Only the folder is required. Blank lines and lines starting with '#'
+// are skipped. Returns false and leaves `targets` untouched if any line is malformed.
+bool ParseTargets(const std::string &text, std::vector<OutputTarget> &targets);
+std::string FormatTargets(const std::vector<OutputTarget> &targets);
+
+// Writes `mesh` in the target's format, units and level of detail. If `summary` is given it
+// describes the file contents.
+bool WriteTarget(const Mesh &mesh,
+				 const OutputTarget &target,
+				 const std::filesystem::path &path,
+				 STLSummary *summary = nullptr);
+
+// Reads a file written by WriteTarget back and checks it against `expected`.
+bool VerifyTarget(const OutputTarget &target, const std::filesystem::path &path, const STLSummary &expected);
+
+#endif //STLHELPER__EXPORTERTARGETS_H_
@@ -0,0 +1,27 @@
+#include "ExporterTessellation.h"
+
+namespace ac = adsk::core;
+namespace af = adsk::fusion;
+
+bool TessellateBody(const ac::Ptr<af::BRepBody> &body, af::TriangleMeshQualityOptions quality, Mesh &mesh) {
+  mesh.Clear();
+  if (!body)
+	return false;
+  auto meshManager = body->meshManager();
+  if (!meshManager)
+	return false;
+  auto calculator = meshManager->createMeshCalculator();
+  if (!calculator)
+	return false;
+  calculator->setQuality(quality);
+  auto triangles = calculator->calculate();
+  if (!triangles)
+	return false;
+
+  // assigned rather than moved in, so a recycled mesh keeps its buffer
+  const std::vector<float> coordinates = triangles->nodeCoordinatesAsFloat();
+  mesh.positions.assign(coordinates.begin(), coordinates.end());
+  std::vector<int> indices = triangles->nodeIndices();
+  mesh.indices.assign(indices.begin(), indices.end());
+  return mesh.indices.size() % 3 == 0 && !mesh.positions.empty();
+}
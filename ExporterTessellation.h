@@ -0,0 +1,16 @@
+#ifndef STLHELPER__EXPORTERTESSELLATION_H_
+#define STLHELPER__EXPORTERTESSELLATION_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <Core/CoreAll.h>
+#include <Fusion/FusionAll.h>
+
+// Tessellates `body` with Fusion's mesh calculator into `mesh`. Coordinates are in centimeters, in
+// the assembly context of the body (proxies are meshed where they sit in the design).
+bool TessellateBody(const adsk::core::Ptr<adsk::fusion::BRepBody> &body,
+					adsk::fusion::TriangleMeshQualityOptions quality,
+					Mesh &mesh);
+
+#endif //STLHELPER__EXPORTERTESSELLATION_H_
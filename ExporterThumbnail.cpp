@@ -0,0 +1,396 @@
+#include "ExporterThumbnail.h"
+#include "ExporterIO.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+// Edge functions are evaluated for kLanes neighbouring pixels at once in plain arrays, which the
+// compiler maps onto SIMD registers.
+constexpr int kLanes = 8;
+constexpr int kTileSize = 64; // samples; a tile's depth buffer stays in L1
+constexpr int kSupersample = 2;
+constexpr float kMargin = 0.04f;
+
+// Isometric view from the front right and above: right, up and towards the viewer.
+const Vec3 kRight{0.70710678f, 0.70710678f, 0.0f};
+const Vec3 kUp{-0.40824829f, 0.40824829f, 0.81649658f};
+const Vec3 kToViewer{0.57735027f, -0.57735027f, 0.57735027f};
+
+struct Projected {
+  std::vector<float> x, y, depth; // per vertex, in samples
+};
+
+struct Canvas {
+  int size{0}; // samples per side
+  std::vector<uint8_t> gray, coverage;
+};
+
+uint8_t Shade(const Mesh &mesh, size_t triangle) {
+  const Vec3 n = mesh.FaceNormal(triangle);
+  const Vec3 light = kToViewer * 0.6f + kUp * 0.6f - kRight * 0.3f;
+  const float length = std::sqrt(Dot(light, light));
+  // open meshes show their inside, which is lit like the outside
+  float lambert = std::abs(Dot(n, light)) / length;
+  return static_cast<uint8_t>(255.0f * (0.25f + 0.7f * lambert));
+}
+
+// Rasterizes the triangles listed for one tile with a depth buffer local to the tile.
+void DrawTile(const Mesh &mesh,
+			  const Projected &projected,
+			  const uint32_t *triangles,
+			  size_t count,
+			  int tileX,
+			  int tileY,
+			  Canvas &canvas) {
+  float depth[kTileSize * kTileSize];
+  std::fill(depth, depth + kTileSize * kTileSize, -std::numeric_limits<float>::max());
+  const int x0 = tileX * kTileSize, y0 = tileY * kTileSize;
+  const int x1 = std::min(x0 + kTileSize, canvas.size), y1 = std::min(y0 + kTileSize, canvas.size);
+
+  for (size_t i = 0; i < count; ++i) {
+	const size_t t = triangles[i];
+	const uint32_t v[3] = {mesh.indices[3 * t], mesh.indices[3 * t + 1], mesh.indices[3 * t + 2]};
+	float px[3], py[3], pz[3];
+	for (int c = 0; c < 3; ++c) {
+	  px[c] = projected.x[v[c]];
+	  py[c] = projected.y[v[c]];
+	  pz[c] = projected.depth[v[c]];
+	}
+	float area = (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]);
+	if (area == 0.0f)
+	  continue;
+	// Edge function of the edge opposite each corner, as A * x + B * y + C, positive inside.
+	const float sign = area > 0.0f ? 1.0f : -1.0f;
+	float a[3], b[3], c[3];
+	for (int e = 0; e < 3; ++e) {
+	  const int p = (e + 1) % 3, q = (e + 2) % 3;
+	  a[e] = sign * (py[p] - py[q]);
+	  b[e] = sign * (px[q] - px[p]);
+	  c[e] = sign * (px[p] * py[q] - px[q] * py[p]);
+	}
+	const float inverseArea = 1.0f / (area * sign);
+	const int minX = std::max(x0, static_cast<int>(std::floor(std::min({px[0], px[1], px[2]}))));
+	const int maxX = std::min(x1 - 1, static_cast<int>(std::ceil(std::max({px[0], px[1], px[2]}))));
+	const int minY = std::max(y0, static_cast<int>(std::floor(std::min({py[0], py[1], py[2]}))));
+	const int maxY = std::min(y1 - 1, static_cast<int>(std::ceil(std::max({py[0], py[1], py[2]}))));
+	if (minX > maxX || minY > maxY)
+	  continue;
+	const uint8_t shade = Shade(mesh, t);
+
+	for (int y = minY; y <= maxY; ++y) {
+	  const float sy = y + 0.5f;
+	  for (int x = minX; x <= maxX; x += kLanes) {
+		float w[3][kLanes], z[kLanes];
+		bool inside[kLanes];
+		for (int k = 0; k < kLanes; ++k) {
+		  const float sx = x + k + 0.5f;
+		  for (int e = 0; e < 3; ++e)
+			w[e][k] = a[e] * sx + b[e] * sy + c[e];
+		  inside[k] = w[0][k] >= 0.0f && w[1][k] >= 0.0f && w[2][k] >= 0.0f && x + k <= maxX;
+		  z[k] = (w[0][k] * pz[0] + w[1][k] * pz[1] + w[2][k] * pz[2]) * inverseArea;
+		}
+		float *row = depth + (y - y0) * kTileSize + (x - x0);
+		for (int k = 0; k < kLanes; ++k) {
+		  if (!inside[k] || z[k] <= row[k])
+			continue;
+		  row[k] = z[k];
+		  const size_t at = static_cast<size_t>(y) * canvas.size + x + k;
+		  canvas.gray[at] = shade;
+		  canvas.coverage[at] = 1;
+		}
+	  }
+	}
+  }
+}
+
+// --- PNG ---
+
+uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+  static const auto table = [] {
+	std::vector<uint32_t> t(256);
+	for (uint32_t n = 0; n < 256; ++n) {
+	  uint32_t c = n;
+	  for (int k = 0; k < 8; ++k)
+		c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+	  t[n] = c;
+	}
+	return t;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+	crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+uint32_t Adler32(const uint8_t *data, size_t size) {
+  uint32_t a = 1, b = 0;
+  while (size > 0) {
+	const size_t block = std::min<size_t>(size, 5552); // largest run without overflow
+	for (size_t i = 0; i < block; ++i) {
+	  a += data[i];
+	  b += a;
+	}
+	a %= 65521;
+	b %= 65521;
+	data += block;
+	size -= block;
+  }
+  return b << 16 | a;
+}
+
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t> &out) : m_out(out) {}
+
+  void Put(uint32_t value, int bits) {
+	m_buffer |= uint64_t{value} << m_count;
+	m_count += bits;
+	while (m_count >= 8) {
+	  m_out.push_back(static_cast<uint8_t>(m_buffer));
+	  m_buffer >>= 8;
+	  m_count -= 8;
+	}
+  }
+
+  // Huffman codes go out most significant bit first.
+  void PutCode(uint32_t code, int bits) {
+	uint32_t reversed = 0;
+	for (int i = 0; i < bits; ++i)
+	  reversed |= ((code >> i) & 1u) << (bits - 1 - i);
+	Put(reversed, bits);
+  }
+
+  void Flush() {
+	if (m_count > 0)
+	  m_out.push_back(static_cast<uint8_t>(m_buffer));
+	m_buffer = 0;
+	m_count = 0;
+  }
+
+ private:
+  std::vector<uint8_t> &m_out;
+  uint64_t m_buffer{0};
+  int m_count{0};
+};
+
+void PutLiteral(BitWriter &bits, uint32_t symbol) {
+  if (symbol < 144)
+	bits.PutCode(0x30 + symbol, 8);
+  else if (symbol < 256)
+	bits.PutCode(0x190 + symbol - 144, 9);
+  else if (symbol < 280)
+	bits.PutCode(symbol - 256, 7);
+  else
+	bits.PutCode(0xC0 + symbol - 280, 8);
+}
+
+void PutRun(BitWriter &bits, uint32_t length) {
+  static const uint16_t kBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+								   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static const uint8_t kExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  int code = 28;
+  while (kBase[code] > length)
+	--code;
+  PutLiteral(bits, 257 + code);
+  bits.Put(length - kBase[code], kExtra[code]);
+  bits.PutCode(0, 5); // distance 1
+}
+
+// zlib stream of one fixed-Huffman deflate block. Filtered thumbnail rows are mostly runs of equal
+// bytes, so matches are only looked for one byte back, which keeps the encoder a single pass.
+std::vector<uint8_t> Deflate(const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> out = {0x78, 0x01};
+  out.reserve(data.size() / 4 + 64);
+  BitWriter bits(out);
+  bits.Put(1, 1); // final block
+  bits.Put(1, 2); // fixed Huffman codes
+  for (size_t i = 0; i < data.size();) {
+	size_t run = 0;
+	if (i > 0) {
+	  const size_t limit = std::min<size_t>(258, data.size() - i);
+	  while (run < limit && data[i + run] == data[i - 1])
+		++run;
+	}
+	if (run >= 3) {
+	  PutRun(bits, static_cast<uint32_t>(run));
+	  i += run;
+	} else {
+	  PutLiteral(bits, data[i]);
+	  ++i;
+	}
+  }
+  PutLiteral(bits, 256);
+  bits.Flush();
+  const uint32_t adler = Adler32(data.data(), data.size());
+  for (int shift = 24; shift >= 0; shift -= 8)
+	out.push_back(static_cast<uint8_t>(adler >> shift));
+  return out;
+}
+
+void PutBigEndian(std::vector<uint8_t> &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+	out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void PutChunk(std::vector<uint8_t> &png, const char *type, const std::vector<uint8_t> &data) {
+  PutBigEndian(png, static_cast<uint32_t>(data.size()));
+  const size_t start = png.size();
+  png.insert(png.end(), type, type + 4);
+  png.insert(png.end(), data.begin(), data.end());
+  PutBigEndian(png, Crc32(png.data() + start, png.size() - start));
+}
+
+// Each row gets the filter (none, sub or up) with the smallest sum of absolute differences.
+std::vector<uint8_t> FilterRows(const std::vector<uint8_t> &pixels, int size) {
+  const size_t stride = 2 * static_cast<size_t>(size);
+  std::vector<uint8_t> filtered;
+  filtered.reserve((stride + 1) * size);
+  std::vector<uint8_t> candidates[3];
+  for (int y = 0; y < size; ++y) {
+	const uint8_t *row = pixels.data() + y * stride;
+	const uint8_t *above = y > 0 ? row - stride : nullptr;
+	uint64_t best = std::numeric_limits<uint64_t>::max();
+	int bestFilter = 0;
+	for (int f = 0; f < 3; ++f) {
+	  candidates[f].resize(stride);
+	  uint64_t cost = 0;
+	  for (size_t i = 0; i < stride; ++i) {
+		uint8_t predicted = 0;
+		if (f == 1 && i >= 2)
+		  predicted = row[i - 2];
+		else if (f == 2 && above)
+		  predicted = above[i];
+		const uint8_t value = static_cast<uint8_t>(row[i] - predicted);
+		candidates[f][i] = value;
+		cost += static_cast<int8_t>(value) < 0 ? 256 - value : value;
+	  }
+	  if (cost < best) {
+		best = cost;
+		bestFilter = f;
+	  }
+	}
+	filtered.push_back(static_cast<uint8_t>(bestFilter));
+	filtered.insert(filtered.end(), candidates[bestFilter].begin(), candidates[bestFilter].end());
+  }
+  return filtered;
+}
+}
+
+void RenderThumbnail(const Mesh &mesh, int size, std::vector<uint8_t> &pixels) {
+  pixels.assign(2 * static_cast<size_t>(size) * size, 0);
+  if (size <= 0 || mesh.TriangleCount() == 0)
+	return;
+  Canvas canvas;
+  canvas.size = size * kSupersample;
+  canvas.gray.assign(static_cast<size_t>(canvas.size) * canvas.size, 0);
+  canvas.coverage.assign(canvas.gray.size(), 0);
+
+  // Project every vertex and fit the view into the canvas, Y pointing down.
+  const size_t vertices = mesh.VertexCount();
+  Projected projected;
+  projected.x.resize(vertices);
+  projected.y.resize(vertices);
+  projected.depth.resize(vertices);
+  float lo[2] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+  float hi[2] = {-lo[0], -lo[1]};
+  for (uint32_t v = 0; v < vertices; ++v) {
+	const Vec3 p = mesh.Vertex(v);
+	projected.x[v] = Dot(p, kRight);
+	projected.y[v] = -Dot(p, kUp);
+	projected.depth[v] = Dot(p, kToViewer);
+	lo[0] = std::min(lo[0], projected.x[v]);
+	hi[0] = std::max(hi[0], projected.x[v]);
+	lo[1] = std::min(lo[1], projected.y[v]);
+	hi[1] = std::max(hi[1], projected.y[v]);
+  }
+  const float extent = std::max(hi[0] - lo[0], hi[1] - lo[1]);
+  if (!(extent > 0.0f))
+	return;
+  const float scale = canvas.size * (1.0f - 2.0f * kMargin) / extent;
+  const float offsetX = 0.5f * (canvas.size - scale * (hi[0] - lo[0])) - scale * lo[0];
+  const float offsetY = 0.5f * (canvas.size - scale * (hi[1] - lo[1])) - scale * lo[1];
+  for (uint32_t v = 0; v < vertices; ++v) {
+	projected.x[v] = projected.x[v] * scale + offsetX;
+	projected.y[v] = projected.y[v] * scale + offsetY;
+  }
+
+  // Bin the triangles by the tiles their bounding boxes touch: counts, prefix sums, then fill.
+  const int tiles = (canvas.size + kTileSize - 1) / kTileSize;
+  const size_t triangles = mesh.TriangleCount();
+  std::vector<int32_t> tileBounds(4 * triangles);
+  std::vector<size_t> offsets(static_cast<size_t>(tiles) * tiles + 1, 0);
+  for (size_t t = 0; t < triangles; ++t) {
+	float minX = projected.x[mesh.indices[3 * t]], maxX = minX;
+	float minY = projected.y[mesh.indices[3 * t]], maxY = minY;
+	for (int c = 1; c < 3; ++c) {
+	  const uint32_t v = mesh.indices[3 * t + c];
+	  minX = std::min(minX, projected.x[v]);
+	  maxX = std::max(maxX, projected.x[v]);
+	  minY = std::min(minY, projected.y[v]);
+	  maxY = std::max(maxY, projected.y[v]);
+	}
+	int32_t *bounds = &tileBounds[4 * t];
+	bounds[0] = std::clamp(static_cast<int32_t>(minX) / kTileSize, 0, tiles - 1);
+	bounds[1] = std::clamp(static_cast<int32_t>(maxX) / kTileSize, 0, tiles - 1);
+	bounds[2] = std::clamp(static_cast<int32_t>(minY) / kTileSize, 0, tiles - 1);
+	bounds[3] = std::clamp(static_cast<int32_t>(maxY) / kTileSize, 0, tiles - 1);
+	for (int32_t ty = bounds[2]; ty <= bounds[3]; ++ty)
+	  for (int32_t tx = bounds[0]; tx <= bounds[1]; ++tx)
+		++offsets[ty * tiles + tx + 1];
+  }
+  for (size_t i = 1; i < offsets.size(); ++i)
+	offsets[i] += offsets[i - 1];
+  std::vector<uint32_t> binned(offsets.back());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < triangles; ++t) {
+	const int32_t *bounds = &tileBounds[4 * t];
+	for (int32_t ty = bounds[2]; ty <= bounds[3]; ++ty)
+	  for (int32_t tx = bounds[0]; tx <= bounds[1]; ++tx)
+		binned[fill[ty * tiles + tx]++] = static_cast<uint32_t>(t);
+  }
+
+  // Thumbnails are rendered on the writer threads, which already keep every core busy.
+  for (size_t tile = 0; tile < static_cast<size_t>(tiles) * tiles; ++tile)
+	DrawTile(mesh, projected, binned.data() + offsets[tile], offsets[tile + 1] - offsets[tile],
+			 static_cast<int>(tile % tiles), static_cast<int>(tile / tiles), canvas);
+
+  // Average each block of samples; gray only over the covered ones.
+  for (int y = 0; y < size; ++y) {
+	for (int x = 0; x < size; ++x) {
+	  unsigned covered = 0, gray = 0;
+	  for (int sy = 0; sy < kSupersample; ++sy) {
+		for (int sx = 0; sx < kSupersample; ++sx) {
+		  const size_t at = static_cast<size_t>(y * kSupersample + sy) * canvas.size + x * kSupersample + sx;
+		  covered += canvas.coverage[at];
+		  gray += canvas.gray[at];
+		}
+	  }
+	  uint8_t *out = &pixels[2 * (static_cast<size_t>(y) * size + x)];
+	  out[0] = covered ? static_cast<uint8_t>(gray / covered) : 0;
+	  out[1] = static_cast<uint8_t>(255 * covered / (kSupersample * kSupersample));
+	}
+  }
+}
+
+bool WriteThumbnail(const Mesh &mesh, const std::filesystem::path &path, int size) {
+  std::vector<uint8_t> pixels;
+  RenderThumbnail(mesh, size, pixels);
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  std::vector<uint8_t> header;
+  PutBigEndian(header, static_cast<uint32_t>(size));
+  PutBigEndian(header, static_cast<uint32_t>(size));
+  header.insert(header.end(), {8, 4, 0, 0, 0}); // 8 bit gray and alpha, no interlace
+  PutChunk(png, "IHDR", header);
+  PutChunk(png, "IDAT", Deflate(FilterRows(pixels, size)));
+  PutChunk(png, "IEND", {});
+
+  OutputFile file;
+  if (!file.Open(path, png.size()))
+	return false;
+  file.Write(png.data(), png.size());
+  return file.Close();
+}
@@ -0,0 +1,22 @@
+#ifndef STLHELPER__EXPORTERTHUMBNAIL_H_
+#define STLHELPER__EXPORTERTHUMBNAIL_H_
+#pragma once
+
+#include "ExporterMesh.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+constexpr int kThumbnailSize = 256;
+
+// Renders `mesh` shaded, from the front right and above at an isometric angle (Z up), fitted into
+// a size x size image with a transparent background. The image is drawn at twice the resolution
+// by a tiled rasterizer on the calling thread and averaged down for smooth edges. `pixels`
+// receives size * size gray and alpha byte pairs, top row first.
+void RenderThumbnail(const Mesh &mesh, int size, std::vector<uint8_t> &pixels);
+
+// Renders `mesh` as above and writes it as an 8 bit gray and alpha PNG.
+bool WriteThumbnail(const Mesh &mesh, const std::filesystem::path &path, int size = kThumbnailSize);
+
+#endif //STLHELPER__EXPORTERTHUMBNAIL_H_
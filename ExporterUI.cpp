@@ -3,201 +3,61 @@
 //
 
 #include "ExporterUI.h"
-#include "ExporterPlatform.h"
-
-#include <vector>
-#include <filesystem>
-namespace fs = std::filesystem;
-namespace ac = adsk::core;
-namespace af = adsk::fusion;
+#include "ExporterHistory.h"
+#include "ExporterParameters.h"
+#include "ExporterPipeline.h"
+#include "ExporterWatch.h"
 
 static const char *const kCommandId{"STLExporterCommandId"};
 static const char *const kCommandName{"STL Exporter"};
 static const char *const kCommandDescription{"Export selected bodies to STL files."};
+static const char *const kReexportCommandId{"STLExporterReexportCommandId"};
+static const char *const kReexportCommandName{"Re-export Last Set"};
+static const char *const kReexportCommandDescription{"Export the bodies of the last STL export again with the same settings."};
+static const char *const kRunPresetsCommandId{"STLExporterRunPresetsCommandId"};
+static const char *const kRunPresetsCommandName{"Run All STL Presets"};
+static const char *const kRunPresetsCommandDescription{"Export every saved STL Exporter preset in one pass."};
+static const char *const kWatchCommandId{"STLExporterWatchCommandId"};
+static const char *const kWatchCommandName{"Toggle STL Watch Mode"};
+static const char *const kWatchCommandDescription{"Re-export changed bodies of the last STL export automatically after edits and saves."};
+static const char *const kHistoryCommandId{"STLExporterHistoryCommandId"};
+static const char *const kHistoryCommandName{"STL Export History"};
+static const char *const kHistoryCommandDescription{"Show export throughput over time and flag exports that got slower."};
+static const char *const kCurrentSettingsItem{"Current Settings"};
 
 static const char *const kPanelName{"UtilityPanel"};
 static const char *const kFileDialogTitle{"Select Output Folder"};
-static const char *const kDefaultSeparator{"_"};
-// Input names
-static const char *const kBodiesInput{"SEIBodies"};
-static const char *const kOutputFileSuffixInput{"SEIOutputFileSuffix"};
-static const char *const kOutputFileOverwriteInput{"SEIOutputFileOverwrite"};
-static const char *const kOutputFileSeparatorInput{"SEIOutputFileSeparator"};
-static const char *const kIncludeComponentNameInput{"SEIIncludeComponentName"};
-static const char *const kOutputFolderInput{"SEIOutputFolder"};
-static const char *const kOutputFolderTriggerInput{"SEIOutputFolderTrigger"};
-static const char *const kOutputFilePrefixInput{"SEIOutputFilePrefix"};
-
-// Attribute names
-static const char *const kAttributeGroup{"STLExporterAttributes"};
-static const char *const kAttributeOutputFileSuffix{"SEAOutputFileSuffix"};
-static const char *const kAttributeOutputFilePrefix{"SEAOutputFilePrefix"};
-static const char *const kAttributeOutputFileSeparator{"SEAOutputFileSeparator"};
-static const char *const kAttributeOutputFolder{"SEAOutputFolder"};
-static const char *const kAttributeOverwrite{"SEAOverwrite"};
-static const char *const kAttributeIncludeComponentName{"SEAIncludeComponentName"};
-
-template<typename T>
-ac::Ptr<T> filterOnlyBRepBodies(ac::Ptr<T> selection) {
-  return selection && selection->objectType() == af::BRepBody::classType() ? selection : nullptr;
-}
-
-class ExporterParameters {
-
- public:
-  fs::path outputFolder{getDownloadsFolder()};
-  std::string outputFileSuffix;
-  std::string outputFilePrefix;
-  std::string outputFileSeparator{kDefaultSeparator};
-  std::vector<ac::Ptr<af::BRepBody>> bodies;
-  bool overwriteExistingFiles{true};
-  bool includeComponentName{true};
-
-  bool Validate() const {
-	if (outputFolder.empty() || bodies.empty()) {
-	  return false;
-	}
-	// check folder
-	if (!fs::exists(outputFolder)) { // && !fs::is_directory(outputFolder.parent_path())) {
-	  fs::path parent = outputFolder;
-	  // allow us to create a folder if it doesn't exist
-	  while (!fs::exists(parent) && !parent.empty()) { parent = parent.parent_path(); }
-	  if (parent.empty()) {
-		return false;
-	  }
-	}
-	return true;
-  }
 
-  void Clear() {
-	outputFolder = getDownloadsFolder();
-	outputFileSuffix.clear();
-	outputFilePrefix.clear();
-	outputFileSeparator = "_";
-	bodies.clear();
-	overwriteExistingFiles = true;
-	includeComponentName = true;
+// Shows the rule inputs only in rule mode, where an empty selection is allowed.
+static void UpdateRuleInputs(const ac::Ptr<ac::CommandInputs> &inputs) {
+  ac::Ptr<ac::BoolValueCommandInput> useRulesInput = inputs->itemById(kUseRulesInput);
+  const bool useRules = useRulesInput && useRulesInput->value();
+  ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
+  if (bodiesInput) {
+	bodiesInput->setSelectionLimits(useRules ? 0 : 1, 0);
+	bodiesInput->isVisible(!useRules);
   }
-
-  bool SaveToInputs(ac::Ptr<ac::CommandInputs> inputs) {
-	if (!inputs)
-	  return false;
-	ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFileSuffixInput = inputs->itemById(kOutputFileSuffixInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFilePrefixInput = inputs->itemById(kOutputFilePrefixInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFileSeparatorInput = inputs->itemById(kOutputFileSeparatorInput);
-	ac::Ptr<ac::TextBoxCommandInput> outputFolderInput = inputs->itemById(kOutputFolderInput);
-	ac::Ptr<ac::BoolValueCommandInput> outputOverwriteInput = inputs->itemById(kOutputFileOverwriteInput);
-	ac::Ptr<ac::BoolValueCommandInput> includeComponentNameInput = inputs->itemById(kIncludeComponentNameInput);
-
-	if (bodiesInput) {
-	  bodiesInput->addSelectionFilter(ac::SelectionFilters::SolidBodies);
-	  bodiesInput->clearSelection();
-	  for (auto &&b : bodies) {
-		bodiesInput->addSelection(b);
-	  }
-	}
-	if (outputFileSuffixInput) {
-	  outputFileSuffixInput->value(outputFileSuffix);
-	}
-	if (outputFilePrefixInput) {
-	  outputFilePrefixInput->value(outputFilePrefix);
-	}
-	if (outputFileSeparatorInput) {
-	  outputFileSeparatorInput->value(outputFileSeparator);
-	}
-	if (outputFolderInput) {
-	  outputFolderInput->text(outputFolder.string());
-	}
-	if (outputOverwriteInput) {
-	  outputOverwriteInput->value(overwriteExistingFiles);
-	}
-	if (includeComponentNameInput) {
-	  includeComponentNameInput->value(includeComponentName);
-	}
-	return true;
-  }
-
-  bool LoadFromInputs(ac::Ptr<ac::CommandInputs> inputs) {
-	ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFileSuffixInput = inputs->itemById(kOutputFileSuffixInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFilePrefixInput = inputs->itemById(kOutputFilePrefixInput);
-	ac::Ptr<ac::StringValueCommandInput> outputFileSeparatorInput = inputs->itemById(kOutputFileSeparatorInput);
-	ac::Ptr<ac::TextBoxCommandInput> outputFolderInput = inputs->itemById(kOutputFolderInput);
-	ac::Ptr<ac::BoolValueCommandInput> outputOverwriteInput = inputs->itemById(kOutputFileOverwriteInput);
-	ac::Ptr<ac::BoolValueCommandInput> includeComponentNameInput = inputs->itemById(kIncludeComponentNameInput);
-
-	if (!bodiesInput || !bodiesInput->isValid() || !outputFolderInput || !outputFolderInput->isValid()) {
-	  return false;
-	}
-
-	outputFolder = outputFolderInput->text();
-	outputFileSuffix = outputFileSuffixInput ? outputFileSuffixInput->value() : outputFileSuffix;
-	outputFilePrefix = outputFilePrefixInput ? outputFilePrefixInput->value() : outputFilePrefix;
-	overwriteExistingFiles = outputOverwriteInput ? outputOverwriteInput->value() : overwriteExistingFiles;
-	includeComponentName = includeComponentNameInput ? includeComponentNameInput->value() : includeComponentName;
-	outputFileSeparator = outputFileSeparatorInput ? outputFileSeparatorInput->value() : outputFileSeparator;
-
-	bodies.clear();
-	bodies.reserve(bodiesInput->selectionCount());
-	for (int i = 0; i < bodiesInput->selectionCount(); ++i) {
-	  ac::Ptr<af::BRepBody> body = filterOnlyBRepBodies(bodiesInput->selection(i));
-	  if (body) {
-		bodies.emplace_back(std::move(body));
-	  }
-	}
-	return true;
-  }
-
-  bool SaveToAttributes(ac::Ptr<ac::Attributes> attributes) {
-	if (!attributes)
-	  return false;
-	attributes->add(kAttributeGroup, kAttributeOutputFolder, outputFolder.string());
-	attributes->add(kAttributeGroup, kAttributeOutputFileSuffix, outputFileSuffix);
-	attributes->add(kAttributeGroup, kAttributeOutputFilePrefix, outputFilePrefix);
-	attributes->add(kAttributeGroup, kAttributeOutputFileSeparator, outputFileSeparator);
-	attributes->add(kAttributeGroup, kAttributeOverwrite, overwriteExistingFiles ? "true" : "false");
-	attributes->add(kAttributeGroup, kAttributeIncludeComponentName, includeComponentName ? "true" : "false");
-	return true;
-  }
-
-  bool LoadFromAttributes(ac::Ptr<ac::Attributes> attributes) {
-	if (!attributes)
-	  return false;
-
-	auto outputFileSuffixAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFileSuffix);
-	if (outputFileSuffixAttribute)
-	  outputFileSuffix = outputFileSuffixAttribute->value();
-
-	auto outputFilePrefixAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFilePrefix);
-	if (outputFilePrefixAttribute)
-	  outputFilePrefix = outputFilePrefixAttribute->value();
-
-	auto outputFileSeparatorAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFileSeparator);
-	if (outputFileSeparatorAttribute)
-	  outputFileSeparator = outputFileSeparatorAttribute->value();
-
-	auto outputFolderAttribute = attributes->itemByName(kAttributeGroup, kAttributeOutputFolder);
-	if (outputFolderAttribute)
-	  outputFolder = outputFolderAttribute->value();
-
-	auto outputOverwriteAttribute = attributes->itemByName(kAttributeGroup, kAttributeOverwrite);
-	if (outputOverwriteAttribute)
-	  overwriteExistingFiles = outputOverwriteAttribute->value() == "true";
-
-	auto includeComponentNameAttribute = attributes->itemByName(kAttributeGroup, kAttributeIncludeComponentName);
-	if (includeComponentNameAttribute)
-	  includeComponentName = includeComponentNameAttribute->value() == "true";
-
-	return true;
+  for (const char *id : {kIncludeComponentsInput, kExcludeComponentsInput, kIncludeBodiesInput, kExcludeBodiesInput,
+						 kMaterialRuleInput, kSubtreeRuleInput, kVisibleOnlyInput}) {
+	auto input = inputs->itemById(id);
+	if (input)
+	  input->isVisible(useRules);
   }
-};
+}
 
 bool BuildElements(ac::Ptr<ac::CommandInputs> inputs) {
   auto params = ExporterParameters();
   if (!inputs)
 	return false;
 
+  // Presets, filled in on activate
+  auto preset = inputs->addDropDownCommandInput(kPresetInput, "Preset", ac::TextListDropDownStyle);
+  if (!preset || !preset->listItems())
+	return false;
+  preset->listItems()->add(kCurrentSettingsItem, true);
+  preset->tooltip("Preset");
+  preset->tooltipDescription("Load the settings and bodies of a saved preset");
+
   // Selection
   ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->addSelectionInput(kBodiesInput, "Select Bodies", "Select bodies to export");
   if (!bodiesInput)
@@ -208,6 +68,41 @@ bool BuildElements(ac::Ptr<ac::CommandInputs> inputs) {
   bodiesInput->tooltip("Select bodies to export to STL files");
   bodiesInput->tooltipDescription("Select bodies to export to STL files");
 
+  // Rule-based selection
+  auto useRules = inputs->addBoolValueInput(kUseRulesInput, "Select By Rules", true, "", false);
+  if (!useRules)
+	return false;
+  useRules->tooltip("Select By Rules");
+  useRules->tooltipDescription("Ignore the selection and export every body of the design that matches the rules below. "
+							   "Rules are regular expressions that match any part of a name; empty rules match everything.");
+
+  struct RuleInput {
+	const char *id;
+	const char *name;
+	const char *description;
+  };
+  const RuleInput ruleInputs[] = {
+	  {kIncludeComponentsInput, "Include Components", "Only bodies of components whose name matches"},
+	  {kExcludeComponentsInput, "Exclude Components", "Skip bodies of components whose name matches"},
+	  {kIncludeBodiesInput, "Include Bodies", "Only bodies whose name matches"},
+	  {kExcludeBodiesInput, "Exclude Bodies", "Skip bodies whose name matches"},
+	  {kMaterialRuleInput, "Material", "Only bodies whose material name matches"},
+	  {kSubtreeRuleInput, "Component Subtree", "Only bodies below a component whose name matches"},
+  };
+  for (auto &&rule : ruleInputs) {
+	auto ruleInput = inputs->addStringValueInput(rule.id, rule.name, "");
+	if (!ruleInput)
+	  return false;
+	ruleInput->tooltip(rule.name);
+	ruleInput->tooltipDescription(rule.description);
+  }
+
+  auto visibleOnly = inputs->addBoolValueInput(kVisibleOnlyInput, "Visible Bodies Only", true, "", true);
+  if (!visibleOnly)
+	return false;
+  visibleOnly->tooltip("Visible Bodies Only");
+  visibleOnly->tooltipDescription("Skip hidden bodies and bodies of hidden occurrences");
+
   // Directory
   ac::Ptr<ac::BoolValueCommandInput> directoryButton = inputs->addBoolValueInput(kOutputFolderTriggerInput, "Output Folder", false, "", true);
   if (!directoryButton)
@@ -251,11 +146,254 @@ bool BuildElements(ac::Ptr<ac::CommandInputs> inputs) {
   includeComponentName->tooltip("Include Component Name");
   includeComponentName->tooltipDescription("Include Component Name");
 
+  // Refinement
+  auto refinement = inputs->addDropDownCommandInput(kRefinementInput, "Refinement", ac::TextListDropDownStyle);
+  if (!refinement || !refinement->listItems())
+	return false;
+  for (auto &&q : kMeshQualities)
+	refinement->listItems()->add(q.name, q.quality == params.meshQuality);
+  refinement->tooltip("Refinement");
+  refinement->tooltipDescription("How finely bodies are tessellated");
+
+  // Printability checks
+  auto minimumWallThickness = inputs->addValueInput(kMinimumWallThicknessInput, "Minimum Wall Thickness", "mm", ac::ValueInput::createByReal(0.0));
+  if (!minimumWallThickness)
+	return false;
+  minimumWallThickness->tooltip("Minimum Wall Thickness");
+  minimumWallThickness->tooltipDescription("Flag bodies with walls thinner than this value. Zero disables the check.");
+
+  auto checkSelfIntersections = inputs->addBoolValueInput(kCheckSelfIntersectionsInput, "Check Self Intersections", true, "", false);
+  if (!checkSelfIntersections)
+	return false;
+  checkSelfIntersections->tooltip("Check Self Intersections");
+  checkSelfIntersections->tooltipDescription("Flag bodies whose tessellation intersects itself");
+
+  // Orientation
+  auto optimizeOrientation = inputs->addBoolValueInput(kOptimizeOrientationInput, "Optimize Print Orientation", true, "", false);
+  if (!optimizeOrientation)
+	return false;
+  optimizeOrientation->tooltip("Optimize Print Orientation");
+  optimizeOrientation->tooltipDescription("Rotate each body to minimize overhangs and build height before writing it");
+
+  // Merging
+  auto mergeBodies = inputs->addBoolValueInput(kMergeBodiesInput, "Merge Bodies", true, "", false);
+  if (!mergeBodies)
+	return false;
+  mergeBodies->tooltip("Merge Bodies");
+  mergeBodies->tooltipDescription("Union bodies that touch or overlap into one solid and write all bodies as a single file. "
+								  "With build plates, each merged solid is placed as one part.");
+
+  // Build plates
+  auto arrangeOnPlates = inputs->addBoolValueInput(kArrangeOnPlatesInput, "Arrange On Build Plates", true, "", false);
+  if (!arrangeOnPlates)
+	return false;
+  arrangeOnPlates->tooltip("Arrange On Build Plates");
+  arrangeOnPlates->tooltipDescription("Lay the bodies out on build plates and write one file per plate");
+
+  auto plateWidth = inputs->addValueInput(kPlateWidthInput, "Plate Width", "mm", ac::ValueInput::createByReal(params.plateWidth));
+  if (!plateWidth)
+	return false;
+  plateWidth->tooltip("Plate Width");
+  plateWidth->tooltipDescription("Usable width (X) of the build plate");
+
+  auto plateDepth = inputs->addValueInput(kPlateDepthInput, "Plate Depth", "mm", ac::ValueInput::createByReal(params.plateDepth));
+  if (!plateDepth)
+	return false;
+  plateDepth->tooltip("Plate Depth");
+  plateDepth->tooltipDescription("Usable depth (Y) of the build plate");
+
+  auto plateSpacing = inputs->addValueInput(kPlateSpacingInput, "Part Spacing", "mm", ac::ValueInput::createByReal(params.plateSpacing));
+  if (!plateSpacing)
+	return false;
+  plateSpacing->tooltip("Part Spacing");
+  plateSpacing->tooltipDescription("Minimum gap between parts and to the plate edge");
+
+  // Splitting
+  auto splitOversized = inputs->addBoolValueInput(kSplitOversizedInput, "Split To Build Volume", true, "", false);
+  if (!splitOversized)
+	return false;
+  splitOversized->tooltip("Split To Build Volume");
+  splitOversized->tooltipDescription("Cut bodies larger than the plate width, plate depth and build height into closed pieces "
+									 "that fit, written as <body>" + params.outputFileSeparator + "Part" + params.outputFileSeparator + "1 and so on");
+
+  auto buildHeight = inputs->addValueInput(kBuildHeightInput, "Build Height", "mm", ac::ValueInput::createByReal(params.buildHeight));
+  if (!buildHeight)
+	return false;
+  buildHeight->tooltip("Build Height");
+  buildHeight->tooltipDescription("Usable height (Z) of the build volume");
+
+  auto dowelDiameter = inputs->addValueInput(kDowelDiameterInput, "Dowel Hole Diameter", "mm", ac::ValueInput::createByReal(params.dowelDiameter));
+  if (!dowelDiameter)
+	return false;
+  dowelDiameter->tooltip("Dowel Hole Diameter");
+  dowelDiameter->tooltipDescription("Sink matching holes for alignment pins into both faces of each cut, 1.5 diameters deep on "
+									"either side, where the material leaves a wall around them. Zero for no holes.");
+
+  // Triangle order
+  auto sortTriangles = inputs->addBoolValueInput(kSortTrianglesInput, "Spatially Ordered Triangles", true, "", false);
+  if (!sortTriangles)
+	return false;
+  sortTriangles->tooltip("Spatially Ordered Triangles");
+  sortTriangles->tooltipDescription("Write neighbouring facets next to each other. Files compress better and load faster, and identical geometry always gives identical files.");
+
+  // Additional targets
+  auto additionalTargets = inputs->addTextBoxCommandInput(kAdditionalTargetsInput, "Additional Targets", "", 3, false);
+  if (!additionalTargets)
+	return false;
+  additionalTargets->tooltip("Additional Targets");
+  additionalTargets->tooltipDescription("Extra copies written from the same tessellation, one per line:\n"
+										"folder | format (stl, ascii, ascii:digits, compact, compact:bits, svg, svg:microns, contours or contours:microns) | units (mm, cm, m, in) | decimation (0-8) | name template\n"
+										"svg and contours write the layer outlines of the part, 50 microns apart unless given. "
+										"Relative folders are inside the output folder. Templates may use "
+										"{prefix}, {component}, {body}, {suffix} and {sep}.");
+
+  // ASCII output
+  auto ascii = inputs->addBoolValueInput(kAsciiInput, "ASCII STL", true, "", false);
+  if (!ascii)
+	return false;
+  ascii->tooltip("ASCII STL");
+  ascii->tooltipDescription("Write text STL files for tools that cannot read binary STL. The files are several times larger.");
+
+  auto asciiDigits = inputs->addIntegerSpinnerCommandInput(kAsciiDigitsInput, "ASCII Digits", 0, kMaxAsciiDigits, 1, 0);
+  if (!asciiDigits)
+	return false;
+  asciiDigits->tooltip("ASCII Digits");
+  asciiDigits->tooltipDescription("Significant digits per number in ASCII files. 0 writes every coordinate exactly; "
+								  "fewer digits give smaller files.");
+
+  // Thumbnails
+  auto thumbnails = inputs->addBoolValueInput(kThumbnailsInput, "Thumbnails", true, "", false);
+  if (!thumbnails)
+	return false;
+  thumbnails->tooltip("Thumbnails");
+  thumbnails->tooltipDescription("Also write a shaded isometric PNG preview of each body next to its STL file, "
+								 "rendered from the exported mesh.");
+
+  // Content store
+  auto storeFolder = inputs->addStringValueInput(kStoreFolderInput, "Content Store Folder", "");
+  if (!storeFolder)
+	return false;
+  storeFolder->tooltip("Content Store Folder");
+  storeFolder->tooltipDescription("When set, each distinct file is written once into this folder and the named files are hard links "
+								  "to it (copies on drives that cannot link). Relative folders are inside the output folder. "
+								  "Edit exported files only after copying them, as an edit changes every linked file.");
+
+  // Verification
+  auto verifyFiles = inputs->addBoolValueInput(kVerifyFilesInput, "Verify Written Files", true, "", false);
+  if (!verifyFiles)
+	return false;
+  verifyFiles->tooltip("Verify Written Files");
+  verifyFiles->tooltipDescription("Read every file back after writing it and compare triangle count, bounding box and checksum. "
+								  "A file that does not match is reported and the previous file is kept.");
+
+  // Changes since the previous export
+  auto compareWithPrevious = inputs->addBoolValueInput(kCompareWithPreviousInput, "Compare With Previous Export", true, "", false);
+  if (!compareWithPrevious)
+	return false;
+  compareWithPrevious->tooltip("Compare With Previous Export");
+  compareWithPrevious->tooltipDescription("Measure how far each body moved from the STL file it replaces (Hausdorff distance) "
+										  "and write the results to changes.csv in the output folder.");
+
+  auto changeTolerance = inputs->addValueInput(kChangeToleranceInput, "Change Tolerance", "mm", ac::ValueInput::createByReal(params.changeTolerance));
+  if (!changeTolerance)
+	return false;
+  changeTolerance->tooltip("Change Tolerance");
+  changeTolerance->tooltipDescription("Bodies whose surfaces are nowhere farther apart than this count as unchanged");
+
+  auto skipUnchanged = inputs->addBoolValueInput(kSkipUnchangedInput, "Skip Unchanged Bodies", true, "", false);
+  if (!skipUnchanged)
+	return false;
+  skipUnchanged->tooltip("Skip Unchanged Bodies");
+  skipUnchanged->tooltipDescription("Keep the previous files of unchanged bodies and write only the bodies that changed");
+
+  // Save as preset
+  auto savePreset = inputs->addStringValueInput(kSavePresetInput, "Save As Preset", "");
+  if (!savePreset)
+	return false;
+  savePreset->tooltip("Save As Preset");
+  savePreset->tooltipDescription("When a name is given, these settings and bodies are also saved as a preset of that name on export");
+
+  UpdateRuleInputs(inputs);
   return true;
 }
+// Fusion validates after every keystroke and selection change. Resolving every selected body and
+// probing the file system each time makes the dialog lag with large selections, so the last result
+// is kept and only the parts whose inputs changed are reloaded.
+class ValidationCache {
+ public:
+  void Invalidate() {
+	m_bodiesDirty = true;
+	m_settingsDirty = true;
+	m_checkedFolder.clear();
+  }
+
+  void InputChanged(const std::string &id) {
+	if (id == kBodiesInput)
+	  m_bodiesDirty = true;
+	else
+	  m_settingsDirty = true;
+  }
+
+  bool Validate(const ac::Ptr<ac::CommandInputs> &inputs) {
+	if (m_bodiesDirty) {
+	  m_bodiesLoaded = LoadBodies(inputs);
+	  m_bodiesDirty = false;
+	}
+	if (m_settingsDirty) {
+	  m_settingsValid = m_params.LoadSettingsFromInputs(inputs) && m_params.ValidateSettings();
+	  m_settingsDirty = false;
+	  if (m_params.outputFolder != m_checkedFolder) {
+		m_checkedFolder = m_params.outputFolder;
+		m_folderUsable = ExporterParameters::IsFolderUsable(m_checkedFolder);
+	  }
+	}
+	// In rule mode the bodies are only collected on execute.
+	const bool bodiesValid = m_bodiesLoaded && (m_params.useRules || !m_params.bodies.empty());
+	return bodiesValid && m_settingsValid && m_folderUsable;
+  }
+
+ private:
+  // Selections are added one at a time at the end of the list. If the previously last selection is
+  // still in place only the new ones are resolved; anything else reloads the whole list.
+  bool LoadBodies(const ac::Ptr<ac::CommandInputs> &inputs) {
+	ac::Ptr<ac::SelectionCommandInput> bodiesInput = inputs->itemById(kBodiesInput);
+	if (!bodiesInput || !bodiesInput->isValid())
+	  return false;
+	const int count = bodiesInput->selectionCount();
+	if (count > m_selectionCount && !m_lastToken.empty() && LastToken(bodiesInput, m_selectionCount) == m_lastToken) {
+	  m_params.AppendBodies(bodiesInput, m_selectionCount);
+	} else if (!m_params.LoadBodiesFromInputs(inputs)) {
+	  return false;
+	}
+	m_selectionCount = count;
+	m_lastToken = LastToken(bodiesInput, count);
+	return true;
+  }
+
+  static std::string LastToken(const ac::Ptr<ac::SelectionCommandInput> &bodiesInput, int count) {
+	if (count <= 0)
+	  return {};
+	auto selection = bodiesInput->selection(count - 1);
+	ac::Ptr<af::BRepBody> body = selection ? filterOnlyBRepBodies(selection->entity()) : nullptr;
+	return body ? body->entityToken() : std::string();
+  }
+
+  ExporterParameters m_params;
+  int m_selectionCount{0};
+  std::string m_lastToken;
+  fs::path m_checkedFolder;
+  bool m_bodiesDirty{true};
+  bool m_settingsDirty{true};
+  bool m_bodiesLoaded{false};
+  bool m_settingsValid{false};
+  bool m_folderUsable{false};
+};
+
 // Validate Inputs
 class OnValidateEventHandler : public ac::ValidateInputsEventHandler {
  public:
+  explicit OnValidateEventHandler(ValidationCache &cache) : m_cache(cache) {}
+
   void notify(const ac::Ptr<ac::ValidateInputsEventArgs> &eventArgs) override {
 	auto inputs = eventArgs->inputs();
 	if (!inputs)
@@ -265,17 +403,16 @@ class OnValidateEventHandler : public ac::ValidateInputsEventHandler {
 	if (!firingEvent)
 	  return;
 
-	ExporterParameters params;
-	if (!params.LoadFromInputs(inputs)) {
-	  eventArgs->areInputsValid(false);
-	  return;
-	}
-	eventArgs->areInputsValid(params.Validate());
+	eventArgs->areInputsValid(m_cache.Validate(inputs));
   }
+ private:
+  ValidationCache &m_cache;
 };
 
 class OnActivateEventHandler : public ac::CommandEventHandler {
  public:
+  explicit OnActivateEventHandler(ValidationCache &cache) : m_cache(cache) {}
+
   void notify(const ac::Ptr<ac::CommandEventArgs> &eventArgs) override {
 	auto app = ac::Application::get();
 	if (!app)
@@ -299,9 +436,26 @@ class OnActivateEventHandler : public ac::CommandEventHandler {
 	  return;
 	auto inputs = cmd->commandInputs();
 	ExporterParameters params;
-	params.LoadFromAttributes(design->attributes());
+	if (!params.LoadFromAttributes(design->attributes()) && params.newerSettings) {
+	  ui->messageBox("The export settings in this design were saved by a newer version of the STL Exporter and "
+					 "cannot be read. Exporting from this dialog replaces them.",
+					 kCommandName,
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::WarningIconType);
+	}
+	params.ResolveBodies(design);
 	params.SaveToInputs(inputs);
+	UpdateRuleInputs(inputs);
+	m_cache.Invalidate();
+
+	ac::Ptr<ac::DropDownCommandInput> presetInput = inputs->itemById(kPresetInput);
+	if (presetInput && presetInput->listItems()) {
+	  for (auto &&preset : ExporterParameters::LoadPresets(design->attributes()))
+		presetInput->listItems()->add(preset.presetName, false);
+	}
   }
+ private:
+  ValidationCache &m_cache;
 };
 class OnExecuteEventHandler : public ac::CommandEventHandler {
  public:
@@ -329,82 +483,35 @@ class OnExecuteEventHandler : public ac::CommandEventHandler {
 	if (!design)
 	  return;
 
-	if (!params.Validate()) {
-	  ui->messageBox("Invalid Inputs",
+	params.ApplyRules(design);
+	if (params.useRules && params.bodies.empty()) {
+	  ui->messageBox("No bodies match the selection rules",
 					 "Error",
 					 ac::MessageBoxButtonTypes::OKButtonType,
 					 ac::MessageBoxIconTypes::CriticalIconType);
 	  return;
 	}
-
-	if (!fs::exists(params.outputFolder) && !fs::create_directories(params.outputFolder)) {
-	  ui->messageBox("Invalid Output folder: " + params.outputFolder.string(),
+	if (!params.Validate()) {
+	  ui->messageBox("Invalid Inputs",
 					 "Error",
 					 ac::MessageBoxButtonTypes::OKButtonType,
 					 ac::MessageBoxIconTypes::CriticalIconType);
 	  return;
 	}
 
-	std::string fileName;
-	fileName.reserve(256);
-	for (auto &&body : params.bodies) {
-	  fs::path filePath = params.outputFolder;
-	  fileName.clear();
-	  if (!params.outputFilePrefix.empty()) {
-		fileName += params.outputFilePrefix;
-		fileName += params.outputFileSeparator;
-	  }
-
-	  if (params.includeComponentName) {
-		auto c = body->parentComponent();
-		if (c) {
-		  fileName += c->name();
-		  fileName += params.outputFileSeparator;
-		}
-	  }
-
-	  fileName += body->name();
-
-	  if (!params.outputFileSuffix.empty()) {
-		fileName += params.outputFileSeparator;
-		fileName += params.outputFileSuffix;
-	  }
-	  fileName += ".stl";
-	  filePath /= fileName;
-	  if (fs::exists(filePath) && !params.overwriteExistingFiles) {
-		ui->messageBox("File already exists: " + filePath.string(),
-					   "Error",
-					   ac::MessageBoxButtonTypes::OKButtonType,
-					   ac::MessageBoxIconTypes::CriticalIconType);
-		continue;
-	  }
-
-	  auto exportManager = design->exportManager();
-
-	  if (!exportManager) {
-		ui->messageBox("Export Manager not available",
-					   "Error",
-					   ac::MessageBoxButtonTypes::OKButtonType,
-					   ac::MessageBoxIconTypes::CriticalIconType);
-		return;
-	  }
-	  auto stlExportOptions = exportManager->createSTLExportOptions(body, filePath.string());
-	  stlExportOptions->sendToPrintUtility(false);
-	  stlExportOptions->meshRefinement(af::MeshRefinementHigh);
-	  if (!exportManager->execute(stlExportOptions)) {
-		ui->messageBox("Failed to export: " + filePath.string(),
-					   "Error",
-					   ac::MessageBoxButtonTypes::OKButtonType,
-					   ac::MessageBoxIconTypes::CriticalIconType);
-		continue;
-	  }
-	}
+	RunExport(params, design, ui);
 	params.SaveToAttributes(design->attributes());
+
+	ac::Ptr<ac::StringValueCommandInput> savePresetInput = inputs->itemById(kSavePresetInput);
+	if (savePresetInput && !savePresetInput->value().empty())
+	  params.SaveAsPreset(design->attributes(), savePresetInput->value());
   }
 };
 
 class OnInputChangedEventHandler : public ac::InputChangedEventHandler {
  public:
+  explicit OnInputChangedEventHandler(ValidationCache &cache) : m_cache(cache) {}
+
   void notify(const ac::Ptr<ac::InputChangedEventArgs> &eventArgs) override {
 	auto inputs = eventArgs->inputs();
 	if (!inputs)
@@ -412,6 +519,13 @@ class OnInputChangedEventHandler : public ac::InputChangedEventHandler {
 	auto input = eventArgs->input();
 	if (!input)
 	  return;
+	m_cache.InputChanged(input->id());
+	if (input->id() == kUseRulesInput)
+	  UpdateRuleInputs(inputs);
+	if (input->id() == kPresetInput) {
+	  LoadPreset(inputs);
+	  return;
+	}
 	auto app = ac::Application::get();
 	if (!app)
 	  return;
@@ -428,9 +542,43 @@ class OnInputChangedEventHandler : public ac::InputChangedEventHandler {
 	  ac::DialogResults result = dialog->showDialog();
 	  if (result == ac::DialogResults::DialogOK) {
 		folder->text(dialog->folder());
+		m_cache.InputChanged(kOutputFolderInput);
 	  }
 	}
   }
+
+ private:
+  void LoadPreset(const ac::Ptr<ac::CommandInputs> &inputs) {
+	ac::Ptr<ac::DropDownCommandInput> presetInput = inputs->itemById(kPresetInput);
+	auto app = ac::Application::get();
+	if (!presetInput || !presetInput->selectedItem() || !app)
+	  return;
+	ac::Ptr<af::Design> design = app->activeProduct();
+	if (!design)
+	  return;
+	const std::string name = presetInput->selectedItem()->name();
+	ExporterParameters params;
+	bool found = false;
+	if (name == kCurrentSettingsItem) {
+	  found = params.LoadFromAttributes(design->attributes());
+	} else {
+	  for (auto &&preset : ExporterParameters::LoadPresets(design->attributes())) {
+		if (preset.presetName == name) {
+		  params = std::move(preset);
+		  found = true;
+		  break;
+		}
+	  }
+	}
+	if (!found)
+	  return;
+	params.ResolveBodies(design);
+	params.SaveToInputs(inputs);
+	UpdateRuleInputs(inputs);
+	m_cache.Invalidate();
+  }
+
+  ValidationCache &m_cache;
 };
 
 class OnCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
@@ -442,6 +590,8 @@ class OnCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
 	if (!command)
 	  return;
 
+	m_validationCache.Invalidate();
+
 	auto onexec = command->execute();
 	if (!onexec || !onexec->add(&m_executeHandler))
 	  return;
@@ -461,46 +611,241 @@ class OnCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
 	BuildElements(command->commandInputs());
   }
  private:
+  ValidationCache m_validationCache;
   OnExecuteEventHandler m_executeHandler;
-  OnValidateEventHandler m_validateHandler;
-  OnInputChangedEventHandler m_inputChangedHandler;
-  OnActivateEventHandler m_activateHandler;
+  OnValidateEventHandler m_validateHandler{m_validationCache};
+  OnInputChangedEventHandler m_inputChangedHandler{m_validationCache};
+  OnActivateEventHandler m_activateHandler{m_validationCache};
 } commandCreatedHandler;
 
-bool CreatePanel(adsk::core::Ptr<adsk::core::UserInterface> ui) {
-  auto ws = ui->workspaces();
-  if (!ws)
-	return false;
+// Re-export: no inputs, so Fusion fires execute straight away without showing a dialog.
+class OnReexportExecuteEventHandler : public ac::CommandEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandEventArgs> &eventArgs) override {
+	auto app = ac::Application::get();
+	if (!app)
+	  return;
+	auto ui = app->userInterface();
+	if (!ui)
+	  return;
+	ac::Ptr<af::Design> design = app->activeProduct();
+	if (!design) {
+	  ui->messageBox("No active design",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
 
-  auto env = ws->itemById("FusionSolidEnvironment");
-  if (!env)
-	return false;
+	ExporterParameters params;
+	if (!params.LoadFromAttributes(design->attributes()) && params.newerSettings) {
+	  ui->messageBox("The export settings in this design were saved by a newer version of the STL Exporter.",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
+	const size_t dropped = params.useRules ? 0 : params.ResolveBodies(design);
+	params.ApplyRules(design);
+	if (!params.Validate()) {
+	  ui->messageBox("Nothing to re-export. Run the STL Exporter once to choose bodies and an output folder.",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
+	if (dropped > 0) {
+	  ui->messageBox(std::to_string(dropped) + " previously exported bodies no longer exist and were skipped.",
+					 "Re-export",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::WarningIconType);
+	}
+	RunExport(params, design, ui);
+	params.SaveToAttributes(design->attributes());
+  }
+};
 
-  if (!env->toolbarPanels())
-	return false;
+class OnReexportCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandCreatedEventArgs> &eventArgs) override {
+	if (!eventArgs)
+	  return;
+	auto command = eventArgs->command();
+	if (!command)
+	  return;
+	auto onexec = command->execute();
+	if (!onexec)
+	  return;
+	onexec->add(&m_executeHandler);
+  }
+ private:
+  OnReexportExecuteEventHandler m_executeHandler;
+} reexportCommandCreatedHandler;
 
+class OnRunPresetsExecuteEventHandler : public ac::CommandEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandEventArgs> &eventArgs) override {
+	auto app = ac::Application::get();
+	if (!app)
+	  return;
+	auto ui = app->userInterface();
+	if (!ui)
+	  return;
+	ac::Ptr<af::Design> design = app->activeProduct();
+	if (!design) {
+	  ui->messageBox("No active design",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
 
-  auto panel = env->toolbarPanels()->itemById(kPanelName);
-  if (!panel || !panel->controls())
-	return false;
+	std::vector<ExporterParameters> runs;
+	std::string skipped;
+	for (auto &&preset : ExporterParameters::LoadPresets(design->attributes())) {
+	  if (!preset.useRules)
+		preset.ResolveBodies(design);
+	  preset.ApplyRules(design);
+	  if (preset.Validate())
+		runs.push_back(std::move(preset));
+	  else
+		skipped += preset.presetName + "\n";
+	}
+	if (!skipped.empty()) {
+	  ui->messageBox("These presets have no bodies left to export or an unusable output folder and were skipped:\n\n" + skipped,
+					 "Run All Presets",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::WarningIconType);
+	}
+	if (runs.empty()) {
+	  ui->messageBox("No presets to run. Save one from the STL Exporter dialog first.",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
+	RunExports(runs, design, ui);
+  }
+};
 
-  if (panel->controls()->itemById(kCommandId)) {
-	ui->messageBox("Panel already exists",
-				   "Warning",
-				   ac::MessageBoxButtonTypes::OKButtonType,
-				   ac::MessageBoxIconTypes::CriticalIconType);
-	adsk::terminate();
-	return true;
+class OnRunPresetsCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandCreatedEventArgs> &eventArgs) override {
+	if (!eventArgs)
+	  return;
+	auto command = eventArgs->command();
+	if (!command)
+	  return;
+	auto onexec = command->execute();
+	if (!onexec)
+	  return;
+	onexec->add(&m_executeHandler);
+  }
+ private:
+  OnRunPresetsExecuteEventHandler m_executeHandler;
+} runPresetsCommandCreatedHandler;
+
+class OnWatchExecuteEventHandler : public ac::CommandEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandEventArgs> &eventArgs) override {
+	auto app = ac::Application::get();
+	if (!app)
+	  return;
+	auto ui = app->userInterface();
+	if (!ui)
+	  return;
+	if (IsWatching()) {
+	  StopWatching();
+	  ui->messageBox("Watch mode is off.", "STL Watch Mode");
+	  return;
+	}
+	if (!StartWatching(app)) {
+	  ui->messageBox("Failed to start watch mode",
+					 "Error",
+					 ac::MessageBoxButtonTypes::OKButtonType,
+					 ac::MessageBoxIconTypes::CriticalIconType);
+	  return;
+	}
+	ui->messageBox("Watch mode is on. Bodies of the last STL export are exported again a few seconds after they change.",
+				   "STL Watch Mode");
+  }
+};
+
+class OnWatchCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandCreatedEventArgs> &eventArgs) override {
+	if (!eventArgs)
+	  return;
+	auto command = eventArgs->command();
+	if (!command)
+	  return;
+	auto onexec = command->execute();
+	if (!onexec)
+	  return;
+	onexec->add(&m_executeHandler);
+  }
+ private:
+  OnWatchExecuteEventHandler m_executeHandler;
+} watchCommandCreatedHandler;
+
+class OnHistoryExecuteEventHandler : public ac::CommandEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandEventArgs> &eventArgs) override {
+	auto app = ac::Application::get();
+	if (!app)
+	  return;
+	auto ui = app->userInterface();
+	if (!ui)
+	  return;
+	ExportHistory history;
+	if (!history.Load() || history.Records().empty()) {
+	  ui->messageBox("No exports have been recorded yet.", "STL Export History");
+	  return;
+	}
+	RegressionOptions options;
+	bool cancelled = false;
+	const std::string threshold = ui->inputBox("Flag exports slower than similar earlier ones by more than (%):",
+											   cancelled, "STL Export History", "20");
+	if (cancelled)
+	  return;
+	const double percent = std::atof(threshold.c_str());
+	if (percent > 0.0)
+	  options.slowdownPercent = percent;
+	ui->messageBox(FormatHistoryReport(history, options), "STL Export History");
   }
+};
 
+class OnHistoryCommandCreatedEventHandler : public ac::CommandCreatedEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CommandCreatedEventArgs> &eventArgs) override {
+	if (!eventArgs)
+	  return;
+	auto command = eventArgs->command();
+	if (!command)
+	  return;
+	auto onexec = command->execute();
+	if (!onexec)
+	  return;
+	onexec->add(&m_executeHandler);
+  }
+ private:
+  OnHistoryExecuteEventHandler m_executeHandler;
+} historyCommandCreatedHandler;
+
+static bool AddCommand(ac::Ptr<ac::UserInterface> ui,
+					   ac::Ptr<ac::ToolbarPanel> panel,
+					   const char *id,
+					   const char *name,
+					   const char *description,
+					   ac::CommandCreatedEventHandler *handler) {
   auto cmdDefs = ui->commandDefinitions();
   if (!cmdDefs)
 	return false;
 
-  auto cmdDef = cmdDefs->itemById(kCommandId);
+  auto cmdDef = cmdDefs->itemById(id);
   if (!cmdDef) {
 	// TODO: Icon
-	cmdDef = cmdDefs->addButtonDefinition(kCommandId, kCommandName, kCommandDescription);
+	cmdDef = cmdDefs->addButtonDefinition(id, name, description);
 	if (!cmdDef) {
 	  ui->messageBox("Failed to create command definition",
 					 "Error",
@@ -510,7 +855,7 @@ bool CreatePanel(adsk::core::Ptr<adsk::core::UserInterface> ui) {
 	}
   }
   auto commandCreated = cmdDef->commandCreated();
-  if (!commandCreated || !commandCreated->add(&commandCreatedHandler))
+  if (!commandCreated || !commandCreated->add(handler))
 	return false;
 
   ac::Ptr<ac::ToolbarControl> panelControl = panel->controls()->addCommand(cmdDef);
@@ -518,21 +863,59 @@ bool CreatePanel(adsk::core::Ptr<adsk::core::UserInterface> ui) {
 	return false;
 
   panelControl->isVisible(true);
-
   return true;
 }
+
+bool CreatePanel(adsk::core::Ptr<adsk::core::UserInterface> ui) {
+  auto ws = ui->workspaces();
+  if (!ws)
+	return false;
+
+  auto env = ws->itemById("FusionSolidEnvironment");
+  if (!env)
+	return false;
+
+  if (!env->toolbarPanels())
+	return false;
+
+
+  auto panel = env->toolbarPanels()->itemById(kPanelName);
+  if (!panel || !panel->controls())
+	return false;
+
+  if (panel->controls()->itemById(kCommandId)) {
+	ui->messageBox("Panel already exists",
+				   "Warning",
+				   ac::MessageBoxButtonTypes::OKButtonType,
+				   ac::MessageBoxIconTypes::CriticalIconType);
+	adsk::terminate();
+	return true;
+  }
+
+  return AddCommand(ui, panel, kCommandId, kCommandName, kCommandDescription, &commandCreatedHandler)
+	  && AddCommand(ui, panel, kReexportCommandId, kReexportCommandName, kReexportCommandDescription,
+					&reexportCommandCreatedHandler)
+	  && AddCommand(ui, panel, kRunPresetsCommandId, kRunPresetsCommandName, kRunPresetsCommandDescription,
+					&runPresetsCommandCreatedHandler)
+	  && AddCommand(ui, panel, kWatchCommandId, kWatchCommandName, kWatchCommandDescription, &watchCommandCreatedHandler)
+	  && AddCommand(ui, panel, kHistoryCommandId, kHistoryCommandName, kHistoryCommandDescription,
+					&historyCommandCreatedHandler);
+}
 bool DestroyPanel(adsk::core::Ptr<adsk::core::UserInterface> ui) {
 
+  StopWatching();
   if (!ui)
 	return true;
 
-  if (ui->commandDefinitions() && ui->commandDefinitions()->itemById(kCommandId)) {
-	ui->commandDefinitions()->itemById(kCommandId)->deleteMe();
-  }
-  if (ui->allToolbarPanels()) {
-	auto panel = ui->allToolbarPanels()->itemById(kPanelName);
-	if (panel && panel->controls() && panel->controls()->itemById(kCommandId))
-	  panel->controls()->itemById(kCommandId)->deleteMe();
+  for (const char *id : {kCommandId, kReexportCommandId, kRunPresetsCommandId, kWatchCommandId, kHistoryCommandId}) {
+	if (ui->commandDefinitions() && ui->commandDefinitions()->itemById(id)) {
+	  ui->commandDefinitions()->itemById(id)->deleteMe();
+	}
+	if (ui->allToolbarPanels()) {
+	  auto panel = ui->allToolbarPanels()->itemById(kPanelName);
+	  if (panel && panel->controls() && panel->controls()->itemById(id))
+		panel->controls()->itemById(id)->deleteMe();
+	}
   }
   return true;
 }
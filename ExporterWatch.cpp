@@ -0,0 +1,274 @@
+#include "ExporterWatch.h"
+#include "ExporterHash.h"
+#include "ExporterParameters.h"
+#include "ExporterPipeline.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+const char *const kWatchEventId{"STLExporterWatchEventId"};
+const char *const kOwnCommandPrefix{"STLExporter"};
+constexpr auto kQuietPeriod = std::chrono::milliseconds(2000);
+
+// Stand-in for the tessellated geometry that needs no tessellation: every vertex position, plus
+// the surface type, area and an interior point of every face and the curve type and length of
+// every edge. Faces without vertices, like a whole sphere, are still placed by their interior
+// point. The names go in too because they decide the output file name.
+uint64_t Fingerprint(const ac::Ptr<af::BRepBody> &body) {
+  StreamHash hash;
+  auto addNumber = [&hash](double value) { hash.Update(&value, sizeof(value)); };
+  auto addPoint = [&addNumber](const ac::Ptr<ac::Point3D> &point) {
+	if (!point)
+	  return;
+	addNumber(point->x());
+	addNumber(point->y());
+	addNumber(point->z());
+  };
+  auto addText = [&hash](const std::string &text) { hash.Update(text.data(), text.size() + 1); };
+  addText(body->name());
+  auto component = body->parentComponent();
+  addText(component ? component->name() : std::string());
+  if (auto vertices = body->vertices()) {
+	addNumber(static_cast<double>(vertices->count()));
+	for (size_t i = 0; i < vertices->count(); ++i) {
+	  auto vertex = vertices->item(i);
+	  addPoint(vertex ? vertex->geometry() : nullptr);
+	}
+  }
+  if (auto faces = body->faces()) {
+	addNumber(static_cast<double>(faces->count()));
+	for (size_t i = 0; i < faces->count(); ++i) {
+	  auto face = faces->item(i);
+	  if (!face)
+		continue;
+	  auto surface = face->geometry();
+	  addNumber(surface ? static_cast<double>(surface->surfaceType()) : -1.0);
+	  addNumber(face->area());
+	  addPoint(face->pointOnFace());
+	}
+  }
+  if (auto edges = body->edges()) {
+	addNumber(static_cast<double>(edges->count()));
+	for (size_t i = 0; i < edges->count(); ++i) {
+	  auto edge = edges->item(i);
+	  if (!edge)
+		continue;
+	  auto curve = edge->geometry();
+	  addNumber(curve ? static_cast<double>(curve->curveType()) : -1.0);
+	  addNumber(edge->length());
+	}
+  }
+  return hash.Value();
+}
+
+// Fires the custom event once triggers have stopped arriving for kQuietPeriod. Fusion delivers
+// custom events on the main thread, which is the only thread allowed to touch the API.
+class Debouncer {
+ public:
+  void Start(const ac::Ptr<ac::Application> &app) {
+	m_app = app;
+	m_stopping = false;
+	m_armed = false;
+	m_thread = std::thread([this] { Run(); });
+  }
+
+  void Stop() {
+	{
+	  std::lock_guard<std::mutex> lock(m_mutex);
+	  m_stopping = true;
+	}
+	m_wake.notify_one();
+	if (m_thread.joinable())
+	  m_thread.join();
+	m_app = nullptr;
+  }
+
+  void Trigger() {
+	{
+	  std::lock_guard<std::mutex> lock(m_mutex);
+	  m_armed = true;
+	  m_deadline = std::chrono::steady_clock::now() + kQuietPeriod;
+	}
+	m_wake.notify_one();
+  }
+
+ private:
+  void Run() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopping) {
+	  if (!m_armed) {
+		m_wake.wait(lock);
+		continue;
+	  }
+	  // a trigger that arrives meanwhile moves the deadline, so wait again until it holds
+	  if (m_wake.wait_until(lock, m_deadline) == std::cv_status::no_timeout
+		  || std::chrono::steady_clock::now() < m_deadline)
+		continue;
+	  m_armed = false;
+	  lock.unlock();
+	  m_app->fireCustomEvent(kWatchEventId);
+	  lock.lock();
+	}
+  }
+
+  ac::Ptr<ac::Application> m_app;
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::chrono::steady_clock::time_point m_deadline;
+  bool m_armed{false};
+  bool m_stopping{false};
+};
+
+// Main-thread state: the fingerprints of what was exported last, per body token.
+class Watcher {
+ public:
+  // Takes the current state as the baseline, so only later edits cause exports.
+  void Reset() {
+	m_fingerprints.clear();
+	m_settings.clear();
+	m_document.clear();
+	Update(false);
+  }
+
+  // Exports the bodies whose fingerprint differs from the last export.
+  void Update(bool exportChanges) {
+	auto app = ac::Application::get();
+	if (!app)
+	  return;
+	auto ui = app->userInterface();
+	ac::Ptr<af::Design> design = app->activeProduct();
+	auto document = app->activeDocument();
+	if (!ui || !design || !document)
+	  return;
+
+	ExporterParameters params;
+	if (!params.LoadFromAttributes(design->attributes()))
+	  return;
+	if (!params.useRules)
+	  params.ResolveBodies(design);
+	params.ApplyRules(design);
+	if (!params.Validate())
+	  return;
+
+	// Other documents and new settings start from a fresh baseline: the export that saved the
+	// settings already wrote every file.
+	SettingsBlob blob;
+	params.WriteSettings(blob);
+	const std::string settings = blob.Serialize();
+	if (document->name() != m_document || settings != m_settings) {
+	  m_document = document->name();
+	  m_settings = settings;
+	  m_fingerprints.clear();
+	  exportChanges = false;
+	}
+
+	std::unordered_map<std::string, uint64_t> current;
+	std::vector<ac::Ptr<af::BRepBody>> changed;
+	for (auto &&body : params.bodies) {
+	  const std::string token = body->entityToken();
+	  const uint64_t fingerprint = Fingerprint(body);
+	  current[token] = fingerprint;
+	  auto previous = m_fingerprints.find(token);
+	  if (previous == m_fingerprints.end() || previous->second != fingerprint)
+		changed.push_back(body);
+	}
+	if (exportChanges && !changed.empty()) {
+	  // Plates and merged files mix several bodies in one file, so any change writes the whole set
+	  // again.
+	  if (!params.arrangeOnPlates && !params.mergeBodies)
+		params.bodies = std::move(changed);
+	  params.overwriteExistingFiles = true;
+	  if (!RunExport(params, design, ui))
+		return; // keep the old fingerprints so the next trigger tries again
+	}
+	m_fingerprints.swap(current);
+  }
+
+ private:
+  std::unordered_map<std::string, uint64_t> m_fingerprints;
+  std::string m_settings;
+  std::string m_document;
+};
+
+Debouncer debouncer;
+Watcher watcher;
+bool watching{false};
+
+class OnWatchEventHandler : public ac::CustomEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::CustomEventArgs> &eventArgs) override {
+	if (watching)
+	  watcher.Update(true);
+  }
+} watchEventHandler;
+
+class OnDocumentSavedEventHandler : public ac::DocumentEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::DocumentEventArgs> &eventArgs) override {
+	debouncer.Trigger();
+  }
+} documentSavedHandler;
+
+class OnCommandTerminatedEventHandler : public ac::ApplicationCommandEventHandler {
+ public:
+  void notify(const ac::Ptr<ac::ApplicationCommandEventArgs> &eventArgs) override {
+	if (!eventArgs || eventArgs->terminationReason() != ac::CompletedTerminationReason)
+	  return;
+	// our own commands do not edit geometry, and an export must not schedule another one
+	const std::string id = eventArgs->commandId();
+	if (id.compare(0, std::char_traits<char>::length(kOwnCommandPrefix), kOwnCommandPrefix) == 0)
+	  return;
+	debouncer.Trigger();
+  }
+} commandTerminatedHandler;
+}
+
+bool StartWatching(const ac::Ptr<ac::Application> &app) {
+  if (watching)
+	return true;
+  if (!app || !app->userInterface())
+	return false;
+  auto customEvent = app->registerCustomEvent(kWatchEventId);
+  if (!customEvent || !customEvent->add(&watchEventHandler))
+	return false;
+  auto documentSaved = app->documentSaved();
+  auto commandTerminated = app->userInterface()->commandTerminated();
+  if (!documentSaved || !documentSaved->add(&documentSavedHandler) || !commandTerminated
+	  || !commandTerminated->add(&commandTerminatedHandler)) {
+	if (documentSaved)
+	  documentSaved->remove(&documentSavedHandler);
+	app->unregisterCustomEvent(kWatchEventId);
+	return false;
+  }
+  watcher.Reset();
+  debouncer.Start(app);
+  watching = true;
+  return true;
+}
+
+void StopWatching() {
+  if (!watching)
+	return;
+  watching = false;
+  debouncer.Stop();
+  auto app = ac::Application::get();
+  if (!app)
+	return;
+  auto documentSaved = app->documentSaved();
+  if (documentSaved)
+	documentSaved->remove(&documentSavedHandler);
+  auto ui = app->userInterface();
+  auto commandTerminated = ui ? ui->commandTerminated() : nullptr;
+  if (commandTerminated)
+	commandTerminated->remove(&commandTerminatedHandler);
+  app->unregisterCustomEvent(kWatchEventId);
+}
+
+bool IsWatching() {
+  return watching;
+}
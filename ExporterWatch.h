@@ -0,0 +1,15 @@
+#ifndef STLHELPER__EXPORTERWATCH_H_
+#define STLHELPER__EXPORTERWATCH_H_
+#pragma once
+
+#include <Core/CoreAll.h>
+
+// Watch mode keeps the files of the last export current while the design is edited. Saving the
+// document or finishing a modelling command arms a short timer; once edits have been quiet for
+// that long, every body of the saved export set whose geometry fingerprint changed is exported
+// again with the saved settings. Bodies that did not change are left alone.
+bool StartWatching(const adsk::core::Ptr<adsk::core::Application> &app);
+void StopWatching();
+bool IsWatching();
+
+#endif //STLHELPER__EXPORTERWATCH_H_
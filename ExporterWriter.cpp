@@ -0,0 +1,62 @@
+#include "ExporterWriter.h"
+
+WriterPool::WriterPool(size_t threads) : m_capacity(2 * std::max<size_t>(threads, 1)) {
+  threads = std::max<size_t>(threads, 1);
+  m_threads.reserve(threads);
+  for (size_t t = 0; t < threads; ++t)
+	m_threads.emplace_back(&WriterPool::Run, this);
+}
+
+WriterPool::~WriterPool() {
+  {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stopping = true;
+  }
+  m_queued.notify_all();
+  for (auto &t : m_threads)
+	t.join();
+}
+
+void WriterPool::Submit(Job job, std::string name) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_taken.wait(lock, [this] { return m_jobs.size() < m_capacity; });
+  m_jobs.emplace_back(std::move(job), std::move(name));
+  lock.unlock();
+  m_queued.notify_one();
+}
+
+std::vector<std::string> WriterPool::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return m_jobs.empty() && m_running == 0; });
+  std::vector<std::string> failed;
+  failed.swap(m_failed);
+  return failed;
+}
+
+void WriterPool::Run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+	m_queued.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+	if (m_jobs.empty())
+	  return;
+	auto job = std::move(m_jobs.front());
+	m_jobs.pop_front();
+	++m_running;
+	lock.unlock();
+	m_taken.notify_one();
+
+	bool succeeded = false;
+	try {
+	  succeeded = job.first();
+	} catch (...) {
+	  succeeded = false;
+	}
+
+	lock.lock();
+	--m_running;
+	if (!succeeded)
+	  m_failed.push_back(std::move(job.second));
+	if (m_jobs.empty() && m_running == 0)
+	  m_idle.notify_all();
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef STLHELPER__EXPORTERWRITER_H_
+#define STLHELPER__EXPORTERWRITER_H_
+#pragma once
+
+#include "ExporterParallel.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background threads that write finished meshes while the main thread keeps talking to Fusion.
+// The queue is bounded, so a slow disk holds the producer back instead of letting meshes pile up in
+// memory. Jobs must not touch the Fusion API.
+class WriterPool {
+ public:
+  using Job = std::function<bool()>;
+
+  explicit WriterPool(size_t threads = WorkerCount());
+  ~WriterPool();
+  WriterPool(const WriterPool &) = delete;
+  WriterPool &operator=(const WriterPool &) = delete;
+
+  // Queues `job`; `name` is reported by Wait() if the job returns false or throws.
+  void Submit(Job job, std::string name);
+
+  // Blocks until every submitted job has finished and returns the names of the failed ones.
+  std::vector<std::string> Wait();
+
+ private:
+  void Run();
+
+  std::mutex m_mutex;
+  std::condition_variable m_queued;
+  std::condition_variable m_taken;
+  std::condition_variable m_idle;
+  std::deque<std::pair<Job, std::string>> m_jobs;
+  std::vector<std::string> m_failed;
+  std::vector<std::thread> m_threads;
+  size_t m_capacity;
+  size_t m_running{0};
+  bool m_stopping{false};
+};
+
+#endif //STLHELPER__EXPORTERWRITER_H_
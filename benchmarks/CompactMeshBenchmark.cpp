@@ -0,0 +1,87 @@
+// Encodes STL files in the compact mesh format and reports size and speed:
+//   CompactMeshBenchmark [--bits N] file.stl...
+// Throughput is measured against the size of the same mesh as binary STL. Each file is also
+// decoded with its last bytes cut off, which must fail.
+
+#include "ExporterCompact.h"
+#include "ExporterSTLReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr size_t kTruncationChecks = 16;
+
+double Seconds(Clock::time_point begin, Clock::time_point end) {
+  return std::chrono::duration<double>(end - begin).count();
+}
+}
+
+int main(int argc, char **argv) {
+  int bits = kDefaultCompactBits;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+	if (std::strcmp(argv[i], "--bits") == 0 && i + 1 < argc)
+	  bits = std::atoi(argv[++i]);
+	else
+	  files.emplace_back(argv[i]);
+  }
+  if (files.empty()) {
+	std::fprintf(stderr, "usage: %s [--bits %d-%d] file.stl...\n", argv[0], kMinCompactBits, kMaxCompactBits);
+	return 2;
+  }
+
+  std::printf("%-32s %10s %12s %10s %8s %10s %10s %12s\n",
+			  "file", "triangles", "bytes", "bits/tri", "ratio", "enc MB/s", "dec MB/s", "max error");
+  int failures = 0;
+  for (auto &&file : files) {
+	Mesh mesh;
+	if (!ReadSTL(file, mesh)) {
+	  std::fprintf(stderr, "%s: not a readable STL file\n", file.c_str());
+	  ++failures;
+	  continue;
+	}
+	// STL coordinates are already in their final units
+	std::vector<uint8_t> encoded;
+	const auto start = Clock::now();
+	const bool encodedOk = EncodeCompactMesh(mesh, 1.0f, bits, encoded);
+	const auto encodedAt = Clock::now();
+	Mesh decoded;
+	const bool decodedOk = encodedOk && DecodeCompactMesh(encoded.data(), encoded.size(), decoded);
+	const auto decodedAt = Clock::now();
+	if (!decodedOk || decoded.TriangleCount() != mesh.TriangleCount()) {
+	  std::fprintf(stderr, "%s: round trip failed\n", file.c_str());
+	  ++failures;
+	  continue;
+	}
+	// every byte is needed, so a file cut short must never decode
+	for (size_t cut = 1; cut <= kTruncationChecks && cut < encoded.size(); ++cut) {
+	  Mesh truncated;
+	  if (DecodeCompactMesh(encoded.data(), encoded.size() - cut, truncated)) {
+		std::fprintf(stderr, "%s: decoded with %zu bytes cut off\n", file.c_str(), cut);
+		++failures;
+		break;
+	  }
+	}
+
+	const double stlBytes = 84.0 + 50.0 * static_cast<double>(mesh.TriangleCount());
+	const Vec3 size = mesh.Bounds().Size();
+	const double maxError = std::max(size[0], std::max(size[1], size[2])) / (2.0 * ((1 << bits) - 1));
+	std::printf("%-32s %10zu %12zu %10.2f %8.1f %10.1f %10.1f %12.6g\n",
+				std::filesystem::path(file).filename().string().c_str(),
+				mesh.TriangleCount(),
+				encoded.size(),
+				8.0 * static_cast<double>(encoded.size()) / std::max<size_t>(1, mesh.TriangleCount()),
+				stlBytes / static_cast<double>(encoded.size()),
+				stlBytes / 1e6 / Seconds(start, encodedAt),
+				stlBytes / 1e6 / Seconds(encodedAt, decodedAt),
+				maxError);
+  }
+  return failures == 0 ? 0 : 1;
+}